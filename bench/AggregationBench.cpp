@@ -0,0 +1,96 @@
+/*
+ * Description: Aggregation benchmark - std::map path of the library shufflers/reducers vs TokenCountTable
+ *
+ * Usage: AggregationBench [tokens] [vocabulary] [rounds]
+ */
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "../headers/TokenCountTable.hpp"
+
+// Builds a word-count style token stream - Zipf distributed over a large synthetic vocabulary
+std::vector<std::string> createTokens(std::size_t tokens, std::size_t vocabulary){
+    std::vector<std::string> words;
+    words.reserve(vocabulary);
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(3, 12);
+    for(std::size_t i = 0; i < vocabulary; i++){
+        std::string word;
+        for(int c = length(generator); c > 0; c--){
+            word += static_cast<char>(letter(generator));
+        }
+        words.push_back(word + std::to_string(i));
+    }
+    // cumulative Zipf (s = 1) weights
+    std::vector<double> cumulative(vocabulary);
+    double total = 0;
+    for(std::size_t i = 0; i < vocabulary; i++){
+        total += 1.0 / static_cast<double>(i + 1);
+        cumulative[i] = total;
+    }
+    std::uniform_real_distribution<double> pick(0, total);
+    std::vector<std::string> stream;
+    stream.reserve(tokens);
+    for(std::size_t i = 0; i < tokens; i++){
+        std::size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), pick(generator)) - cumulative.begin();
+        stream.push_back(words[std::min(rank, vocabulary - 1)]);
+    }
+    return stream;
+}
+
+template<typename F>
+double bestOf(unsigned rounds, F run){
+    double best = 0;
+    for(unsigned round = 0; round < rounds; round++){
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = round == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t tokens = argc > 1 ? std::stoull(argv[1]) : 5000000;
+    std::size_t vocabulary = argc > 2 ? std::stoull(argv[2]) : 1000000;
+    unsigned rounds = argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 3;
+    std::vector<std::string> stream = createTokens(tokens, vocabulary);
+
+    // both paths end with the sorted (token, count) lines written out
+    std::size_t mapBytes = 0;
+    double mapSeconds = bestOf(rounds, [&]{
+        std::map<std::string, std::size_t> counts;
+        for(const std::string &token: stream){
+            counts[token] += 1;
+        }
+        std::string buffer;
+        for(const auto &entry: counts){
+            buffer += '(' + entry.first + ',' + std::to_string(entry.second) + ")\n";
+        }
+        mapBytes = buffer.size();
+    });
+    std::size_t tableBytes = 0;
+    std::size_t distinct = 0;
+    double tableSeconds = bestOf(rounds, [&]{
+        TokenCountTable table;
+        for(const std::string &token: stream){
+            table.add(token);
+        }
+        std::string buffer;
+        table.appendSortedLines(buffer);
+        tableBytes = buffer.size();
+        distinct = table.size();
+    });
+    if(mapBytes != tableBytes){
+        std::cerr << "Outputs differ!" << std::endl;
+        return 1;
+    }
+
+    std::cout << "engine,tokens,distinct,seconds,mtokens_per_second" << std::endl;
+    std::cout << "std::map," << tokens << "," << distinct << "," << mapSeconds << "," << tokens / mapSeconds / 1e6 << std::endl;
+    std::cout << "TokenCountTable," << tokens << "," << distinct << "," << tableSeconds << "," << tokens / tableSeconds / 1e6 << std::endl;
+    std::cout << "speedup," << mapSeconds / tableSeconds << std::endl;
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Description: Synthetic corpus generator - writes a reproducible word-count input directory with a given number of
+ * files, bytes per file, vocabulary size and Zipf skew
+ *
+ * Usage: CorpusGenerator <output_directory> [files] [bytes_per_file] [vocabulary] [zipf_exponent] [seed]
+ */
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Word of a vocabulary rank - the rank in bijective base 26 followed by three letters derived from it, so every rank
+// has its own word and frequent words are short, as in natural text
+std::string createWord(std::uint64_t rank){
+    std::string word;
+    for(std::uint64_t value = rank + 1; value > 0; value = (value - 1) / 26){
+        word += static_cast<char>('a' + (value - 1) % 26);
+    }
+    // splitmix64
+    std::uint64_t state = rank + 0x9E3779B97F4A7C15ULL;
+    state = (state ^ (state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    state = (state ^ (state >> 27)) * 0x94D049BB133111EBULL;
+    state ^= state >> 31;
+    for(int letter = 0; letter < 3; letter++){
+        word += static_cast<char>('a' + state % 26);
+        state /= 26;
+    }
+    return word;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        std::cerr << "Usage: CorpusGenerator <output_directory> [files] [bytes_per_file] [vocabulary] [zipf_exponent] [seed]" << std::endl;
+        return 1;
+    }
+    std::filesystem::path directory(argv[1]);
+    std::size_t files = argc > 2 ? std::stoull(argv[2]) : 8;
+    std::size_t fileBytes = argc > 3 ? std::stoull(argv[3]) : 4 << 20;
+    std::size_t vocabulary = argc > 4 ? std::stoull(argv[4]) : 100000;
+    double exponent = argc > 5 ? std::stod(argv[5]) : 1.0;
+    std::uint64_t seed = argc > 6 ? std::stoull(argv[6]) : 42;
+    if(files == 0 || vocabulary == 0 || exponent < 0){
+        std::cerr << "files and vocabulary must be positive, the Zipf exponent must not be negative" << std::endl;
+        return 1;
+    }
+
+    // cumulative Zipf weights - rank r is drawn with probability proportional to 1 / (r + 1)^s
+    std::vector<double> cumulative(vocabulary);
+    double total = 0;
+    for(std::size_t i = 0; i < vocabulary; i++){
+        total += std::pow(static_cast<double>(i + 1), -exponent);
+        cumulative[i] = total;
+    }
+    std::vector<std::string> words(vocabulary);
+    for(std::size_t i = 0; i < vocabulary; i++){
+        words[i] = createWord(i);
+    }
+
+    // regenerating a corpus replaces it - only the generated files and the job's outputs are removed
+    std::filesystem::create_directories(directory);
+    for(const auto &entry: std::filesystem::directory_iterator(directory)){
+        std::string name = entry.path().filename().string();
+        if(name == "temp_mapper" || name == "temp_shuffler" || name == "final_output" ||
+           (name.rfind("part-", 0) == 0 && entry.path().extension() == ".txt")){
+            std::filesystem::remove_all(entry.path());
+        }
+    }
+    std::mt19937_64 generator(seed);
+    std::uniform_real_distribution<double> pick(0, total);
+    std::uniform_int_distribution<int> lineWords(6, 18);
+    std::uniform_int_distribution<int> decoration(0, 15);
+    std::uniform_int_distribution<int> paragraph(0, 15);
+    static const char punctuation[] = {',', '.', ';', '!', '?', ':'};
+    std::size_t totalWords = 0;
+    for(std::size_t f = 0; f < files; f++){
+        std::string text;
+        text.reserve(fileBytes + 256);
+        while(text.size() < fileBytes){
+            for(int w = lineWords(generator); w > 0; w--){
+                std::size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), pick(generator)) - cumulative.begin();
+                std::string word = words[std::min(rank, vocabulary - 1)];
+                // some capitals and punctuation, which the mappers fold and drop
+                int style = decoration(generator);
+                if(style == 0){
+                    word[0] = static_cast<char>(word[0] - 'a' + 'A');
+                } else if(style == 1){
+                    word += punctuation[generator() % sizeof(punctuation)];
+                }
+                text += word;
+                text += ' ';
+                totalWords++;
+            }
+            text.back() = '\n';
+            // blank lines between paragraphs - records without a token, wherever the map tasks are cut
+            if(paragraph(generator) == 0){
+                text += '\n';
+            }
+        }
+        std::string fileName = "part-" + std::to_string(f) + ".txt";
+        std::ofstream output(directory / fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+        output.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if(!output){
+            std::cerr << "Cannot write " << (directory / fileName).string() << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "directory,files,bytes_per_file,vocabulary,zipf_exponent,seed,words" << std::endl;
+    std::cout << directory.string() << "," << files << "," << fileBytes << "," << vocabulary << ","
+              << exponent << "," << seed << "," << totalWords << std::endl;
+    return 0;
+}
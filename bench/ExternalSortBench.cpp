@@ -0,0 +1,124 @@
+/*
+ * Description: External sort benchmark - sorts and counts a token stream several times larger than the sort budget
+ * through sorted runs and k-way merges, then checks the result and the peak RSS against the budget
+ *
+ * Usage: ExternalSortBench [budget bytes] [input multiple of the budget] [text|binary]
+ */
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include "../headers/ExternalSort.hpp"
+#include "../headers/JobMetrics.hpp"
+
+// Word of a vocabulary rank - derived from the rank, so no vocabulary is ever held in memory
+std::string createWord(std::uint64_t rank){
+    // splitmix64
+    std::uint64_t state = rank + 0x9E3779B97F4A7C15ULL;
+    state = (state ^ (state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    state = (state ^ (state >> 27)) * 0x94D049BB133111EBULL;
+    state ^= state >> 31;
+    std::string word;
+    for(std::uint64_t letters = 3 + state % 8; letters > 0; letters--){
+        state /= 26;
+        word += static_cast<char>('a' + state % 26);
+    }
+    return word + std::to_string(rank);
+}
+
+int main(int argc, char* argv[]){
+    std::size_t budget = argc > 1 ? std::stoull(argv[1]) : 4 << 20;
+    std::size_t multiple = argc > 2 ? std::stoull(argv[2]) : 8;
+    SpillFormat format = argc > 3 ? parseSpillFormat(argv[3]) : SpillFormat::Text;
+    // below this a run holds a handful of entries, and the paths of the runs alone outgrow the budget
+    if(budget < 4 * RUN_BUFFER_BYTES){
+        std::cerr << "The budget must be at least " << 4 * RUN_BUFFER_BYTES << " bytes" << std::endl;
+        return 1;
+    }
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "ExternalSortBench";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    long baselineKilobytes = JobMetrics::getPeakRssKilobytes();
+
+    // map side - log-uniform ranks (Zipf, s = 1) over a vocabulary far larger than the budget; the table is cut into
+    // a sorted run before its peak (growing, sorting and writing it) would exceed the budget
+    constexpr std::uint64_t vocabulary = 1ULL << 24;
+    constexpr std::uint64_t sampleRank = 1000;
+    std::string sampleWord = createWord(sampleRank);
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<double> exponent(0, std::log(static_cast<double>(vocabulary)));
+    std::size_t inputBytes = 0;
+    std::size_t tokens = 0;
+    std::size_t sampleCount = 0;
+    std::vector<std::string> runs;
+    TokenCountTable table;
+    auto writeRun = [&]{
+        runs.push_back((directory / ("run." + std::to_string(runs.size()))).string());
+        RunWriter writer(runs.back(), format);
+        for(const auto &entry: table.sortedEntries()){
+            writer.add(entry.first, entry.second);
+        }
+        writer.finish();
+        table = TokenCountTable();
+    };
+    auto start = std::chrono::steady_clock::now();
+    while(inputBytes < budget * multiple){
+        auto rank = static_cast<std::uint64_t>(std::exp(exponent(generator))) - 1;
+        std::string word = createWord(rank);
+        inputBytes += word.size() + 1;
+        tokens++;
+        sampleCount += rank == sampleRank;
+        table.add(word);
+        if(runTablePeakBytes(table) > budget){
+            writeRun();
+        }
+    }
+    writeRun();
+    double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // merge side - passes of at most mergeFanIn(budget) runs, then one last merge
+    start = std::chrono::steady_clock::now();
+    std::size_t passes = 0;
+    while(runs.size() > mergeFanIn(budget)){
+        runs = mergeRunPass(runs, (directory / ("pass" + std::to_string(passes) + ".")).string(), format, budget, true);
+        passes++;
+    }
+    std::string output = (directory / "output").string();
+    mergeSortedRuns(runs, output, SpillFormat::Text, budget);
+    double mergeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long peakKilobytes = JobMetrics::getPeakRssKilobytes();
+
+    // the output must be strictly ascending and account for every token
+    RunReader reader(output);
+    std::string previous;
+    std::size_t total = 0;
+    std::size_t distinct = 0;
+    std::size_t sampleOutput = 0;
+    bool ordered = true;
+    while(reader.next()){
+        ordered = ordered && (distinct == 0 || previous < reader.getToken());
+        previous = reader.getToken();
+        total += reader.getCount();
+        distinct++;
+        if(reader.getToken() == sampleWord){
+            sampleOutput = reader.getCount();
+        }
+    }
+    std::filesystem::remove_all(directory);
+
+    std::cout << "budget_bytes,input_bytes,tokens,distinct,merge_passes,run_seconds,merge_seconds,peak_rss_kb,baseline_rss_kb" << std::endl;
+    std::cout << budget << "," << inputBytes << "," << tokens << "," << distinct << "," << passes + 1 << ","
+              << runSeconds << "," << mergeSeconds << "," << peakKilobytes << "," << baselineKilobytes << std::endl;
+    if(!ordered || total != tokens || sampleOutput != sampleCount){
+        std::cerr << "Merged output differs from the input!" << std::endl;
+        return 1;
+    }
+    // cutting runs (runTablePeakBytes) and merging them (mergeFanIn, mergeSortedRuns) are both accounted against the
+    // budget - the process must stay within it above its baseline
+    if(static_cast<std::size_t>(std::max(peakKilobytes - baselineKilobytes, 0L)) * 1024 > budget){
+        std::cerr << "Peak RSS is not bounded by the budget!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Description: Mapper scaling benchmark - runs the same batch of MapperImpl tasks on 1..N executor workers
+ *
+ * Usage: MapperScalingBench [max_workers] [partitions] [mapper_library]
+ */
+#include <chrono>
+#include <dlfcn.h>
+#include <iostream>
+#include <random>
+#include "../headers/MapperBase.hpp"
+#include "../headers/WorkStealingPool.hpp"
+
+// Builds one synthetic partition of ~2k records - the size FileProcessorInput produces
+std::vector<std::string> createPartition(unsigned seed){
+    static const std::vector<std::string> words = {
+            "the", "Map,", "reduce.", "shuffle!", "partition", "token", "Alpha", "beta's", "gamma-ray", "delta"};
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<std::size_t> pick(0, words.size() - 1);
+    std::vector<std::string> partition;
+    for(int line = 0; line < 2000; line++){
+        std::string record;
+        for(int word = 0; word < 12; word++){
+            record += words[pick(generator)];
+            record += ' ';
+        }
+        partition.push_back(record);
+    }
+    return partition;
+}
+
+int main(int argc, char* argv[]){
+    unsigned cores = std::thread::hardware_concurrency();
+    unsigned maxWorkers = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : (cores == 0 ? 1 : cores);
+    unsigned partitions = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 64;
+    std::string library = argc > 3 ? argv[3] : "./libs/map/MapperImpl.so";
+
+    void* handle = dlopen(library.c_str(), RTLD_LAZY);
+    if(!handle){
+        std::cerr << "Cannot load library: " << dlerror() << std::endl;
+        return 1;
+    }
+    auto* createMapper = (createMapper_t*)dlsym(handle, "createInputObj");
+    auto* destroyMapper = (destroyMapper_t*)dlsym(handle, "removeInputObj");
+    if(!createMapper || !destroyMapper){
+        std::cerr << "Cannot load factory symbols from " << library << std::endl;
+        return 1;
+    }
+
+    std::vector<std::map<std::string, std::vector<std::string>>> inputs;
+    for(unsigned i = 0; i < partitions; i++){
+        inputs.push_back({{"/bench/input.txt", createPartition(i)}});
+    }
+
+    // the mapper reports every partition on std::cout - keep it out of the measurement
+    std::streambuf* consoleBuffer = std::cout.rdbuf();
+    double baseline = 0;
+    std::cout << "workers,partitions,seconds,speedup,efficiency" << std::endl;
+    for(unsigned workers = 1; workers <= maxWorkers; workers++){
+        std::vector<MapperBase*> mappers;
+        for(unsigned i = 0; i < partitions; i++){
+            mappers.push_back(createMapper(static_cast<int>(i), inputs[i]));
+        }
+        std::cout.rdbuf(nullptr);
+        auto start = std::chrono::steady_clock::now();
+        {
+            WorkStealingPool pool(workers);
+            std::vector<std::future<std::size_t>> results;
+            for(MapperBase* mapper: mappers){
+                results.push_back(pool.submit(JobPhase::Map, [mapper]{
+                    mapper->runMapOperation();
+                    return mapper->getMapperOutput().size();
+                }));
+            }
+            for(auto &result: results){
+                result.get();
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout.rdbuf(consoleBuffer);
+        std::cout.clear();
+        if(workers == 1){
+            baseline = seconds;
+        }
+        std::cout << workers << "," << partitions << "," << seconds << ","
+                  << baseline / seconds << "," << baseline / seconds / workers << std::endl;
+        for(MapperBase* mapper: mappers){
+            destroyMapper(mapper);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Description: Output index benchmark - point lookups through the mapped index of a final_output file vs parsing it
+ *
+ * Usage: OutputIndexBench [tokens] [lookups] [directory]
+ */
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../headers/OutputIndex.hpp"
+
+// Builds a final_output-style file of distinct tokens - "(token,count)" lines in token order
+std::vector<std::string> createTokens(std::size_t tokens){
+    std::vector<std::string> words;
+    words.reserve(tokens);
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(2, 10);
+    for(std::size_t i = 0; i < tokens; i++){
+        std::string word;
+        for(int c = length(generator); c > 0; c--){
+            word += static_cast<char>(letter(generator));
+        }
+        words.push_back(word + std::to_string(i));
+    }
+    std::sort(words.begin(), words.end());
+    return words;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t tokens = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    std::size_t lookups = argc > 2 ? std::stoull(argv[2]) : 100000;
+    std::filesystem::path directory = argc > 3 ? argv[3] : std::filesystem::temp_directory_path() / "OutputIndexBench";
+    std::filesystem::create_directories(directory);
+    std::string outputFile = (directory / "output.txt").string();
+
+    std::vector<std::string> words = createTokens(tokens);
+    {
+        std::string output;
+        for(std::size_t i = 0; i < words.size(); i++){
+            output += '(' + words[i] + ',' + std::to_string(i % 1000 + 1) + ")\n";
+        }
+        std::ofstream stream(outputFile, std::ios::out | std::ios::trunc | std::ios::binary);
+        stream.write(output.data(), static_cast<std::streamsize>(output.size()));
+    }
+    auto start = std::chrono::steady_clock::now();
+    writeOutputIndex(outputFile);
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // the first query of a downstream service - parse the whole text file to answer it
+    std::mt19937_64 generator(7);
+    std::uniform_int_distribution<std::size_t> pick(0, words.size() - 1);
+    const std::string &probe = words[pick(generator)];
+    start = std::chrono::steady_clock::now();
+    TokenCountTable table;
+    aggregateTokenCountLines(readWholeFile(outputFile), table);
+    std::size_t parsedCount = table.getCount(probe);
+    double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    OutputIndex index(outputIndexPath(outputFile).string());
+    std::size_t indexedCount = index.find(probe)->count;
+    double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(indexedCount != parsedCount){
+        std::cerr << "Index and final output disagree on " << probe << std::endl;
+        return 1;
+    }
+
+    // warm lookups - every answer is checked against the generated counts
+    std::vector<std::size_t> positions(lookups);
+    for(std::size_t &position: positions){
+        position = pick(generator);
+    }
+    start = std::chrono::steady_clock::now();
+    for(std::size_t position: positions){
+        auto match = index.find(words[position]);
+        if(!match || match->count != position % 1000 + 1){
+            std::cerr << "Wrong lookup result for " << words[position] << std::endl;
+            return 1;
+        }
+    }
+    double lookupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Tokens: " << tokens << ", index built in " << buildSeconds * 1e3 << " ms" << std::endl;
+    std::cout << "First query by parsing final_output: " << parseSeconds * 1e3 << " ms" << std::endl;
+    std::cout << "First query through the index (open + lookup): " << openSeconds * 1e6 << " us" << std::endl;
+    std::cout << "Point lookups: " << lookups << " in " << lookupSeconds * 1e3 << " ms ("
+              << lookupSeconds * 1e6 / static_cast<double>(lookups) << " us each)" << std::endl;
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * Description: End-to-end benchmark - runs the MRExec job on a corpus (see CorpusGenerator) for every option set, then
+ * every plugin phase in isolation, and prints one JSON document with throughput, per-phase latency and peak RSS
+ *
+ * Usage: PipelineBench <corpus_directory> [rounds] [executable] [options]...
+ *   options - one argument per job configuration, e.g. "--pipeline --hash-aggregation"; "default" (or no option set
+ *             at all) runs the job without options
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "../headers/FileProcessorBase.hpp"
+#include "../headers/MapperBase.hpp"
+#include "../headers/ShufflerBase.hpp"
+#include "../headers/ReducerBase.hpp"
+#include "../headers/JobPhase.hpp"
+#include "../headers/TaskMetrics.hpp"
+#include "../headers/TaskSizing.hpp"
+
+// Sum over the tasks of one plugin phase
+struct PluginPhase{
+    double seconds = 0;
+    std::size_t tasks = 0;
+    // lines read by the input phase, entries produced (or written, by the output phases) by the other phases
+    std::uint64_t records = 0;
+};
+
+// Removes what a job leaves in the corpus directory
+void cleanOutputs(const std::filesystem::path &corpus){
+    for(const char* name: {"temp_mapper", "temp_shuffler", "final_output"}){
+        std::filesystem::remove_all(corpus / name);
+    }
+}
+
+// Helper - whole file as a string, without the trailing newline
+std::string readText(const std::filesystem::path &path){
+    std::ifstream input(path, std::ios::in | std::ios::binary);
+    std::stringstream text;
+    text << input.rdbuf();
+    std::string content = text.str();
+    while(!content.empty() && (content.back() == '\n' || content.back() == '\r')){
+        content.pop_back();
+    }
+    return content;
+}
+
+// Helper - JSON string literal
+std::string jsonString(const std::string &value){
+    std::string quoted = "\"";
+    for(char c: value){
+        if(c == '"' || c == '\\'){
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// Helper - single-quoted for /bin/sh
+std::string shellQuote(const std::string &value){
+    std::string quoted = "'";
+    for(char c: value){
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+}
+
+template<typename T>
+T* loadSymbol(const std::string &library, const char* symbol){
+    void* handle = dlopen(library.c_str(), RTLD_LAZY);
+    if(!handle){
+        throw std::runtime_error("Cannot load library: " + std::string(dlerror()));
+    }
+    auto* function = reinterpret_cast<T*>(dlsym(handle, symbol));
+    if(!function){
+        throw std::runtime_error("Cannot load " + std::string(symbol) + " from " + library);
+    }
+    return function;
+}
+
+// Times one task and charges it to its phase
+template<typename F>
+void timeTask(PluginPhase &phase, F task){
+    auto start = std::chrono::steady_clock::now();
+    phase.records += task();
+    phase.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    phase.tasks++;
+}
+
+// Runs the plugins of every phase on one thread, file by file - every phase is timed on its own, with nothing
+// overlapping it, and its output is handed to the next phase the way the staged workflow hands it over
+std::array<PluginPhase, JOB_PHASE_COUNT> runPlugins(const std::vector<std::string> &files){
+    auto* createInput = loadSymbol<create_t>("./libs/fp/FileProcessorInput.so", "createInputObj");
+    auto* destroyInput = loadSymbol<destroy_t>("./libs/fp/FileProcessorInput.so", "removeInputObj");
+    auto* createMapper = loadSymbol<createMapper_t>("./libs/map/MapperImpl.so", "createInputObj");
+    auto* destroyMapper = loadSymbol<destroyMapper_t>("./libs/map/MapperImpl.so", "removeInputObj");
+    auto* createMapOutput = loadSymbol<readMapperOp_t>("./libs/fp/FileProcessorMapOutput.so", "createInputObj");
+    auto* destroyMapOutput = loadSymbol<destroyMapperOp_t>("./libs/fp/FileProcessorMapOutput.so", "removeInputObj");
+    auto* createShuffler = loadSymbol<createShuffler_t>("./libs/shuffle/ShufflerImpl.so", "createInputObj");
+    auto* destroyShuffler = loadSymbol<destroyShuffler_t>("./libs/shuffle/ShufflerImpl.so", "removeInputObj");
+    auto* createShuffleOutput = loadSymbol<readShufflerOp_t>("./libs/fp/FileProcessorShufOutput.so", "createInputObj");
+    auto* destroyShuffleOutput = loadSymbol<destroyShufflerOp_t>("./libs/fp/FileProcessorShufOutput.so", "removeInputObj");
+    auto* createReducer = loadSymbol<createReducer_t>("./libs/reduce/ReducerImpl.so", "createInputObj");
+    auto* destroyReducer = loadSymbol<destroyReducer_t>("./libs/reduce/ReducerImpl.so", "removeInputObj");
+    auto* createReduceOutput = loadSymbol<readReducerOp_t>("./libs/fp/FileProcessorRedOutput.so", "createInputObj");
+    auto* destroyReduceOutput = loadSymbol<destroyReducerOp_t>("./libs/fp/FileProcessorRedOutput.so", "removeInputObj");
+
+    std::array<PluginPhase, JOB_PHASE_COUNT> phases{};
+    auto phase = [&phases](JobPhase job_phase) -> PluginPhase& { return phases[phaseIndex(job_phase)]; };
+    for(const std::string &file: files){
+        std::map<std::string, std::vector<std::vector<std::string>>> partitions;
+        timeTask(phase(JobPhase::Input), [&]{
+            FileProcessorBase* input = createInput("input", file);
+            input->runOperation();
+            partitions = input->takeInputDirectoryData();
+            destroyInput(input);
+            std::size_t lines = 0;
+            for(auto &row: partitions){
+                // as the driver does - FileProcessorMapOutput needs a token at the start of every partition
+                anchorPartitions(row.second);
+                for(const auto &partition: row.second){
+                    lines += partition.size();
+                }
+            }
+            return lines;
+        });
+        std::string mapperDirectory;
+        for(auto &row: partitions){
+            for(int p = 0; p < static_cast<int>(row.second.size()); p++){
+                std::map<std::string, std::vector<std::string>> mapperInput;
+                mapperInput.insert({row.first, std::move(row.second[p])});
+                mapperOutput_t mapped;
+                std::size_t tokens = 0;
+                timeTask(phase(JobPhase::Map), [&]{
+                    MapperBase* mapper = createMapper(p, mapperInput);
+                    mapper->runMapOperation();
+                    mapped = mapper->takeMapperOutput();
+                    destroyMapper(mapper);
+                    for(const auto &output: mapped){
+                        for(const auto &record: output.second){
+                            tokens += record.size();
+                        }
+                    }
+                    return tokens;
+                });
+                timeTask(phase(JobPhase::MapOutput), [&]{
+                    FileProcessorBase* mapOutput = createMapOutput("mapper", mapped);
+                    mapOutput->runOperation();
+                    mapperDirectory = mapOutput->getMapperOutputDirectory() + file.substr(file.rfind('/') + 1);
+                    destroyMapOutput(mapOutput);
+                    return tokens;
+                });
+            }
+        }
+        std::vector<std::map<std::string, std::map<std::string, size_t>>> shuffled;
+        std::size_t shuffledEntries = 0;
+        timeTask(phase(JobPhase::Shuffle), [&]{
+            ShufflerBase* shuffler = createShuffler(mapperDirectory);
+            shuffler->runShuffleOperation();
+            shuffled = shuffler->takeShuffledOutput();
+            destroyShuffler(shuffler);
+            for(const auto &output: shuffled){
+                for(const auto &counts: output){
+                    shuffledEntries += counts.second.size();
+                }
+            }
+            return shuffledEntries;
+        });
+        std::string shuffleDirectory;
+        timeTask(phase(JobPhase::ShuffleOutput), [&]{
+            FileProcessorBase* shuffleOutput = createShuffleOutput("shuffler", shuffled);
+            shuffleOutput->runOperation();
+            shuffleDirectory = shuffleOutput->getShufflerOutputDirectory() + "/" + file.substr(file.rfind('/') + 1);
+            destroyShuffleOutput(shuffleOutput);
+            return shuffledEntries;
+        });
+        std::map<std::string, std::map<std::string, size_t>> reduced;
+        std::size_t reducedEntries = 0;
+        timeTask(phase(JobPhase::Reduce), [&]{
+            ReducerBase* reducer = createReducer(shuffleDirectory);
+            reducer->runReduceOperations();
+            reduced = reducer->takeReducedOutput();
+            destroyReducer(reducer);
+            for(const auto &counts: reduced){
+                reducedEntries += counts.second.size();
+            }
+            return reducedEntries;
+        });
+        timeTask(phase(JobPhase::ReduceOutput), [&]{
+            FileProcessorBase* reduceOutput = createReduceOutput("reducer", reduced);
+            reduceOutput->runOperation();
+            destroyReduceOutput(reduceOutput);
+            return reducedEntries;
+        });
+    }
+    return phases;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        std::cerr << "Usage: PipelineBench <corpus_directory> [rounds] [executable] [options]..." << std::endl;
+        return 1;
+    }
+    std::filesystem::path corpus = std::filesystem::absolute(argv[1]);
+    unsigned rounds = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 3;
+    std::string executable = argc > 3 ? argv[3] : "./MapReducePhase3Exec";
+    std::vector<std::string> optionSets;
+    for(int i = 4; i < argc; i++){
+        optionSets.emplace_back(std::string(argv[i]) == "default" ? "" : argv[i]);
+    }
+    if(optionSets.empty()){
+        optionSets.emplace_back("");
+    }
+    std::vector<std::string> files;
+    std::uintmax_t corpusBytes = 0;
+    for(const auto &entry: std::filesystem::directory_iterator(corpus)){
+        if(entry.is_regular_file()){
+            files.push_back(entry.path().string());
+            corpusBytes += entry.file_size();
+        }
+    }
+    std::sort(files.begin(), files.end());
+    if(files.empty()){
+        std::cerr << "No input files in " << corpus.string() << std::endl;
+        return 1;
+    }
+    double corpusMegabytes = static_cast<double>(corpusBytes) / (1 << 20);
+    std::string metricsPath = (std::filesystem::temp_directory_path() / "PipelineBench.metrics.json").string();
+
+    std::cout << "{\"corpus\":{\"directory\":" << jsonString(corpus.string()) << ",\"files\":" << files.size()
+              << ",\"bytes\":" << corpusBytes << "},\n\"jobs\":[";
+    for(std::size_t o = 0; o < optionSets.size(); o++){
+        // the job's own metrics of every round are kept - the best round gives the throughput
+        std::vector<std::string> roundMetrics;
+        double best = 0;
+        for(unsigned round = 0; round < rounds; round++){
+            cleanOutputs(corpus);
+            std::filesystem::remove(metricsPath);
+            std::string command = shellQuote(executable) + " " + shellQuote(corpus.string()) + " " + optionSets[o] +
+                                  " --metrics-json=" + shellQuote(metricsPath) + " > /dev/null 2>&1";
+            auto start = std::chrono::steady_clock::now();
+            int status = std::system(command.c_str());
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            // the job reports its errors on stdout and still exits 0 - a finished job leaves SUCCESS.ind behind
+            if(status != 0 || !std::filesystem::exists(corpus / "final_output" / "SUCCESS.ind") ||
+               !std::filesystem::exists(metricsPath)){
+                std::cerr << "Job failed: " << command << std::endl;
+                return 1;
+            }
+            best = round == 0 ? seconds : std::min(best, seconds);
+            roundMetrics.push_back(readText(metricsPath));
+        }
+        std::cout << (o == 0 ? "\n" : ",\n") << "{\"options\":" << jsonString(optionSets[o])
+                  << ",\"best_wall_seconds\":" << best
+                  << ",\"megabytes_per_second\":" << corpusMegabytes / best
+                  << ",\"rounds\":[";
+        for(std::size_t r = 0; r < roundMetrics.size(); r++){
+            std::cout << (r == 0 ? "" : ",") << roundMetrics[r];
+        }
+        std::cout << "]}";
+    }
+    cleanOutputs(corpus);
+    std::filesystem::remove(metricsPath);
+
+    // plugins in isolation - the libraries report every task on std::cout, keep it out of the measurement
+    std::array<PluginPhase, JOB_PHASE_COUNT> best{};
+    std::streambuf* consoleBuffer = std::cout.rdbuf();
+    for(unsigned round = 0; round < rounds; round++){
+        cleanOutputs(corpus);
+        std::cout.rdbuf(nullptr);
+        std::array<PluginPhase, JOB_PHASE_COUNT> phases = runPlugins(files);
+        std::cout.rdbuf(consoleBuffer);
+        std::cout.clear();
+        for(std::size_t i = 0; i < JOB_PHASE_COUNT; i++){
+            if(round == 0 || phases[i].seconds < best[i].seconds){
+                best[i] = phases[i];
+            }
+        }
+    }
+    cleanOutputs(corpus);
+    // one process runs every phase - its peak is the peak of the most demanding phase
+    std::cout << "],\n\"plugins\":{\"peak_rss_kb\":" << readPeakRssKilobytes() << ",\"phases\":{";
+    for(std::size_t i = 0; i < JOB_PHASE_COUNT; i++){
+        std::cout << (i == 0 ? "\n" : ",\n") << "\"" << phaseName(static_cast<JobPhase>(i)) << "\":{"
+                  << "\"tasks\":" << best[i].tasks
+                  << ",\"seconds\":" << best[i].seconds
+                  << ",\"records\":" << best[i].records
+                  << ",\"corpus_megabytes_per_second\":" << corpusMegabytes / best[i].seconds << "}";
+    }
+    std::cout << "}}}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Description: Spill format benchmark - bytes and parse time of text vs binary temp_mapper/temp_shuffler files
+ *
+ * Usage: SpillFormatBench [tokens] [vocabulary] [rounds]
+ */
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../headers/SpillFormat.hpp"
+
+// Builds a mapper-style token stream - Zipf distributed over a synthetic vocabulary of lower case words
+std::vector<std::string> createTokens(std::size_t tokens, std::size_t vocabulary){
+    std::vector<std::string> words;
+    words.reserve(vocabulary);
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(2, 10);
+    for(std::size_t i = 0; i < vocabulary; i++){
+        std::string word;
+        for(int c = length(generator); c > 0; c--){
+            word += static_cast<char>(letter(generator));
+        }
+        words.push_back(word);
+    }
+    // cumulative Zipf (s = 1) weights
+    std::vector<double> cumulative(vocabulary);
+    double total = 0;
+    for(std::size_t i = 0; i < vocabulary; i++){
+        total += 1.0 / static_cast<double>(i + 1);
+        cumulative[i] = total;
+    }
+    std::uniform_real_distribution<double> pick(0, total);
+    std::vector<std::string> stream;
+    stream.reserve(tokens);
+    for(std::size_t i = 0; i < tokens; i++){
+        std::size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), pick(generator)) - cumulative.begin();
+        stream.push_back(words[std::min(rank, vocabulary - 1)]);
+    }
+    return stream;
+}
+
+template<typename F>
+double bestOf(unsigned rounds, F run){
+    double best = 0;
+    for(unsigned round = 0; round < rounds; round++){
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = round == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+// Parses a file image into a table and reports the best time - the table must match the expected counts
+bool measureParse(const char* file, const char* format, const std::string &image, const TokenCountTable &expected, unsigned rounds){
+    TokenCountTable table;
+    double seconds = bestOf(rounds, [&]{
+        table.clear();
+        aggregateSpillBuffer(image, table);
+    });
+    bool matches = table.size() == expected.size();
+    for(const auto &entry: expected.sortedEntries()){
+        matches = matches && table.getCount(entry.first) == entry.second;
+    }
+    std::cout << file << "," << format << "," << image.size() << "," << seconds << "," << image.size() / seconds / 1e6 << std::endl;
+    return matches;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t tokens = argc > 1 ? std::stoull(argv[1]) : 5000000;
+    std::size_t vocabulary = argc > 2 ? std::stoull(argv[2]) : 100000;
+    unsigned rounds = argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 3;
+    std::vector<std::string> stream = createTokens(tokens, vocabulary);
+
+    // temp_mapper - one entry per token occurrence, in input order
+    TokenCountTable expected;
+    std::string mapperText;
+    std::string mapperBinary;
+    SpillWriter mapperWriter(mapperBinary);
+    for(const std::string &token: stream){
+        expected.add(token);
+        mapperText += '(' + token + ",1)\n";
+        mapperWriter.add(token, 1);
+    }
+    mapperWriter.finish();
+
+    // temp_shuffler - one entry per distinct token, sorted
+    std::string shufflerText;
+    expected.appendSortedLines(shufflerText);
+    std::string shufflerBinary;
+    SpillWriter shufflerWriter(shufflerBinary);
+    for(const auto &entry: expected.sortedEntries()){
+        shufflerWriter.add(entry.first, entry.second);
+    }
+    shufflerWriter.finish();
+
+    std::cout << "file,format,bytes,parse_seconds,parse_mb_per_second" << std::endl;
+    bool matches = measureParse("temp_mapper", "text", mapperText, expected, rounds)
+                   && measureParse("temp_mapper", "binary", mapperBinary, expected, rounds)
+                   && measureParse("temp_shuffler", "text", shufflerText, expected, rounds)
+                   && measureParse("temp_shuffler", "binary", shufflerBinary, expected, rounds);
+    if(!matches){
+        std::cerr << "Parsed counts differ!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
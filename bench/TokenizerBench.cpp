@@ -0,0 +1,125 @@
+/*
+ * Description: Tokenizer benchmark - throughput of every NativeMapper tokenizer kernel the CPU supports
+ *
+ * Usage: TokenizerBench [megabytes] [rounds]
+ */
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "../headers/Tokenizer.hpp"
+
+// Builds word-count style input - mixed case words, punctuation, the odd non-ASCII byte, lines of varying length
+std::string createText(std::size_t bytes){
+    const std::vector<std::string> words{"the", "Quick", "brown", "FOX", "jumps", "over", "lazy", "dog's", "MapReduce",
+                                         "(token,count)", "e.g.", "don't", "caf\xc3\xa9", "na\xc3\xafve", "tab\there",
+                                         "1984", "x-ray", "\"quoted\"", "end.", "CRLF\r"};
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<std::size_t> word(0, words.size() - 1);
+    std::uniform_int_distribution<int> lineLength(0, 24);
+    std::uniform_int_distribution<int> spaces(1, 3);
+    std::string text;
+    text.reserve(bytes + 256);
+    while(text.size() < bytes){
+        for(int i = lineLength(generator); i > 0; i--){
+            text += words[word(generator)];
+            text.append(static_cast<std::size_t>(spaces(generator)), ' ');
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+// Builds input of arbitrary bytes - exercises every byte class at every position of a chunk
+std::string createRandomBytes(std::size_t bytes){
+    std::mt19937_64 generator(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> pick(0, 3);
+    std::string text(bytes, '\0');
+    for(char &c: text){
+        // bias towards delimiters and newlines so records and tokens stay short
+        int kind = pick(generator);
+        c = kind == 0 ? ' ' : kind == 1 && byte(generator) < 32 ? '\n' : static_cast<char>(byte(generator));
+    }
+    return text;
+}
+
+// Reference result - records split with std::getline, each tokenized by the scalar kernel
+mapperOutput_t referenceOutput(const std::string &text){
+    CompactMapperOutput output("bench", 0);
+    std::istringstream input(text);
+    std::string record;
+    while(std::getline(input, record)){
+        tokenizeScalar(record.data(), record.size(), output, false);
+    }
+    return output.toMapperOutput();
+}
+
+// Checks both entry points of a kernel against the reference
+bool matchesReference(const TokenizerKernel &kernel, const std::string &text, const mapperOutput_t &reference){
+    CompactMapperOutput split("bench", 0);
+    kernel.tokenize(text.data(), text.size(), split, true);
+    CompactMapperOutput perRecord("bench", 0);
+    std::istringstream input(text);
+    std::string record;
+    while(std::getline(input, record)){
+        kernel.tokenize(record.data(), record.size(), perRecord, false);
+    }
+    return split.toMapperOutput() == reference && perRecord.toMapperOutput() == reference;
+}
+
+int main(int argc, char* argv[]){
+    std::size_t megabytes = argc > 1 ? std::stoull(argv[1]) : 64;
+    unsigned rounds = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 5;
+    std::string text = createText(megabytes << 20);
+    std::vector<TokenizerKernel> kernels = availableTokenizerKernels();
+
+    // every kernel must produce exactly what the scalar kernel produces
+    std::vector<std::string> checks{createText(1 << 20), createRandomBytes(1 << 20), "", "\n", "a", "A\n\nB", " .,\n"};
+    for(std::size_t length = 0; length < 80; length++){
+        checks.push_back(createRandomBytes(length));
+    }
+    for(const std::string &check: checks){
+        mapperOutput_t reference = referenceOutput(check);
+        for(const TokenizerKernel &kernel: kernels){
+            if(!matchesReference(kernel, check, reference)){
+                std::cerr << "Output of the " << kernel.name << " kernel differs!" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // partitions of 2000 lines, as NativeMapper sees them with --mmap-input
+    std::vector<std::size_t> partitionEnds;
+    std::size_t lines = 0;
+    for(std::size_t i = 0; i < text.size(); i++){
+        if(text[i] == '\n' && ++lines % 2000 == 0){
+            partitionEnds.push_back(i + 1);
+        }
+    }
+    partitionEnds.push_back(text.size());
+
+    // single thread - the figures are per core
+    std::cout << "kernel,megabytes,seconds,gigabytes_per_second,tokens" << std::endl;
+    for(const TokenizerKernel &kernel: kernels){
+        double best = 0;
+        std::size_t tokens = 0;
+        for(unsigned round = 0; round < rounds; round++){
+            tokens = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::size_t begin = 0;
+            for(std::size_t end: partitionEnds){
+                CompactMapperOutput output("bench", 0);
+                output.reserve((end - begin) / 6 + 1, end - begin + TOKENIZER_ARENA_SLACK);
+                kernel.tokenize(text.data() + begin, end - begin, output, true);
+                tokens += output.getTokenCount();
+                begin = end;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = round == 0 ? seconds : std::min(best, seconds);
+        }
+        std::cout << kernel.name << "," << megabytes << "," << best << "," << text.size() / best / 1e9 << "," << tokens << std::endl;
+    }
+    std::cout << "active," << activeTokenizerKernel().name << std::endl;
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Description: Result of a single shuffler or reducer task as handed between phases by the driver
+ */
+#ifndef MAPREDUCELIB_AGGREGATIONRESULT_HPP
+#define MAPREDUCELIB_AGGREGATIONRESULT_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include "TokenCountTable.hpp"
+#include "TokenIdTable.hpp"
+
+// Aggregated counts of one output file - temp_shuffler/<file>/<file>.<partition> or final_output/<file>
+// With --token-ids the counts are keyed by the token IDs of dictionary instead - ids holds them and table stays empty
+struct AggregatedFile{
+    std::string path;
+    TokenCountTable table;
+    TokenIdTable ids;
+    // dictionary of ids - nullptr when table holds the counts
+    const TokenDictionary* dictionary = nullptr;
+
+    // Distinct tokens of the file
+    std::size_t size() const{
+        return this->dictionary ? this->ids.size() : this->table.size();
+    }
+    // Bytes of the distinct tokens of the file
+    std::size_t getTokenBytes() const{
+        return this->dictionary ? this->ids.getTokenBytes(*this->dictionary) : this->table.getTokenBytes();
+    }
+};
+
+// the type of the result of NativeShuffler and NativeReducer
+typedef std::vector<AggregatedFile> aggregatedOutput_t;
+
+// Helper - merges the tables of entries that share a path, e.g. the parts of one final_output file held by several reducers
+// Entries keep the order in which their path first appears
+inline aggregatedOutput_t mergeAggregatedFiles(aggregatedOutput_t &&files){
+    aggregatedOutput_t merged;
+    std::map<std::string, std::size_t> positions;
+    for(AggregatedFile &file: files){
+        auto position = positions.find(file.path);
+        if(position == positions.end()){
+            positions.emplace(file.path, merged.size());
+            merged.push_back(std::move(file));
+        } else {
+            merged[position->second].table.merge(file.table);
+            merged[position->second].ids.merge(file.ids);
+            file.table.clear();
+            file.ids.clear();
+        }
+    }
+    files.clear();
+    return merged;
+}
+
+// Library shufflers/reducers produce nested std::map containers, NativeShuffler/NativeReducer produce hash tables.
+// Exactly one of the two is populated, as indicated by hashed.
+// ExternalShuffler/ExternalReducer stream their result to disk - neither is populated, and outputDirectory holds it.
+template<typename Nested>
+struct AggregationResult{
+    // true when aggregatedOutput holds the result
+    bool hashed = false;
+    // true when the result is already written to outputDirectory
+    bool streamed = false;
+    std::string outputDirectory;
+    Nested nestedOutput;
+    aggregatedOutput_t aggregatedOutput;
+};
+
+typedef AggregationResult<std::vector<std::map<std::string, std::map<std::string,size_t>>>> ShuffleResult;
+typedef AggregationResult<std::map<std::string, std::map<std::string,size_t>>> ReduceResult;
+
+#endif //MAPREDUCELIB_AGGREGATIONRESULT_HPP
@@ -0,0 +1,471 @@
+/*
+ * Description: Asynchronous output writer - the built-in output processors hand over whole file buffers and return,
+ * the writes run on dedicated I/O threads (io_uring, or a pwrite thread pool) until the driver's barrier for the phase
+ */
+#ifndef MAPREDUCELIB_ASYNCFILEWRITER_HPP
+#define MAPREDUCELIB_ASYNCFILEWRITER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "JobPhase.hpp"
+
+// Largest single write - io_uring lengths are 32 bit, and chunks this size already run at device speed
+constexpr std::size_t ASYNC_WRITE_CHUNK_BYTES = 8 << 20;
+// Submission queue entries of the io_uring backend - chunks in flight at once
+constexpr unsigned ASYNC_URING_ENTRIES = 64;
+// Threads of the pwrite backend
+constexpr unsigned ASYNC_WRITE_THREADS = 4;
+// Buffers queued but not yet written - past this, enqueue blocks until the disk catches up, so a slow disk holds
+// back the writers instead of growing the heap without bound
+constexpr std::size_t ASYNC_QUEUED_BYTES_LIMIT = 256 << 20;
+
+// How the I/O threads write
+enum class WriteBackend{
+    // io_uring if the kernel allows it, the pwrite pool otherwise
+    Auto = 0,
+    // a single thread submitting the chunks of many files per io_uring_enter
+    Uring,
+    // ASYNC_WRITE_THREADS threads, one blocking pwrite loop per file
+    Pwrite
+};
+
+// Helper - backend of an --async-output value ("" is auto)
+inline WriteBackend parseWriteBackend(const std::string &value){
+    if(value.empty() || value == "auto"){
+        return WriteBackend::Auto;
+    }
+    if(value == "uring"){
+        return WriteBackend::Uring;
+    }
+    if(value == "pwrite"){
+        return WriteBackend::Pwrite;
+    }
+    throw std::runtime_error("Unsupported output backend!: " + value);
+}
+
+// Minimal io_uring - raw system calls on the kernel's ABI header, only what whole-file writes need
+class UringQueue{
+private:
+    int ringFd = -1;
+    void* submissionRing = MAP_FAILED;
+    std::size_t submissionRingBytes = 0;
+    void* completionRing = MAP_FAILED;
+    std::size_t completionRingBytes = 0;
+    io_uring_sqe* entries = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t entriesBytes = 0;
+    unsigned* submissionTail = nullptr;
+    unsigned submissionMask = 0;
+    unsigned* submissionArray = nullptr;
+    unsigned* completionHead = nullptr;
+    unsigned* completionTail = nullptr;
+    unsigned completionMask = 0;
+    io_uring_cqe* completions = nullptr;
+    // entries filled since the last submit
+    unsigned unsubmitted = 0;
+    unsigned capacity = 0;
+
+    template<typename T>
+    static T* ringField(void* ring, unsigned offset){
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+
+    // true if the ring accepts IORING_OP_WRITE - kernels 5.1 to 5.5 set up a ring but reject the opcode (EINVAL on
+    // every completion); they predate IORING_REGISTER_PROBE as well, so a failed probe means no write either
+    bool supportsWrite() const{
+        std::vector<std::uint64_t> probeBuffer((sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op) + 7) / 8, 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(probeBuffer.data());
+        if(syscall(__NR_io_uring_register, this->ringFd, IORING_REGISTER_PROBE, probe, 256) < 0){
+            return false;
+        }
+        return IORING_OP_WRITE < probe->ops_len && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    }
+
+public:
+    // Constructor - throws if the kernel refuses a ring (too old, or io_uring disabled) or cannot write through it
+    explicit UringQueue(unsigned queue_entries){
+        io_uring_params params{};
+        this->ringFd = static_cast<int>(syscall(__NR_io_uring_setup, queue_entries, &params));
+        if(this->ringFd < 0){
+            throw std::runtime_error(std::string("io_uring is unavailable - ") + std::strerror(errno));
+        }
+        this->capacity = params.sq_entries;
+        this->submissionRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        this->completionRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+        if(singleMapping){
+            this->submissionRingBytes = this->completionRingBytes = std::max(this->submissionRingBytes, this->completionRingBytes);
+        }
+        this->submissionRing = mmap(nullptr, this->submissionRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                    this->ringFd, IORING_OFF_SQ_RING);
+        if(this->submissionRing != MAP_FAILED){
+            this->completionRing = singleMapping ? this->submissionRing :
+                    mmap(nullptr, this->completionRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         this->ringFd, IORING_OFF_CQ_RING);
+        }
+        this->entriesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        if(this->completionRing != MAP_FAILED){
+            this->entries = static_cast<io_uring_sqe*>(mmap(nullptr, this->entriesBytes, PROT_READ | PROT_WRITE,
+                                                            MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQES));
+        }
+        if(this->entries == MAP_FAILED){
+            int error = errno;
+            this->release();
+            throw std::runtime_error(std::string("Cannot map the io_uring rings - ") + std::strerror(error));
+        }
+        this->submissionTail = ringField<unsigned>(this->submissionRing, params.sq_off.tail);
+        this->submissionMask = *ringField<unsigned>(this->submissionRing, params.sq_off.ring_mask);
+        this->submissionArray = ringField<unsigned>(this->submissionRing, params.sq_off.array);
+        this->completionHead = ringField<unsigned>(this->completionRing, params.cq_off.head);
+        this->completionTail = ringField<unsigned>(this->completionRing, params.cq_off.tail);
+        this->completionMask = *ringField<unsigned>(this->completionRing, params.cq_off.ring_mask);
+        this->completions = ringField<io_uring_cqe>(this->completionRing, params.cq_off.cqes);
+        if(!this->supportsWrite()){
+            this->release();
+            throw std::runtime_error("io_uring does not support IORING_OP_WRITE on this kernel");
+        }
+    }
+
+    // Not copyable - the rings have a single owner
+    UringQueue(const UringQueue &) = delete;
+    UringQueue& operator=(const UringQueue &) = delete;
+
+    // Destructor
+    ~UringQueue(){
+        this->release();
+    }
+
+    // Unmaps the rings and closes the ring - safe on a partly set up queue
+    void release(){
+        if(this->entries != MAP_FAILED){
+            munmap(this->entries, this->entriesBytes);
+        }
+        if(this->completionRing != MAP_FAILED && this->completionRing != this->submissionRing){
+            munmap(this->completionRing, this->completionRingBytes);
+        }
+        if(this->submissionRing != MAP_FAILED){
+            munmap(this->submissionRing, this->submissionRingBytes);
+        }
+        if(this->ringFd >= 0){
+            close(this->ringFd);
+        }
+        this->entries = static_cast<io_uring_sqe*>(MAP_FAILED);
+        this->completionRing = this->submissionRing = MAP_FAILED;
+        this->ringFd = -1;
+    }
+
+    // Queues a write of [data, data + length) at offset of descriptor - submitted with the next submitAndWait
+    void queueWrite(int descriptor, const char* data, unsigned length, std::uint64_t offset, std::uint64_t user_data){
+        unsigned tail = *this->submissionTail;
+        unsigned index = tail & this->submissionMask;
+        io_uring_sqe &entry = this->entries[index];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.opcode = IORING_OP_WRITE;
+        entry.fd = descriptor;
+        entry.addr = reinterpret_cast<std::uint64_t>(data);
+        entry.len = length;
+        entry.off = offset;
+        entry.user_data = user_data;
+        this->submissionArray[index] = index;
+        // the kernel reads the entry once it sees the new tail
+        __atomic_store_n(this->submissionTail, tail + 1, __ATOMIC_RELEASE);
+        this->unsubmitted++;
+    }
+
+    // Submits the queued writes in one system call and waits for at least min_complete completions
+    void submitAndWait(unsigned min_complete){
+        while(true){
+            long submitted = syscall(__NR_io_uring_enter, this->ringFd, this->unsubmitted, min_complete,
+                                     min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if(submitted >= 0){
+                this->unsubmitted -= static_cast<unsigned>(submitted);
+                return;
+            }
+            if(errno != EINTR){
+                throw std::runtime_error(std::string("io_uring_enter failed - ") + std::strerror(errno));
+            }
+        }
+    }
+
+    // Hands every completion that is ready to on_completion(user_data, result) - returns how many there were
+    template<typename F>
+    unsigned reap(F on_completion){
+        unsigned head = *this->completionHead;
+        unsigned tail = __atomic_load_n(this->completionTail, __ATOMIC_ACQUIRE);
+        unsigned reaped = 0;
+        for(; head != tail; head++, reaped++){
+            const io_uring_cqe &completion = this->completions[head & this->completionMask];
+            on_completion(completion.user_data, completion.res);
+        }
+        __atomic_store_n(this->completionHead, head, __ATOMIC_RELEASE);
+        return reaped;
+    }
+
+    // Getter - submission queue entries
+    unsigned getCapacity() const{
+        return this->capacity;
+    }
+};
+
+// Shared asynchronous writer - enqueue hands over a complete file and returns at once, flush is the barrier of a phase
+class AsyncFileWriter{
+private:
+    // One file to write - the buffer is owned until the last byte is on its way to disk
+    struct WriteRequest{
+        JobPhase phase;
+        std::string path;
+        std::string contents;
+        int descriptor = -1;
+        // bytes written so far - the next chunk starts here
+        std::size_t written = 0;
+        // io_uring backend - a chunk of the file is being written
+        bool inFlight = false;
+        int error = 0;
+    };
+    // Writes of a phase not done yet, and the first error among them
+    struct PhaseWrites{
+        std::size_t pending = 0;
+        std::string error;
+        // a file of the phase - the file system flush uses its directory
+        std::string lastPath;
+    };
+
+    WriteBackend backend;
+    std::mutex queueMutex;
+    // wakes the I/O threads
+    std::condition_variable queueCondition;
+    // wakes enqueue (queue below the byte limit) and flush (a phase done)
+    std::condition_variable doneCondition;
+    std::deque<WriteRequest*> queue;
+    std::size_t queuedBytes = 0;
+    std::array<PhaseWrites, JOB_PHASE_COUNT> phases;
+    bool stopping = false;
+    std::unique_ptr<UringQueue> ring;
+    std::vector<std::thread> threads;
+
+    static int openOutput(const std::string &path){
+        return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    }
+
+    // Ends a request - its phase is told, and its bytes leave the queue
+    void complete(WriteRequest* request){
+        std::string error;
+        if(request->error != 0){
+            error = "Cannot write " + request->path + " - " + std::strerror(request->error);
+        }
+        if(request->descriptor >= 0 && close(request->descriptor) != 0 && error.empty()){
+            error = "Cannot write " + request->path + " - " + std::strerror(errno);
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            PhaseWrites &phase = this->phases[phaseIndex(request->phase)];
+            phase.pending--;
+            if(!error.empty() && phase.error.empty()){
+                phase.error = error;
+            }
+            this->queuedBytes -= request->contents.size();
+        }
+        this->doneCondition.notify_all();
+        delete request;
+    }
+
+    // Takes the next request - nullptr once stopping and the queue is drained, or when wait is false and it is empty
+    WriteRequest* takeRequest(bool wait){
+        std::unique_lock<std::mutex> lock(this->queueMutex);
+        if(wait){
+            this->queueCondition.wait(lock, [this]{ return this->stopping || !this->queue.empty(); });
+        }
+        if(this->queue.empty()){
+            return nullptr;
+        }
+        WriteRequest* request = this->queue.front();
+        this->queue.pop_front();
+        return request;
+    }
+
+    // pwrite backend - every thread writes one file at a time, front to back
+    void pwriteLoop(){
+        while(WriteRequest* request = this->takeRequest(true)){
+            request->descriptor = openOutput(request->path);
+            if(request->descriptor < 0){
+                request->error = errno;
+            }
+            while(request->error == 0 && request->written < request->contents.size()){
+                std::size_t length = std::min(request->contents.size() - request->written, ASYNC_WRITE_CHUNK_BYTES);
+                ssize_t written = pwrite(request->descriptor, request->contents.data() + request->written, length,
+                                         static_cast<off_t>(request->written));
+                if(written < 0 && errno != EINTR){
+                    request->error = errno;
+                } else if(written == 0){
+                    request->error = EIO;
+                } else if(written > 0){
+                    request->written += static_cast<std::size_t>(written);
+                }
+            }
+            this->complete(request);
+        }
+    }
+
+    // io_uring backend - one thread keeps many files in flight and submits their next chunks together
+    // Every file has at most one chunk in flight, so a short write simply continues from where it stopped
+    void uringLoop(){
+        std::vector<WriteRequest*> active;
+        while(true){
+            // take new files while there is room in the ring - block only when nothing is in flight
+            while(active.size() < this->ring->getCapacity()){
+                WriteRequest* request = this->takeRequest(active.empty());
+                if(!request){
+                    break;
+                }
+                request->descriptor = openOutput(request->path);
+                if(request->descriptor < 0){
+                    request->error = errno;
+                    this->complete(request);
+                    continue;
+                }
+                active.push_back(request);
+            }
+            if(active.empty()){
+                // stopping, and every file is written
+                return;
+            }
+            // coalesce - the next chunk of every file goes out with a single io_uring_enter
+            unsigned inFlight = 0;
+            for(WriteRequest* request: active){
+                if(!request->inFlight && request->error == 0 && request->written < request->contents.size()){
+                    std::size_t length = std::min(request->contents.size() - request->written, ASYNC_WRITE_CHUNK_BYTES);
+                    this->ring->queueWrite(request->descriptor, request->contents.data() + request->written,
+                                           static_cast<unsigned>(length), request->written,
+                                           reinterpret_cast<std::uint64_t>(request));
+                    request->inFlight = true;
+                }
+                inFlight += request->inFlight;
+            }
+            this->ring->submitAndWait(inFlight > 0 ? 1 : 0);
+            this->ring->reap([](std::uint64_t user_data, int result){
+                auto* request = reinterpret_cast<WriteRequest*>(user_data);
+                request->inFlight = false;
+                if(result < 0){
+                    request->error = -result;
+                } else if(result == 0){
+                    // no progress on a regular file - treat it like a full device rather than retry forever
+                    request->error = EIO;
+                } else {
+                    request->written += static_cast<std::size_t>(result);
+                }
+            });
+            // files with nothing in flight and nothing left to write are done
+            auto done = std::stable_partition(active.begin(), active.end(), [](WriteRequest* request){
+                return request->inFlight || (request->error == 0 && request->written < request->contents.size());
+            });
+            for(auto request = done; request != active.end(); request++){
+                this->complete(*request);
+            }
+            active.erase(done, active.end());
+        }
+    }
+
+public:
+    // Constructor - starts the I/O threads; Auto falls back to pwrite when the kernel refuses io_uring or its writes
+    explicit AsyncFileWriter(WriteBackend write_backend) : backend(write_backend){
+        if(this->backend != WriteBackend::Pwrite){
+            try{
+                this->ring = std::make_unique<UringQueue>(ASYNC_URING_ENTRIES);
+                this->backend = WriteBackend::Uring;
+            } catch(std::runtime_error &){
+                if(this->backend == WriteBackend::Uring){
+                    throw;
+                }
+                this->backend = WriteBackend::Pwrite;
+            }
+        }
+        if(this->backend == WriteBackend::Uring){
+            this->threads.emplace_back(&AsyncFileWriter::uringLoop, this);
+        } else {
+            for(unsigned i = 0; i < ASYNC_WRITE_THREADS; i++){
+                this->threads.emplace_back(&AsyncFileWriter::pwriteLoop, this);
+            }
+        }
+    }
+
+    // Not copyable - the I/O threads point back at the writer
+    AsyncFileWriter(const AsyncFileWriter &) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter &) = delete;
+
+    // Destructor - writes whatever is still queued, then stops the I/O threads
+    ~AsyncFileWriter(){
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->stopping = true;
+        }
+        this->queueCondition.notify_all();
+        for(std::thread &thread: this->threads){
+            thread.join();
+        }
+    }
+
+    // Hands a complete file over to the I/O threads - returns once it is queued; only blocks while more than
+    // ASYNC_QUEUED_BYTES_LIMIT bytes are waiting for the disk
+    void enqueue(JobPhase phase, const std::string &path, std::string &&contents){
+        auto* request = new WriteRequest{phase, path, std::move(contents)};
+        {
+            std::unique_lock<std::mutex> lock(this->queueMutex);
+            this->doneCondition.wait(lock, [this]{ return this->queuedBytes < ASYNC_QUEUED_BYTES_LIMIT; });
+            PhaseWrites &writes = this->phases[phaseIndex(phase)];
+            writes.pending++;
+            writes.lastPath = path;
+            this->queuedBytes += request->contents.size();
+            this->queue.push_back(request);
+        }
+        this->queueCondition.notify_one();
+    }
+
+    // Barrier of a phase - returns once every file of the phase is written, throws the first write error
+    // With sync, the file system holding the files is flushed to the device as well - one syncfs, not a fsync per file
+    void flush(JobPhase phase, bool sync){
+        std::string lastPath;
+        std::string error;
+        {
+            std::unique_lock<std::mutex> lock(this->queueMutex);
+            PhaseWrites &writes = this->phases[phaseIndex(phase)];
+            this->doneCondition.wait(lock, [&writes]{ return writes.pending == 0; });
+            lastPath = writes.lastPath;
+            error.swap(writes.error);
+        }
+        if(!error.empty()){
+            throw std::runtime_error(error);
+        }
+        if(sync && !lastPath.empty()){
+            int descriptor = open(lastPath.c_str(), O_RDONLY | O_CLOEXEC);
+            if(descriptor < 0 || syncfs(descriptor) != 0){
+                int syncError = errno;
+                if(descriptor >= 0){
+                    close(descriptor);
+                }
+                throw std::runtime_error("Cannot sync " + lastPath + " - " + std::strerror(syncError));
+            }
+            close(descriptor);
+        }
+    }
+
+    // Getter - backend in use
+    const char* getBackendName() const{
+        return this->backend == WriteBackend::Uring ? "io_uring" : "pwrite";
+    }
+};
+
+#endif //MAPREDUCELIB_ASYNCFILEWRITER_HPP
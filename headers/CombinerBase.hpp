@@ -0,0 +1,31 @@
+/*
+ * Description: Combiner Base (Abstract) - optional mapper-side pre-aggregation of map output
+ */
+#ifndef MAPREDUCELIB_COMBINERBASE_HPP
+#define MAPREDUCELIB_COMBINERBASE_HPP
+
+#include "MapperBase.hpp"
+#include "CompactMapperOutput.hpp"
+
+// A combiner collapses repeated tokens of one mapper result into a single entry carrying the summed count,
+// before the result is written to temp_mapper or retained in memory.
+// Concurrency contract:
+// One instance is shared by every map task of a job - combine must not keep state between calls.
+class CombinerBase{
+public:
+    // Destructor
+    virtual ~CombinerBase(){};
+
+    // Primary method - combines a nested mapper result in place
+    // The total count of every (file, partition, token) must be preserved
+    virtual void combine(mapperOutput_t &mapper_output) = 0;
+
+    // Combines a compact mapper result in place - defaults to a round trip through the nested structure
+    virtual void combineCompact(CompactMapperOutput &mapper_output){
+        mapperOutput_t nested = mapper_output.toMapperOutput();
+        this->combine(nested);
+        mapper_output = CompactMapperOutput::fromMapperOutput(nested, mapper_output.getPartitionNum());
+    }
+};
+
+#endif //MAPREDUCELIB_COMBINERBASE_HPP
@@ -0,0 +1,220 @@
+/*
+ * Description: Compact mapper output - token bytes in one arena, token attributes in flat parallel arrays
+ */
+#ifndef MAPREDUCELIB_COMPACTMAPPEROUTPUT_HPP
+#define MAPREDUCELIB_COMPACTMAPPEROUTPUT_HPP
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MapperBase.hpp"
+#include "TokenDictionary.hpp"
+
+// Same information as mapperOutput_t for a single file and partition, laid out as a struct of arrays:
+//  * arena       - bytes of every token, back to back
+//  * offsets     - start of each token in the arena
+//  * lengths     - length of each token
+//  * counts      - occurrences represented by each token entry
+//  * partitions  - originating partition of each token entry
+//  * recordEnds  - one past the last token of each input record, so the record structure survives
+// Appending a token costs no allocation beyond the amortised growth of these buffers.
+// Offsets, lengths and record ends are 32-bit - an output whose arena or token count outgrows them is rejected.
+// Once interned (--token-ids), tokenIds replaces arena, offsets and lengths - tokens are resolved through the dictionary.
+class CompactMapperOutput{
+private:
+    std::string fileName;
+    int partitionNum = 0;
+    std::string arena;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> lengths;
+    std::vector<std::uint32_t> counts;
+    std::vector<std::int32_t> partitions;
+    std::vector<std::uint32_t> recordEnds;
+    // set by internTokens
+    const TokenDictionary* dictionary = nullptr;
+    std::vector<std::uint32_t> tokenIds;
+    // arena size before interning - still reported by getArenaBytes
+    std::size_t internedBytes = 0;
+
+    static constexpr std::size_t MAX_32BIT_FIELD = std::numeric_limits<std::uint32_t>::max();
+
+    // Throws unless a token ending at arena_end, and one more token entry, fit the 32-bit fields
+    void checkFieldRange(std::size_t arena_end) const{
+        if(arena_end > MAX_32BIT_FIELD || this->offsets.size() >= MAX_32BIT_FIELD){
+            throw std::runtime_error("Mapper output exceeds 4 GiB or 2^32 tokens - use a smaller --task-bytes!: " + this->fileName);
+        }
+    }
+
+public:
+    // Default constructor
+    CompactMapperOutput(){};
+
+    // Initialization Constructor - output of one partition of one file
+    CompactMapperOutput(const std::string &file_name, int partition_num)
+            : fileName(file_name), partitionNum(partition_num){
+    }
+
+    // Pre-sizes the buffers
+    void reserve(std::size_t tokens, std::size_t bytes){
+        this->arena.reserve(bytes);
+        this->offsets.reserve(tokens);
+        this->lengths.reserve(tokens);
+        this->counts.reserve(tokens);
+        this->partitions.reserve(tokens);
+    }
+
+    // Releases the unused tail of the buffers - called once the output is complete
+    void shrinkToFit(){
+        this->arena.shrink_to_fit();
+        this->offsets.shrink_to_fit();
+        this->lengths.shrink_to_fit();
+        this->counts.shrink_to_fit();
+        this->partitions.shrink_to_fit();
+        this->recordEnds.shrink_to_fit();
+    }
+
+    // Direct access to the arena - used by tokenizers that write token bytes in place
+    std::string& getArena(){
+        return this->arena;
+    }
+
+    // Registers a token whose bytes already sit at the end of the arena, starting at offset
+    void commitToken(std::size_t offset, std::uint32_t count = 1){
+        this->checkFieldRange(this->arena.size());
+        this->offsets.push_back(static_cast<std::uint32_t>(offset));
+        this->lengths.push_back(static_cast<std::uint32_t>(this->arena.size() - offset));
+        this->counts.push_back(count);
+        this->partitions.push_back(this->partitionNum);
+    }
+
+    // Registers a token of length bytes at offset - for tokenizers that size the arena before writing into it
+    void commitTokenAt(std::size_t offset, std::size_t length){
+        this->checkFieldRange(offset + length);
+        this->offsets.push_back(static_cast<std::uint32_t>(offset));
+        this->lengths.push_back(static_cast<std::uint32_t>(length));
+        this->counts.push_back(1);
+        this->partitions.push_back(this->partitionNum);
+    }
+
+    // Copies a token into the arena and registers it
+    void addToken(std::string_view token, std::uint32_t count = 1){
+        std::size_t offset = this->arena.size();
+        this->arena.append(token.data(), token.size());
+        this->commitToken(offset, count);
+    }
+
+    // Closes the current input record
+    void endRecord(){
+        this->recordEnds.push_back(static_cast<std::uint32_t>(this->offsets.size()));
+    }
+
+    // Getters
+    const std::string& getFileName() const{
+        return this->fileName;
+    }
+    int getPartitionNum() const{
+        return this->partitionNum;
+    }
+    std::size_t getTokenCount() const{
+        return this->counts.size();
+    }
+    std::size_t getRecordCount() const{
+        return this->recordEnds.size();
+    }
+    std::string_view getToken(std::size_t index) const{
+        if(this->dictionary){
+            return this->dictionary->lookup(this->tokenIds[index]);
+        }
+        return std::string_view(this->arena.data() + this->offsets[index], this->lengths[index]);
+    }
+    std::uint32_t getCount(std::size_t index) const{
+        return this->counts[index];
+    }
+    int getPartition(std::size_t index) const{
+        return this->partitions[index];
+    }
+    // Total bytes of token data, without the per-token attributes
+    std::size_t getArenaBytes() const{
+        return this->dictionary ? this->internedBytes : this->arena.size();
+    }
+    // Whether the tokens are held as IDs of a dictionary
+    bool hasTokenIds() const{
+        return this->dictionary != nullptr;
+    }
+    std::uint32_t getTokenId(std::size_t index) const{
+        return this->tokenIds[index];
+    }
+
+    // Heap footprint - used to enforce the in-memory budget
+    std::size_t getMemoryBytes() const{
+        return this->fileName.capacity() + this->arena.capacity()
+               + (this->offsets.capacity() + this->lengths.capacity() + this->counts.capacity()
+                  + this->recordEnds.capacity() + this->tokenIds.capacity()) * sizeof(std::uint32_t)
+               + this->partitions.capacity() * sizeof(std::int32_t);
+    }
+
+    // Replaces every token by its ID in token_dictionary and releases the token bytes - the output then holds four
+    // bytes per token entry instead of the token itself. Called once the output is complete (and combined).
+    void internTokens(TokenDictionary &token_dictionary){
+        if(this->dictionary){
+            return;
+        }
+        this->tokenIds.reserve(this->offsets.size());
+        for(std::size_t i = 0; i < this->offsets.size(); i++){
+            this->tokenIds.push_back(token_dictionary.intern(this->getToken(i)));
+        }
+        this->internedBytes = this->arena.size();
+        this->dictionary = &token_dictionary;
+        // swapped out rather than cleared - clearing keeps the allocations
+        std::string().swap(this->arena);
+        std::vector<std::uint32_t>().swap(this->offsets);
+        std::vector<std::uint32_t>().swap(this->lengths);
+    }
+
+    // Conversion to the nested structure produced by the library mappers
+    mapperOutput_t toMapperOutput() const{
+        std::vector<std::vector<std::tuple<std::string, int, int>>> records;
+        records.reserve(this->recordEnds.size());
+        std::size_t token = 0;
+        for(std::uint32_t recordEnd: this->recordEnds){
+            std::vector<std::tuple<std::string, int, int>> record;
+            record.reserve(recordEnd - token);
+            for(; token < recordEnd; token++){
+                record.emplace_back(std::string(this->getToken(token)),
+                                    static_cast<int>(this->counts[token]),
+                                    this->partitions[token]);
+            }
+            records.push_back(std::move(record));
+        }
+        mapperOutput_t mapperOutput;
+        mapperOutput.insert({this->fileName, std::move(records)});
+        return mapperOutput;
+    }
+
+    // Conversion from the nested structure produced by the library mappers (single file, single partition)
+    static CompactMapperOutput fromMapperOutput(const mapperOutput_t &mapper_output, int partition_num){
+        if(mapper_output.empty()){
+            return CompactMapperOutput();
+        }
+        CompactMapperOutput compact(mapper_output.begin()->first, partition_num);
+        for(const auto &record: mapper_output.begin()->second){
+            for(const auto &token: record){
+                std::size_t offset = compact.arena.size();
+                compact.checkFieldRange(offset + std::get<0>(token).size());
+                compact.arena.append(std::get<0>(token));
+                compact.offsets.push_back(static_cast<std::uint32_t>(offset));
+                compact.lengths.push_back(static_cast<std::uint32_t>(std::get<0>(token).size()));
+                compact.counts.push_back(static_cast<std::uint32_t>(std::get<1>(token)));
+                compact.partitions.push_back(std::get<2>(token));
+            }
+            compact.endRecord();
+        }
+        compact.shrinkToFit();
+        return compact;
+    }
+};
+
+#endif //MAPREDUCELIB_COMPACTMAPPEROUTPUT_HPP
@@ -0,0 +1,63 @@
+/*
+ * Description: Reducer implementation of the external sort-merge shuffle - streams a temp_shuffler sub-folder to final_output
+ */
+#ifndef MAPREDUCELIB_EXTERNALREDUCER_HPP
+#define MAPREDUCELIB_EXTERNALREDUCER_HPP
+
+#include <algorithm>
+#include "ReducerBase.hpp"
+#include "ExternalSort.hpp"
+
+// Produces the same final_output file as ReducerImpl with a last k-way merge of the runs of ExternalShuffler - the
+// output is written as it is merged, so it never exists in memory. getReducedOutput() stays empty.
+// Concurrency contract: same as ReducerBase
+class ExternalReducer : public ReducerBase{
+private:
+    // memory available to one merge - reader and writer buffers
+    std::size_t budgetBytes;
+    SpillFormat spillFormat;
+    // final_output directory written by runReduceOperations
+    std::string finalDirectory;
+
+public:
+    // explicit constructor - reads a temp_shuffler sub-folder of sorted runs
+    ExternalReducer(const std::string &parent_shuffle_directory, std::size_t budget_bytes,
+                    SpillFormat spill_format = SpillFormat::Text)
+            : ReducerBase(parent_shuffle_directory), budgetBytes(budget_bytes), spillFormat(spill_format){
+    }
+
+    // Merges every run of the sub-folder into <input dir>/final_output/<file>
+    void runReduceOperations() override{
+        std::filesystem::path shuffleDirectory(this->getShuffleOutputDirectory());
+        if(!shuffleDirectory.has_filename()){
+            shuffleDirectory = shuffleDirectory.parent_path();
+        }
+        std::filesystem::path finalDirectory = shuffleDirectory.parent_path().parent_path() / "final_output";
+        std::error_code error;
+        std::filesystem::create_directories(finalDirectory, error);
+        if(error && !std::filesystem::is_directory(finalDirectory)){
+            throw std::runtime_error("Cannot create directory!: " + finalDirectory.string() + " - " + error.message());
+        }
+        std::vector<std::string> runs;
+        for(const auto &entry: std::filesystem::directory_iterator(shuffleDirectory)){
+            if(entry.is_regular_file()){
+                runs.push_back(entry.path().string());
+            }
+        }
+        std::sort(runs.begin(), runs.end());
+        // only needed when the budget shrank since the shuffle - the shuffler leaves few enough runs for one merge
+        std::string prefix = (shuffleDirectory / shuffleDirectory.filename()).string() + ".r";
+        for(unsigned pass = 0; runs.size() > mergeFanIn(this->budgetBytes); pass++){
+            runs = mergeRunPass(runs, prefix + std::to_string(pass) + ".", this->spillFormat, this->budgetBytes, pass > 0);
+        }
+        mergeSortedRuns(runs, (finalDirectory / shuffleDirectory.filename()).string(), SpillFormat::Text, this->budgetBytes);
+        this->finalDirectory = finalDirectory.string();
+    }
+
+    // Getter - final_output directory holding the result
+    const std::string& getFinalDirectory() const{
+        return this->finalDirectory;
+    }
+};
+
+#endif //MAPREDUCELIB_EXTERNALREDUCER_HPP
@@ -0,0 +1,65 @@
+/*
+ * Description: Shuffler implementation of the external sort-merge shuffle - merges the sorted runs of a temp_mapper sub-folder
+ */
+#ifndef MAPREDUCELIB_EXTERNALSHUFFLER_HPP
+#define MAPREDUCELIB_EXTERNALSHUFFLER_HPP
+
+#include <algorithm>
+#include "ShufflerBase.hpp"
+#include "ExternalSort.hpp"
+
+// Streams the runs written by FileProcessorSortedRuns into fewer, longer runs under temp_shuffler/<file>/, merging at most
+// mergeFanIn(budget) runs at a time and passing over its own output until few enough runs are left for a single merge
+// in ExternalReducer. Memory use is bounded by the budget, whatever the size of the file.
+// Nothing is handed over in memory - getShuffledOutput() stays empty and the result is the temp_shuffler sub-folder.
+// Concurrency contract: same as ShufflerBase
+class ExternalShuffler : public ShufflerBase{
+private:
+    // memory available to one merge - reader and writer buffers
+    std::size_t budgetBytes;
+    SpillFormat spillFormat;
+    // temp_shuffler sub-folder written by runShuffleOperation
+    std::string shuffleDirectory;
+
+public:
+    // explicit constructor - reads a temp_mapper sub-folder of sorted runs
+    ExternalShuffler(const std::string &mapper_directory, std::size_t budget_bytes, SpillFormat spill_format = SpillFormat::Text)
+            : ShufflerBase(mapper_directory), budgetBytes(budget_bytes), spillFormat(spill_format){
+    }
+
+    // Merges the runs into <input dir>/temp_shuffler/<file>/<file>.<run>
+    void runShuffleOperation() override{
+        std::filesystem::path mapperDirectory(this->getMapOutputDirectory());
+        if(!mapperDirectory.has_filename()){
+            mapperDirectory = mapperDirectory.parent_path();
+        }
+        std::filesystem::path shuffleDirectory = mapperDirectory.parent_path().parent_path() / "temp_shuffler" / mapperDirectory.filename();
+        std::error_code error;
+        std::filesystem::create_directories(shuffleDirectory, error);
+        if(error && !std::filesystem::is_directory(shuffleDirectory)){
+            throw std::runtime_error("Cannot create directory!: " + shuffleDirectory.string() + " - " + error.message());
+        }
+        std::vector<std::string> runs;
+        for(const auto &entry: std::filesystem::directory_iterator(mapperDirectory)){
+            if(entry.is_regular_file()){
+                runs.push_back(entry.path().string());
+            }
+        }
+        // merge neighbouring partitions - the order does not change the result, only makes runs reproducible
+        std::sort(runs.begin(), runs.end());
+        std::string prefix = (shuffleDirectory / mapperDirectory.filename()).string() + ".";
+        // the mapper runs are kept, like every temp_mapper file - intermediate passes remove their own inputs
+        runs = mergeRunPass(runs, prefix, this->spillFormat, this->budgetBytes, false);
+        for(unsigned pass = 1; runs.size() > mergeFanIn(this->budgetBytes); pass++){
+            runs = mergeRunPass(runs, prefix + "m" + std::to_string(pass) + ".", this->spillFormat, this->budgetBytes, true);
+        }
+        this->shuffleDirectory = shuffleDirectory.string();
+    }
+
+    // Getter - temp_shuffler sub-folder holding the merged runs
+    const std::string& getShuffleDirectory() const{
+        return this->shuffleDirectory;
+    }
+};
+
+#endif //MAPREDUCELIB_EXTERNALSHUFFLER_HPP
@@ -0,0 +1,430 @@
+/*
+ * Description: External sort-merge - sorted run files streamed through fixed-size buffers and a loser tree k-way merge
+ */
+#ifndef MAPREDUCELIB_EXTERNALSORT_HPP
+#define MAPREDUCELIB_EXTERNALSORT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "TokenCountTable.hpp"
+#include "SpillFormat.hpp"
+#include "TaskMetrics.hpp"
+
+// A sorted run holds (token, count) entries in ascending token order (std::string ordering), every token at most once.
+// Runs are only ever read front to back, so no run is held in memory - a writer costs one buffer, a reader two (the
+// unread tail of a chunk and the next chunk). The file streams are unbuffered, the run buffers are the only ones.
+// Text runs use the "(token,count)" line format. Binary runs use a streaming variant of the binary spill format:
+//  * magic        8 bytes  "MRSORTD1"
+//  * records, payload and checksum as in the binary spill header - filled in once the run is complete
+//  * payload      one record per entry: varint shared (bytes shared with the previous token), varint suffix,
+//                 suffix bytes, varint count
+// There is no dictionary - a sorted run never repeats a token, and prefix compression alone keeps it compact.
+constexpr char SORTED_RUN_MAGIC[8] = {'M', 'R', 'S', 'O', 'R', 'T', 'D', '1'};
+// buffer of a run reader or writer - a merge of k runs holds k reader buffers of twice this, and one writer buffer
+constexpr std::size_t RUN_BUFFER_BYTES = 64 * 1024;
+// smallest reader buffer - a merge of more runs than the budget allows for reads through buffers down to this
+constexpr std::size_t MIN_RUN_BUFFER_BYTES = 4096;
+// upper bound on the runs merged at once - every input of a merge holds a file descriptor
+constexpr std::size_t MAX_MERGE_FAN_IN = 256;
+
+// Helper - number of runs a single merge may read within a memory budget
+inline std::size_t mergeFanIn(std::size_t budget_bytes){
+    std::size_t readerBytes = budget_bytes > RUN_BUFFER_BYTES ? budget_bytes - RUN_BUFFER_BYTES : 0;
+    return std::clamp<std::size_t>(readerBytes / (2 * RUN_BUFFER_BYTES), 2, MAX_MERGE_FAN_IN);
+}
+
+// Helper - upper bound on the memory of a table that is written out as sorted runs, up to and including its next run:
+//  * the next insert may grow the slots (the old and the doubled array at once) and reallocate the arena (likewise)
+//  * sortedEntries() then adds one (view, count) pair per entry - the size of a slot, for at most 3/4 of the slots
+//  * the run writer adds its buffer
+// A table is cut into a run as soon as this exceeds the budget, so cutting never takes more than the budget.
+inline std::size_t runTablePeakBytes(const TokenCountTable &table){
+    std::size_t slotBytes = table.getSlotBytes();
+    std::size_t arenaBytes = table.getMemoryBytes() - slotBytes;
+    return slotBytes * 7 / 2 + arenaBytes * 3 + RUN_BUFFER_BYTES;
+}
+
+// Streams a sorted run to disk - entries must arrive in ascending token order
+class RunWriter{
+private:
+    std::string path;
+    std::ofstream output;
+    SpillFormat format;
+    std::string buffer;
+    std::uint64_t records = 0;
+    std::uint64_t payloadBytes = 0;
+    std::uint64_t checksum = TokenCountTable::hashToken(std::string_view());
+    std::string previousToken;
+    std::uint64_t bytesWritten = 0;
+
+    void flush(){
+        if(this->format == SpillFormat::Binary){
+            this->checksum = TokenCountTable::hashToken(this->buffer, this->checksum);
+            this->payloadBytes += this->buffer.size();
+        }
+        this->output.write(this->buffer.data(), static_cast<std::streamsize>(this->buffer.size()));
+        this->bytesWritten += this->buffer.size();
+        this->buffer.clear();
+    }
+
+public:
+    // Constructor - creates (or truncates) the run file
+    RunWriter(const std::string &run_path, SpillFormat run_format) : path(run_path), format(run_format){
+        this->output.rdbuf()->pubsetbuf(nullptr, 0);
+        this->output.open(run_path, std::ios::out | std::ios::trunc | std::ios::binary);
+        if(!this->output){
+            throw std::runtime_error("Cannot create sorted run!: " + run_path);
+        }
+        this->buffer.reserve(RUN_BUFFER_BYTES + 64);
+        if(this->format == SpillFormat::Binary){
+            // placeholder - finish() writes the header once the payload is known
+            this->output.write(std::string(SPILL_HEADER_BYTES, '\0').data(), SPILL_HEADER_BYTES);
+            this->bytesWritten += SPILL_HEADER_BYTES;
+        }
+    }
+
+    // Appends a (token, count) entry
+    void add(std::string_view token, std::uint64_t count){
+        if(this->format == SpillFormat::Binary){
+            std::size_t shared = 0;
+            std::size_t limit = std::min(token.size(), this->previousToken.size());
+            while(shared < limit && token[shared] == this->previousToken[shared]){
+                shared++;
+            }
+            appendVarint(this->buffer, shared);
+            appendVarint(this->buffer, token.size() - shared);
+            this->buffer.append(token.data() + shared, token.size() - shared);
+            appendVarint(this->buffer, count);
+            this->previousToken.assign(token.data(), token.size());
+        } else {
+            this->buffer += '(';
+            this->buffer.append(token.data(), token.size());
+            this->buffer += ',';
+            this->buffer += std::to_string(count);
+            this->buffer += ")\n";
+        }
+        this->records++;
+        if(this->buffer.size() >= RUN_BUFFER_BYTES){
+            this->flush();
+        }
+    }
+
+    // Writes out the buffer and, for binary runs, the header - the run is complete afterwards
+    void finish(){
+        this->flush();
+        if(this->format == SpillFormat::Binary){
+            char header[SPILL_HEADER_BYTES];
+            std::copy(SORTED_RUN_MAGIC, SORTED_RUN_MAGIC + 8, header);
+            storeLittleEndian64(header + 8, this->records);
+            storeLittleEndian64(header + 16, this->payloadBytes);
+            storeLittleEndian64(header + 24, this->checksum);
+            this->output.seekp(0);
+            this->output.write(header, SPILL_HEADER_BYTES);
+        }
+        this->output.close();
+        if(!this->output){
+            throw std::runtime_error("Cannot write sorted run!: " + this->path);
+        }
+        countTaskOutput(this->records, this->bytesWritten);
+    }
+
+    // Getter
+    std::uint64_t getRecordCount() const{
+        return this->records;
+    }
+};
+
+// Streams the entries of a sorted run of either format - a binary run is checked against its header once fully read
+class RunReader{
+private:
+    std::string path;
+    std::ifstream input;
+    std::size_t bufferBytes;
+    // unread bytes are buffer[position, buffer.size())
+    std::string buffer;
+    std::size_t position = 0;
+    bool endOfFile = false;
+    bool binary = false;
+    // header of a binary run, and what was actually read
+    std::uint64_t records = 0;
+    std::uint64_t payloadBytes = 0;
+    std::uint64_t checksum = 0;
+    std::uint64_t recordsRead = 0;
+    std::uint64_t bytesRead = 0;
+    std::uint64_t runningChecksum = TokenCountTable::hashToken(std::string_view());
+    // reported to the running task once the run is exhausted
+    std::uint64_t entriesRead = 0;
+    std::uint64_t fileBytes = 0;
+    bool reported = false;
+    // current entry
+    std::string token;
+    std::size_t count = 0;
+
+    // Reads the next chunk behind the unread bytes - false at the end of the file
+    bool refill(){
+        if(this->endOfFile){
+            return false;
+        }
+        this->buffer.erase(0, this->position);
+        this->position = 0;
+        std::size_t unread = this->buffer.size();
+        this->buffer.resize(unread + this->bufferBytes);
+        this->input.read(&this->buffer[unread], static_cast<std::streamsize>(this->bufferBytes));
+        auto chunk = static_cast<std::size_t>(this->input.gcount());
+        this->buffer.resize(unread + chunk);
+        this->fileBytes += chunk;
+        if(this->binary){
+            this->runningChecksum = TokenCountTable::hashToken(std::string_view(this->buffer).substr(unread), this->runningChecksum);
+            this->bytesRead += chunk;
+        }
+        if(chunk < this->bufferBytes){
+            this->endOfFile = true;
+        }
+        return chunk > 0;
+    }
+
+    // Makes at least bytes unread bytes available if the file still has them
+    void ensure(std::size_t bytes){
+        while(this->buffer.size() - this->position < bytes && this->refill()){
+        }
+    }
+
+    bool nextBinary(){
+        if(this->recordsRead == this->records){
+            this->ensure(1);
+            if(this->position != this->buffer.size() || this->bytesRead != this->payloadBytes){
+                throw std::runtime_error("Sorted run size does not match its header!: " + this->path);
+            }
+            if(this->runningChecksum != this->checksum){
+                throw std::runtime_error("Sorted run checksum mismatch!: " + this->path);
+            }
+            return false;
+        }
+        // two length varints - the suffix itself is requested once its length is known
+        this->ensure(20);
+        std::string_view view(this->buffer);
+        std::uint64_t shared = readVarint(view, this->position);
+        std::uint64_t suffix = readVarint(view, this->position);
+        if(shared > this->token.size()){
+            throw std::runtime_error("Corrupt sorted run record!: " + this->path);
+        }
+        this->ensure(static_cast<std::size_t>(suffix) + 10);
+        if(this->buffer.size() - this->position < suffix){
+            throw std::runtime_error("Truncated sorted run!: " + this->path);
+        }
+        this->token.resize(static_cast<std::size_t>(shared));
+        this->token.append(this->buffer, this->position, static_cast<std::size_t>(suffix));
+        this->position += static_cast<std::size_t>(suffix);
+        this->count = static_cast<std::size_t>(readVarint(this->buffer, this->position));
+        this->recordsRead++;
+        return true;
+    }
+
+    bool nextText(){
+        std::string_view line;
+        std::string_view lineToken;
+        while(true){
+            std::size_t end = this->buffer.find('\n', this->position);
+            if(end == std::string::npos && this->refill()){
+                continue;
+            }
+            if(this->position == this->buffer.size()){
+                return false;
+            }
+            // the last line may lack its '\n'
+            std::size_t lineEnd = end == std::string::npos ? this->buffer.size() : end;
+            line = std::string_view(this->buffer).substr(this->position, lineEnd - this->position);
+            this->position = end == std::string::npos ? lineEnd : end + 1;
+            // lines that do not follow the format are skipped, as aggregateTokenCountLines does
+            if(parseTokenCountLine(line, lineToken, this->count)){
+                this->token.assign(lineToken.data(), lineToken.size());
+                return true;
+            }
+        }
+    }
+
+public:
+    // Constructor - opens the run and detects its format; call next() for the first entry
+    explicit RunReader(const std::string &run_path, std::size_t buffer_bytes = RUN_BUFFER_BYTES)
+            : path(run_path), bufferBytes(std::max<std::size_t>(buffer_bytes, 64)){
+        this->input.rdbuf()->pubsetbuf(nullptr, 0);
+        this->input.open(run_path, std::ios::in | std::ios::binary);
+        if(!this->input){
+            throw std::runtime_error("Cannot open sorted run!: " + run_path);
+        }
+        this->buffer.reserve(this->bufferBytes * 2);
+        this->ensure(SPILL_HEADER_BYTES);
+        std::string_view view(this->buffer);
+        if(view.size() >= SPILL_HEADER_BYTES && view.compare(0, 8, SORTED_RUN_MAGIC, 8) == 0){
+            this->binary = true;
+            this->records = loadLittleEndian64(view.data() + 8);
+            this->payloadBytes = loadLittleEndian64(view.data() + 16);
+            this->checksum = loadLittleEndian64(view.data() + 24);
+            // the header is not part of the payload
+            this->position = SPILL_HEADER_BYTES;
+            std::string_view payload = view.substr(SPILL_HEADER_BYTES);
+            this->runningChecksum = TokenCountTable::hashToken(payload, this->runningChecksum);
+            this->bytesRead = payload.size();
+        } else if(isBinarySpill(view)){
+            throw std::runtime_error("Binary spill file is not a sorted run!: " + run_path);
+        }
+    }
+
+    // Advances to the next entry - false once the run is exhausted
+    bool next(){
+        bool advanced = false;
+        try{
+            advanced = this->binary ? this->nextBinary() : this->nextText();
+        } catch(std::runtime_error &error){
+            std::string message(error.what());
+            // errors of the record decoding do not know the file
+            if(message.find(this->path) == std::string::npos){
+                message += " " + this->path;
+            }
+            throw std::runtime_error(message);
+        }
+        if(advanced){
+            this->entriesRead++;
+        } else if(!this->reported){
+            countTaskInput(this->entriesRead, this->fileBytes);
+            this->reported = true;
+        }
+        return advanced;
+    }
+
+    // Current entry - valid after next() returned true
+    const std::string& getToken() const{
+        return this->token;
+    }
+    std::size_t getCount() const{
+        return this->count;
+    }
+};
+
+// k-way merge of sorted runs - equal tokens from different runs are summed into one entry
+// A loser tree finds the smallest head in log2(k) comparisons per entry: every inner node keeps the loser of the
+// match played there, the overall winner sits in tree[0], and advancing the winner replays its path to the root only.
+class RunMerger{
+private:
+    std::vector<std::unique_ptr<RunReader>> readers;
+    std::vector<bool> exhausted;
+    std::vector<std::size_t> tree;
+
+    // true if run a has the smaller head - exhausted runs lose every match, ties go to the lower index
+    bool beats(std::size_t a, std::size_t b) const{
+        if(this->exhausted[a] || this->exhausted[b]){
+            return !this->exhausted[a] && (this->exhausted[b] || a < b);
+        }
+        int order = this->readers[a]->getToken().compare(this->readers[b]->getToken());
+        return order < 0 || (order == 0 && a < b);
+    }
+
+    // Plays the matches below node - leaves are nodes k..2k-1, one per run; returns the winner
+    std::size_t build(std::size_t node){
+        std::size_t k = this->readers.size();
+        if(node >= k){
+            return node - k;
+        }
+        std::size_t left = this->build(2 * node);
+        std::size_t right = this->build(2 * node + 1);
+        if(this->beats(left, right)){
+            this->tree[node] = right;
+            return left;
+        }
+        this->tree[node] = left;
+        return right;
+    }
+
+public:
+    // Constructor - opens every run with a buffer of buffer_bytes
+    RunMerger(const std::vector<std::string> &run_paths, std::size_t buffer_bytes){
+        for(const std::string &runPath: run_paths){
+            this->readers.push_back(std::make_unique<RunReader>(runPath, buffer_bytes));
+            this->exhausted.push_back(!this->readers.back()->next());
+        }
+        this->tree.assign(std::max<std::size_t>(this->readers.size(), 1), 0);
+        if(!this->readers.empty()){
+            this->tree[0] = this->build(1);
+        }
+    }
+
+    // Calls emit(token, count) once per distinct token, in ascending token order
+    template<typename Emitter>
+    void merge(Emitter &&emit){
+        if(this->readers.empty()){
+            return;
+        }
+        std::size_t k = this->readers.size();
+        std::string pendingToken;
+        std::size_t pendingCount = 0;
+        bool pending = false;
+        while(!this->exhausted[this->tree[0]]){
+            std::size_t winner = this->tree[0];
+            RunReader &reader = *this->readers[winner];
+            if(pending && reader.getToken() == pendingToken){
+                pendingCount += reader.getCount();
+            } else {
+                if(pending){
+                    emit(std::string_view(pendingToken), pendingCount);
+                }
+                pendingToken = reader.getToken();
+                pendingCount = reader.getCount();
+                pending = true;
+            }
+            this->exhausted[winner] = !reader.next();
+            // replay the matches on the path of the advanced run
+            for(std::size_t node = (winner + k) / 2; node > 0; node /= 2){
+                if(this->beats(this->tree[node], winner)){
+                    std::swap(this->tree[node], winner);
+                }
+            }
+            this->tree[0] = winner;
+        }
+        if(pending){
+            emit(std::string_view(pendingToken), pendingCount);
+        }
+    }
+};
+
+// Helper - merges sorted runs into one run; a reader buffer is sized so that all inputs and the output fit budget_bytes
+inline void mergeSortedRuns(const std::vector<std::string> &run_paths, const std::string &output_path,
+                            SpillFormat format, std::size_t budget_bytes){
+    std::size_t readerBytes = budget_bytes > RUN_BUFFER_BYTES ? budget_bytes - RUN_BUFFER_BYTES : 0;
+    std::size_t bufferBytes = readerBytes / (2 * std::max<std::size_t>(run_paths.size(), 1));
+    RunMerger merger(run_paths, std::clamp(bufferBytes, MIN_RUN_BUFFER_BYTES, RUN_BUFFER_BYTES));
+    RunWriter writer(output_path, format);
+    merger.merge([&writer](std::string_view token, std::size_t count){
+        writer.add(token, count);
+    });
+    writer.finish();
+}
+
+// Helper - one merge pass: every group of at most fan_in runs becomes a single run named <prefix><group>
+// Returns the new runs; the inputs are removed when remove_inputs is set
+inline std::vector<std::string> mergeRunPass(const std::vector<std::string> &run_paths, const std::string &prefix,
+                                             SpillFormat format, std::size_t budget_bytes, bool remove_inputs){
+    std::size_t fanIn = mergeFanIn(budget_bytes);
+    std::vector<std::string> merged;
+    for(std::size_t first = 0; first < run_paths.size(); first += fanIn){
+        std::vector<std::string> group(run_paths.begin() + first,
+                                       run_paths.begin() + std::min(first + fanIn, run_paths.size()));
+        merged.push_back(prefix + std::to_string(merged.size()));
+        mergeSortedRuns(group, merged.back(), format, budget_bytes);
+        if(remove_inputs){
+            for(const std::string &runPath: group){
+                std::remove(runPath.c_str());
+            }
+        }
+    }
+    return merged;
+}
+
+#endif //MAPREDUCELIB_EXTERNALSORT_HPP
@@ -0,0 +1,92 @@
+/*
+ * Description: FileProcessor implementation that persists the TokenCountTables of NativeShuffler/NativeReducer
+ * Writes the same text layout as FileProcessorShufOutput/FileProcessorRedOutput - the tables are sorted here, once
+ * Shuffler output can be written as binary spill files instead; final_output is always text
+ * Tables keyed by token ID are written as ID spill files by the shuffler - the reducer resolves the tokens, once
+ */
+#ifndef MAPREDUCELIB_FILEPROCESSORAGGREGATEDOUTPUT_HPP
+#define MAPREDUCELIB_FILEPROCESSORAGGREGATEDOUTPUT_HPP
+
+#include "FileProcessorBase.hpp"
+#include "TokenCountTable.hpp"
+#include "AggregationResult.hpp"
+#include "SpillFormat.hpp"
+#include "AsyncFileWriter.hpp"
+
+class FileProcessorAggregatedOutput : public FileProcessorBase{
+private:
+    // tables being persisted
+    aggregatedOutput_t aggregatedOutput;
+    // format of the temp_shuffler files
+    SpillFormat spillFormat;
+    // with --async-output the files are handed to the writer instead of written here - nullptr writes them synchronously
+    AsyncFileWriter* asyncWriter;
+
+public:
+    // Constructor - operation is "shuffler" or "reducer"; takes ownership of the tables
+    FileProcessorAggregatedOutput(const std::string &operation, aggregatedOutput_t &&aggregated_output,
+                                  SpillFormat spill_format = SpillFormat::Text, AsyncFileWriter* async_writer = nullptr)
+            : aggregatedOutput(std::move(aggregated_output)), spillFormat(spill_format), asyncWriter(async_writer){
+        this->setOperation(operation);
+        if(operation != "shuffler" && operation != "reducer"){
+            throw std::runtime_error("Unsupported operation!: " + operation);
+        }
+        if(operation == "reducer" && spill_format != SpillFormat::Text){
+            throw std::runtime_error("Final output is always written as text!");
+        }
+    }
+
+    // Writes one "(token,count)" line (or binary record) per entry, in token order
+    void runOperation() override{
+        std::string buffer;
+        for(const AggregatedFile &file: this->aggregatedOutput){
+            std::filesystem::path outputPath(file.path);
+            this->createDirectory(outputPath.parent_path().string() + "/");
+            buffer.clear();
+            if(file.dictionary){
+                if(this->getOperation() == "shuffler"){
+                    // unordered - the reducer sorts once it has merged every partition
+                    IdSpillWriter writer(buffer);
+                    file.ids.forEachEntry([&writer](std::uint32_t id, std::size_t count){
+                        writer.add(id, count);
+                    });
+                    writer.finish();
+                } else {
+                    file.ids.appendSortedLines(buffer, *file.dictionary);
+                }
+            } else if(this->spillFormat == SpillFormat::Binary){
+                SpillWriter writer(buffer);
+                for(const auto &entry: file.table.sortedEntries()){
+                    writer.add(entry.first, entry.second);
+                }
+                writer.finish();
+            } else {
+                file.table.appendSortedLines(buffer);
+            }
+            std::size_t outputBytes = buffer.size();
+            if(this->asyncWriter){
+                JobPhase phase = this->getOperation() == "shuffler" ? JobPhase::ShuffleOutput : JobPhase::ReduceOutput;
+                this->asyncWriter->enqueue(phase, file.path, std::move(buffer));
+                buffer = std::string();
+            } else {
+                std::ofstream output(outputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+                output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                if(!output){
+                    throw std::runtime_error("Cannot write " + this->getOperation() + " output!: " + file.path);
+                }
+            }
+            tagTask(file.path);
+            countTaskInput(file.size(), file.getTokenBytes());
+            countTaskOutput(file.size(), outputBytes);
+            // same directories as the library processors report
+            if(this->getOperation() == "shuffler"){
+                this->setShufflerOutputDirectory(outputPath.parent_path().parent_path().string());
+            } else {
+                this->setFinalOutputDirectory(outputPath.parent_path().string());
+            }
+        }
+        this->aggregatedOutput.clear();
+    }
+};
+
+#endif //MAPREDUCELIB_FILEPROCESSORAGGREGATEDOUTPUT_HPP
@@ -13,7 +13,15 @@
 #include <fstream>
 #include <filesystem>
 #include <stdexcept>
-
+#include <mutex>
+#include <utility>
+
+// Concurrency contract:
+// Each instance is owned by a single task - its members are never shared with another instance.
+// Instances can therefore run runOperation concurrently without any external lock.
+// State shared across instances (the file system layout via createDirectory) is synchronised internally.
+// A plugin keeps the createDirectory of the header it was built against - one built before this lock existed must be
+// rebuilt, or find its directories in place (the driver creates them ahead of the prebuilt libs/fp writers).
 class FileProcessorBase{
 private:
     // directory operation - input for FileProcessInput implementation
@@ -82,6 +90,14 @@ public:
     std::map<std::string, std::vector<std::vector<std::string>>> getInputDirectoryData(){
         return this->inputDirectoryData;
     }
+    // Move variants - the setter takes ownership, take* hands the data over and leaves the member empty
+    // Inline and non-virtual, so libraries built against the previous header keep working
+    void setInputDirectoryData(std::map<std::string, std::vector<std::vector<std::string>>> &&inputData){
+        this->inputDirectoryData = std::move(inputData);
+    }
+    std::map<std::string, std::vector<std::vector<std::string>>> takeInputDirectoryData(){
+        return std::exchange(this->inputDirectoryData, {});
+    }
     // Setter - set the raw output from the Mapper
     void setRawMapperOutput(const std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> &raw_mapper_data){
         this->mapperRawOutput = raw_mapper_data;
@@ -90,6 +106,13 @@ public:
     std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> getRawMapperOutput(){
         return this->mapperRawOutput;
     }
+    // Move variants - raw mapper output
+    void setRawMapperOutput(std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> &&raw_mapper_data){
+        this->mapperRawOutput = std::move(raw_mapper_data);
+    }
+    std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> takeRawMapperOutput(){
+        return std::exchange(this->mapperRawOutput, {});
+    }
 
     // Setter - mapper output directory path
     void setMapperOutputDirectory(const std::string &mapper_output_directory){
@@ -108,6 +131,13 @@ public:
     std::vector<std::map<std::string, std::map<std::string,size_t>>> getRawShufflerOutput(){
         return this->shufflerRawOutput;
     }
+    // Move variants - raw shuffler output
+    void setRawShufflerOutput(std::vector<std::map<std::string, std::map<std::string,size_t>>> &&raw_shuffler_data){
+        this->shufflerRawOutput = std::move(raw_shuffler_data);
+    }
+    std::vector<std::map<std::string, std::map<std::string,size_t>>> takeRawShufflerOutput(){
+        return std::exchange(this->shufflerRawOutput, {});
+    }
 
     // Setter - shuffler output directory path
     void setShufflerOutputDirectory(const std::string &shuffler_output_directory){
@@ -125,6 +155,13 @@ public:
     std::map<std::string, std::map<std::string, size_t>> getRawReducerOutput(){
         return this->reducerRawOutput;
     }
+    // Move variants - raw reducer output
+    void setRawReducerOutput(std::map<std::string, std::map<std::string, size_t>> &&raw_reducer_data){
+        this->reducerRawOutput = std::move(raw_reducer_data);
+    }
+    std::map<std::string, std::map<std::string, size_t>> takeRawReducerOutput(){
+        return std::exchange(this->reducerRawOutput, {});
+    }
     // Setter - set the final output directory
     void setFinalOutputDirectory(const std::string &directory){
         this->finalOutputDirectory = directory;
@@ -135,12 +172,20 @@ public:
     }
 
     // Helper
+    // Thread-safe - several output tasks can target the same directory at the same time
     void createDirectory(const std::string &directory_path) {
+        // serialises the check-then-create across every instance in the process
+        static std::mutex directoryMutex;
+        std::lock_guard<std::mutex> directoryLock(directoryMutex);
         if (std::filesystem::exists(directory_path)) {
             std::cout << "The " << this->getOperation() <<  " directory: " << directory_path << " already exists! " << std::endl;
         } else {
-            // create directory!
-            std::filesystem::create_directories(directory_path);
+            // create directory! - tolerate a directory created by another process in the meantime
+            std::error_code error;
+            std::filesystem::create_directories(directory_path, error);
+            if (error && !std::filesystem::is_directory(directory_path)) {
+                throw std::runtime_error("Cannot create directory!: " + directory_path + " - " + error.message());
+            }
             std::cout << "Created the " << this->getOperation() << " directory: " << directory_path << std::endl;
         }
     }
@@ -0,0 +1,83 @@
+/*
+ * Description: FileProcessor implementation that persists a CompactMapperOutput to temp_mapper
+ * Writes the same text layout as FileProcessorMapOutput, so ShufflerImpl reads it unchanged - or a binary spill file
+ */
+#ifndef MAPREDUCELIB_FILEPROCESSORCOMPACTMAPOUTPUT_HPP
+#define MAPREDUCELIB_FILEPROCESSORCOMPACTMAPOUTPUT_HPP
+
+#include "FileProcessorBase.hpp"
+#include "CompactMapperOutput.hpp"
+#include "SpillFormat.hpp"
+#include "AsyncFileWriter.hpp"
+
+class FileProcessorCompactMapOutput : public FileProcessorBase{
+private:
+    // mapper result being persisted
+    CompactMapperOutput mapperOutput;
+    // format of the temp_mapper file
+    SpillFormat spillFormat;
+    // with --async-output the file is handed to the writer instead of written here - nullptr writes it synchronously
+    AsyncFileWriter* asyncWriter;
+
+public:
+    // Constructor - takes ownership of the mapper result
+    FileProcessorCompactMapOutput(const std::string &operation, CompactMapperOutput &&mapper_output,
+                                  SpillFormat spill_format = SpillFormat::Text, AsyncFileWriter* async_writer = nullptr)
+            : mapperOutput(std::move(mapper_output)), spillFormat(spill_format), asyncWriter(async_writer){
+        this->setOperation(operation);
+    }
+
+    // Writes <input dir>/temp_mapper/<file>/<file>.<partition> with one "(token,count)" line (or binary record) per token entry
+    // An interned output is always written as a token ID spill file
+    void runOperation() override{
+        const std::string &fileName = this->mapperOutput.getFileName();
+        std::string directory = fileName.substr(0, fileName.rfind('/') + 1);
+        std::string baseFileName = fileName.substr(fileName.rfind('/') + 1);
+        std::string mapperDirectory = directory + "temp_mapper/" + baseFileName + "/";
+        this->createDirectory(mapperDirectory);
+        // build the whole file in one buffer - a single write instead of one per token
+        std::string buffer;
+        buffer.reserve(this->mapperOutput.getArenaBytes() + this->mapperOutput.getTokenCount() * 6);
+        if(this->mapperOutput.hasTokenIds()){
+            // --token-ids - the tokens are already interned, only their IDs are written
+            IdSpillWriter writer(buffer);
+            for(std::size_t i = 0; i < this->mapperOutput.getTokenCount(); i++){
+                writer.add(this->mapperOutput.getTokenId(i), this->mapperOutput.getCount(i));
+            }
+            writer.finish();
+        } else if(this->spillFormat == SpillFormat::Binary){
+            SpillWriter writer(buffer);
+            for(std::size_t i = 0; i < this->mapperOutput.getTokenCount(); i++){
+                writer.add(this->mapperOutput.getToken(i), this->mapperOutput.getCount(i));
+            }
+            writer.finish();
+        } else {
+            for(std::size_t i = 0; i < this->mapperOutput.getTokenCount(); i++){
+                buffer += '(';
+                buffer += this->mapperOutput.getToken(i);
+                buffer += ',';
+                buffer += std::to_string(this->mapperOutput.getCount(i));
+                buffer += ")\n";
+            }
+        }
+        std::string outputFile = mapperDirectory + baseFileName + "." + std::to_string(this->mapperOutput.getPartitionNum());
+        std::size_t outputBytes = buffer.size();
+        if(this->asyncWriter){
+            this->asyncWriter->enqueue(JobPhase::MapOutput, outputFile, std::move(buffer));
+        } else {
+            std::ofstream output(outputFile, std::ios::out | std::ios::trunc | std::ios::binary);
+            output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if(!output){
+                throw std::runtime_error("Cannot write mapper output!: " + outputFile);
+            }
+        }
+        tagTask(fileName, this->mapperOutput.getPartitionNum());
+        countTaskInput(this->mapperOutput.getTokenCount(), this->mapperOutput.getArenaBytes());
+        countTaskOutput(this->mapperOutput.getTokenCount(), outputBytes);
+        // moved out rather than assigned over - assigning an empty string keeps the arena's allocation
+        CompactMapperOutput released(std::move(this->mapperOutput));
+        this->setMapperOutputDirectory(directory + "temp_mapper/");
+    }
+};
+
+#endif //MAPREDUCELIB_FILEPROCESSORCOMPACTMAPOUTPUT_HPP
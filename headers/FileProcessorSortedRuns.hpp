@@ -0,0 +1,69 @@
+/*
+ * Description: FileProcessor implementation that persists a CompactMapperOutput to temp_mapper as sorted runs
+ * Used by the external sort-merge shuffle - ExternalShuffler merges the runs without loading them
+ */
+#ifndef MAPREDUCELIB_FILEPROCESSORSORTEDRUNS_HPP
+#define MAPREDUCELIB_FILEPROCESSORSORTEDRUNS_HPP
+
+#include "FileProcessorBase.hpp"
+#include "CompactMapperOutput.hpp"
+#include "ExternalSort.hpp"
+
+class FileProcessorSortedRuns : public FileProcessorBase{
+private:
+    // mapper result being persisted
+    CompactMapperOutput mapperOutput;
+    // the aggregation table is written out as a run before its peak (see runTablePeakBytes) would exceed this
+    std::size_t runBudgetBytes;
+    // format of the runs
+    SpillFormat spillFormat;
+
+    void writeRun(const TokenCountTable &table, const std::string &run_path){
+        RunWriter writer(run_path, this->spillFormat);
+        for(const auto &entry: table.sortedEntries()){
+            writer.add(entry.first, entry.second);
+        }
+        writer.finish();
+    }
+
+public:
+    // Constructor - takes ownership of the mapper result
+    FileProcessorSortedRuns(const std::string &operation, CompactMapperOutput &&mapper_output, std::size_t run_budget_bytes,
+                            SpillFormat spill_format = SpillFormat::Text)
+            : mapperOutput(std::move(mapper_output)), runBudgetBytes(run_budget_bytes), spillFormat(spill_format){
+        this->setOperation(operation);
+    }
+
+    // Writes <input dir>/temp_mapper/<file>/<file>.<partition>.<run> - the token counts of the partition, aggregated and
+    // sorted; a partition whose distinct tokens do not fit the run budget is cut into several runs
+    void runOperation() override{
+        const std::string &fileName = this->mapperOutput.getFileName();
+        std::string directory = fileName.substr(0, fileName.rfind('/') + 1);
+        std::string baseFileName = fileName.substr(fileName.rfind('/') + 1);
+        std::string mapperDirectory = directory + "temp_mapper/" + baseFileName + "/";
+        this->createDirectory(mapperDirectory);
+        std::string runPrefix = mapperDirectory + baseFileName + "." + std::to_string(this->mapperOutput.getPartitionNum()) + ".";
+        TokenCountTable table;
+        std::size_t runs = 0;
+        for(std::size_t i = 0; i < this->mapperOutput.getTokenCount(); i++){
+            table.add(this->mapperOutput.getToken(i), this->mapperOutput.getCount(i));
+            if(runTablePeakBytes(table) > this->runBudgetBytes){
+                this->writeRun(table, runPrefix + std::to_string(runs++));
+                // a new table rather than clear() - the arena would keep its capacity, counted against every later run
+                table = TokenCountTable();
+            }
+        }
+        // an empty partition still leaves a (empty) run, as FileProcessorCompactMapOutput leaves an empty file
+        if(!table.empty() || runs == 0){
+            this->writeRun(table, runPrefix + std::to_string(runs));
+        }
+        // the runs were reported by their writers
+        tagTask(fileName, this->mapperOutput.getPartitionNum());
+        countTaskInput(this->mapperOutput.getTokenCount(), this->mapperOutput.getArenaBytes());
+        // moved out rather than assigned over - assigning an empty string keeps the arena's allocation
+        CompactMapperOutput released(std::move(this->mapperOutput));
+        this->setMapperOutputDirectory(directory + "temp_mapper/");
+    }
+};
+
+#endif //MAPREDUCELIB_FILEPROCESSORSORTEDRUNS_HPP
@@ -0,0 +1,92 @@
+/*
+ * Description: Shuffler implementation that consumes mapper results in memory - no temp_mapper round trip
+ */
+#ifndef MAPREDUCELIB_INMEMORYSHUFFLER_HPP
+#define MAPREDUCELIB_INMEMORYSHUFFLER_HPP
+
+#include "ShufflerBase.hpp"
+#include "CompactMapperOutput.hpp"
+#include "TokenCountTable.hpp"
+#include "TokenIdTable.hpp"
+#include "TaskMetrics.hpp"
+
+// Helper - temp_shuffler file that holds the shuffled data of one partition of an input file
+// Mirrors the layout produced by ShufflerImpl: <input dir>/temp_shuffler/<file>/<file>.<partition>
+inline std::string shuffleOutputPath(const std::string &input_file, int partition){
+    std::string directory = input_file.substr(0, input_file.rfind('/') + 1);
+    std::string baseFileName = input_file.substr(input_file.rfind('/') + 1);
+    return directory + "temp_shuffler/" + baseFileName + "/" + baseFileName + "." + std::to_string(partition);
+}
+
+// Helper - approximate heap footprint of a mapper result, used to enforce the in-memory budget
+inline std::size_t estimateMapperOutputBytes(const mapperOutput_t &mapper_output){
+    // rough cost of a std::map node holding the file name
+    const std::size_t nodeOverhead = 64;
+    std::size_t bytes = 0;
+    for(const auto &file: mapper_output){
+        bytes += nodeOverhead + file.first.capacity();
+        for(const auto &record: file.second){
+            bytes += sizeof(record) + record.capacity() * sizeof(std::tuple<std::string, int, int>);
+            for(const auto &token: record){
+                // short tokens live inside the std::string itself
+                if(std::get<0>(token).capacity() > 15){
+                    bytes += std::get<0>(token).capacity() + 1;
+                }
+            }
+        }
+    }
+    return bytes;
+}
+
+// Helper - aggregates every token entry of a compact mapper output into a table - reported as input of the running task
+inline void aggregateMapperOutput(const CompactMapperOutput &mapper_output, TokenCountTable &table){
+    for(std::size_t i = 0; i < mapper_output.getTokenCount(); i++){
+        table.add(mapper_output.getToken(i), mapper_output.getCount(i));
+    }
+    countTaskInput(mapper_output.getTokenCount(), mapper_output.getArenaBytes());
+}
+
+// Helper - same for an interned mapper output (--token-ids), keyed by token ID
+inline void aggregateMapperOutput(const CompactMapperOutput &mapper_output, TokenIdTable &table){
+    for(std::size_t i = 0; i < mapper_output.getTokenCount(); i++){
+        table.add(mapper_output.getTokenId(i), mapper_output.getCount(i));
+    }
+    countTaskInput(mapper_output.getTokenCount(), mapper_output.getArenaBytes());
+}
+
+class InMemoryShuffler : public ShufflerBase {
+private:
+    // mapper results of a single file, keyed by partition number
+    std::map<int, CompactMapperOutput> mapperPartitions;
+
+public:
+    // explicit constructor - takes the mapper results of a file instead of a temp_mapper sub-folder
+    explicit InMemoryShuffler(const std::map<int, mapperOutput_t> &mapper_partitions){
+        for(const auto &partition: mapper_partitions){
+            this->mapperPartitions.insert({partition.first, CompactMapperOutput::fromMapperOutput(partition.second, partition.first)});
+        }
+    }
+    // explicit constructor - takes ownership of compact mapper results without copying them
+    explicit InMemoryShuffler(std::map<int, CompactMapperOutput> &&mapper_partitions)
+            : mapperPartitions(std::move(mapper_partitions)){
+    }
+
+    // Aggregates every partition into its own (token -> count) map, exactly like ShufflerImpl does per temp_mapper file
+    void runShuffleOperation() override{
+        std::vector<std::map<std::string, std::map<std::string,size_t>>> shuffled;
+        for(const auto &partition: this->mapperPartitions){
+            const CompactMapperOutput &mapperOutput = partition.second;
+            // aggregate in the hash table - one string per distinct token, built once at the end
+            TokenCountTable tokenTable;
+            aggregateMapperOutput(mapperOutput, tokenTable);
+            std::map<std::string, std::map<std::string,size_t>> shuffledPartition;
+            shuffledPartition.insert({shuffleOutputPath(mapperOutput.getFileName(), partition.first), tokenTable.toMap()});
+            shuffled.push_back(std::move(shuffledPartition));
+        }
+        // mapper results are no longer needed once aggregated
+        this->mapperPartitions.clear();
+        this->setShuffledOutput(std::move(shuffled));
+    }
+};
+
+#endif //MAPREDUCELIB_INMEMORYSHUFFLER_HPP
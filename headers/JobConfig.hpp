@@ -0,0 +1,282 @@
+/*
+ * Description: Job configuration for the MapReduce driver - built from the command line arguments
+ */
+#ifndef MAPREDUCELIB_JOBCONFIG_HPP
+#define MAPREDUCELIB_JOBCONFIG_HPP
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <stdexcept>
+#include <vector>
+#include "SpillFormat.hpp"
+#include "Partitioner.hpp"
+#include "TaskSizing.hpp"
+#include "AsyncFileWriter.hpp"
+
+struct JobConfig{
+    // directory containing the files being processed
+    std::string inputDirectory;
+    // command line the configuration was built from, input directory first - worker processes rebuild it from this
+    std::vector<std::string> arguments;
+    // number of worker threads owned by the executor - fixed for the whole job
+    unsigned workerCount = defaultWorkerCount();
+    // hand mapper results straight to the shufflers instead of writing them to temp_mapper
+    bool inMemoryShuffle = false;
+    // upper bound on mapper results held in memory - files beyond it spill to temp_mapper
+    unsigned long long memoryBudgetBytes = 1ULL << 30;
+    // pipelined dataflow - each file moves to its next phase as soon as its own work is done
+    bool pipelined = false;
+    // map with the built-in NativeMapper, which keeps its output in the compact struct-of-arrays layout
+    bool compactMapOutput = false;
+    // shuffle and reduce with NativeShuffler/NativeReducer, which aggregate in hash tables and sort once on output
+    bool hashAggregation = false;
+    // pre-aggregate the token counts of every mapper result before it is written or retained
+    // implies hashAggregation - ShufflerImpl counts temp_mapper lines and ignores the combined counts
+    bool combine = false;
+    // map the input files instead of loading them through FileProcessorInput - partitions are byte ranges of the mapping
+    // implies compactMapOutput - only NativeMapper reads partitions that are not owned strings
+    bool mmapInput = false;
+    // format of the temp_mapper and temp_shuffler files written by the built-in processors
+    // binary implies compactMapOutput and hashAggregation - the library shufflers and reducers only read text
+    SpillFormat spillFormat = SpillFormat::Text;
+    // number of reducers - 0 keeps one shuffler and one reducer per input file (the library layout)
+    // R > 0 buckets the tokens of every file across R reducers, each writing final_output/part-<r>; implies hashAggregation
+    unsigned reducerCount = 0;
+    // token -> reducer function used when reducerCount > 0: "hash", "range" or "library" (the mapper library's partitionKey)
+    std::string partitioner = "hash";
+    // with reducerCount > 0, merge the reducers' results back into one final_output file per input file
+    bool perFileOutput = false;
+    // external sort-merge shuffle - mappers write sorted runs, shuffle and reduce merge them as streams
+    // implies pipelined and mmapInput; memory use follows sortBudgetBytes rather than the size of the input
+    bool externalSort = false;
+    // memory shared by the map-side run buffers and the merges of the external sort - split evenly across the workers
+    unsigned long long sortBudgetBytes = 64ULL << 20;
+    // map tasks sized by bytes instead of the 2000 record partitions of FileProcessorInput - partitions are re-cut to
+    // about taskBytes, and the partitions of small files are coalesced into one task
+    bool adaptivePartitioning = false;
+    // input bytes per map task - 0 derives it from the total input size and the worker count
+    unsigned long long taskBytes = 0;
+    // speculative execution - stragglers of the map and reduce phases get a backup attempt on an idle worker
+    // (staged workflow only - the driver launches the backups while it waits on a phase)
+    bool speculate = false;
+    // incremental re-run - only new and modified input files go through the job, the final_output files of unchanged
+    // ones are kept; the input files behind final_output are recorded in its manifest (JobManifest.hpp)
+    bool incremental = false;
+    // the built-in output processors hand their files to an AsyncFileWriter instead of writing them in the task
+    // (temp_mapper, temp_shuffler and final_output of the staged workflow, final_output of the pipelined one)
+    bool asyncOutput = false;
+    // I/O backend of the writer
+    WriteBackend writeBackend = WriteBackend::Auto;
+    // intern every token in a job-wide TokenDictionary as soon as it is mapped - shuffle and reduce aggregate 32-bit
+    // token IDs and the tokens are only looked up again when final_output is written; temp_mapper and temp_shuffler
+    // hold ID spill files. Implies compactMapOutput and hashAggregation
+    bool tokenIds = false;
+    // index every final_output file once it is written - final_output/index/<file>.idx (OutputIndex.hpp), read by MRLookup
+    bool indexOutput = false;
+    // number of worker processes - 0 runs every task in this process. N > 0 makes the driver a coordinator that runs
+    // the map, shuffle and reduce task of every file in one of N worker processes (WorkerCoordinator.hpp); the
+    // executor then holds one thread per worker process
+    unsigned processCount = 0;
+    // address space limit of every worker process - 0 leaves it unlimited
+    unsigned long long workerMemoryBytes = 0;
+    // file receiving the JSON job metrics, including one entry per task - the phase summary is always printed
+    std::string metricsJsonPath;
+    // file receiving the timeline of the job in the Chrome trace-event format - none is written when empty
+    std::string tracePath;
+
+    // One worker per core, falling back to a single worker if the core count is unknown
+    static unsigned defaultWorkerCount(){
+        unsigned cores = std::thread::hardware_concurrency();
+        return cores == 0 ? 1 : cores;
+    }
+
+    // Input bytes per map task for an input of total_input_bytes - 0 keeps the record partitions
+    std::size_t getTaskBytes(std::uintmax_t total_input_bytes) const{
+        if(!this->adaptivePartitioning){
+            return 0;
+        }
+        return this->taskBytes > 0 ? static_cast<std::size_t>(this->taskBytes) : chooseTaskBytes(total_input_bytes, this->workerCount);
+    }
+
+    // Share of sortBudgetBytes of a single task - every worker may be writing runs or merging at the same time
+    std::size_t getTaskSortBudget() const{
+        return static_cast<std::size_t>(std::max<unsigned long long>(this->sortBudgetBytes / this->workerCount, 1));
+    }
+};
+
+// Helper - parses a strictly positive integer option value
+inline unsigned long long parsePositiveOption(const std::string &option, const std::string &value){
+    std::size_t consumed = 0;
+    unsigned long long parsed = 0;
+    try{
+        parsed = std::stoull(value, &consumed);
+    } catch(std::logic_error &){
+        consumed = 0;
+    }
+    if(consumed != value.size() || value.empty() || value[0] == '-' || parsed == 0){
+        throw std::runtime_error("Invalid value for " + option + ": " + value);
+    }
+    return parsed;
+}
+
+// Helper - parses a byte count with an optional K/M/G suffix (powers of 1024)
+inline unsigned long long parseByteOption(const std::string &option, const std::string &value){
+    unsigned long long multiplier = 1;
+    std::string digits = value;
+    if(!digits.empty()){
+        switch(digits.back()){
+            case 'K': case 'k': multiplier = 1ULL << 10; break;
+            case 'M': case 'm': multiplier = 1ULL << 20; break;
+            case 'G': case 'g': multiplier = 1ULL << 30; break;
+            default: break;
+        }
+        if(multiplier != 1){
+            digits.pop_back();
+        }
+    }
+    return parsePositiveOption(option, digits) * multiplier;
+}
+
+// Helper - flags do not take a value
+inline void checkFlagOption(const std::string &option, const std::string &argument){
+    if(argument != option){
+        throw std::runtime_error("Option does not take a value!: " + argument);
+    }
+}
+
+// Builds the job configuration from the command line
+// Usage: MRExec <input_directory> [--workers=N] [--in-memory-shuffle] [--memory-budget=BYTES[K|M|G]] [--pipeline] [--compact-map-output] [--hash-aggregation] [--combine] [--mmap-input] [--spill-format=text|binary] [--reducers=R] [--partitioner=hash|range|library] [--per-file-output] [--external-sort] [--sort-budget=BYTES[K|M|G]] [--task-bytes=auto|BYTES[K|M|G]] [--speculate] [--incremental] [--async-output[=auto|uring|pwrite]] [--token-ids] [--index-output] [--processes=N] [--worker-memory=BYTES[K|M|G]] [--metrics-json=PATH] [--trace=PATH]
+inline JobConfig parseJobConfig(int argc, char* argv[]){
+    JobConfig config;
+    config.inputDirectory = argv[1];
+    config.arguments.assign(argv + 1, argv + argc);
+    for(int i = 2; i < argc; i++){
+        std::string argument(argv[i]);
+        std::string::size_type separator = argument.find('=');
+        std::string option = argument.substr(0, separator);
+        std::string value = separator == std::string::npos ? "" : argument.substr(separator + 1);
+        if(option == "--workers"){
+            config.workerCount = static_cast<unsigned>(parsePositiveOption(option, value));
+        } else if(option == "--in-memory-shuffle"){
+            checkFlagOption(option, argument);
+            config.inMemoryShuffle = true;
+        } else if(option == "--memory-budget"){
+            config.memoryBudgetBytes = parseByteOption(option, value);
+        } else if(option == "--pipeline"){
+            checkFlagOption(option, argument);
+            config.pipelined = true;
+        } else if(option == "--compact-map-output"){
+            checkFlagOption(option, argument);
+            config.compactMapOutput = true;
+        } else if(option == "--hash-aggregation"){
+            checkFlagOption(option, argument);
+            config.hashAggregation = true;
+        } else if(option == "--combine"){
+            checkFlagOption(option, argument);
+            config.combine = true;
+            config.hashAggregation = true;
+        } else if(option == "--mmap-input"){
+            checkFlagOption(option, argument);
+            config.mmapInput = true;
+            config.compactMapOutput = true;
+        } else if(option == "--spill-format"){
+            config.spillFormat = parseSpillFormat(value);
+            if(config.spillFormat == SpillFormat::Binary){
+                config.compactMapOutput = true;
+                config.hashAggregation = true;
+            }
+        } else if(option == "--reducers"){
+            config.reducerCount = static_cast<unsigned>(parsePositiveOption(option, value));
+            config.hashAggregation = true;
+        } else if(option == "--partitioner"){
+            parsePartitioner(value);
+            config.partitioner = value;
+        } else if(option == "--per-file-output"){
+            checkFlagOption(option, argument);
+            config.perFileOutput = true;
+        } else if(option == "--external-sort"){
+            checkFlagOption(option, argument);
+            config.externalSort = true;
+            config.pipelined = true;
+            config.mmapInput = true;
+            config.compactMapOutput = true;
+        } else if(option == "--sort-budget"){
+            config.sortBudgetBytes = parseByteOption(option, value);
+        } else if(option == "--task-bytes"){
+            config.adaptivePartitioning = true;
+            config.taskBytes = value == "auto" ? 0 : parseByteOption(option, value);
+            if(config.taskBytes > MAX_EXPLICIT_TASK_BYTES){
+                throw std::runtime_error("Invalid value for " + option + " (at most 1G): " + value);
+            }
+        } else if(option == "--speculate"){
+            checkFlagOption(option, argument);
+            config.speculate = true;
+        } else if(option == "--incremental"){
+            checkFlagOption(option, argument);
+            config.incremental = true;
+        } else if(option == "--async-output"){
+            config.asyncOutput = true;
+            config.writeBackend = argument == option ? WriteBackend::Auto : parseWriteBackend(value);
+        } else if(option == "--token-ids"){
+            checkFlagOption(option, argument);
+            config.tokenIds = true;
+            config.compactMapOutput = true;
+            config.hashAggregation = true;
+        } else if(option == "--index-output"){
+            checkFlagOption(option, argument);
+            config.indexOutput = true;
+        } else if(option == "--processes"){
+            config.processCount = static_cast<unsigned>(parsePositiveOption(option, value));
+        } else if(option == "--worker-memory"){
+            config.workerMemoryBytes = parseByteOption(option, value);
+        } else if(option == "--metrics-json"){
+            if(value.empty()){
+                throw std::runtime_error("Invalid value for " + option + ": " + value);
+            }
+            config.metricsJsonPath = value;
+        } else if(option == "--trace"){
+            if(value.empty()){
+                throw std::runtime_error("Invalid value for " + option + ": " + value);
+            }
+            config.tracePath = value;
+        } else {
+            throw std::runtime_error("Unsupported option!: " + argument);
+        }
+    }
+    if(config.reducerCount == 0 && (config.perFileOutput || config.partitioner != "hash")){
+        throw std::runtime_error("--partitioner and --per-file-output require --reducers");
+    }
+    // every reducer reads a key range of all files - that needs the shuffle barrier of the staged workflow
+    if(config.reducerCount > 0 && config.pipelined){
+        throw std::runtime_error("--reducers is not supported with --pipeline");
+    }
+    if(config.speculate && config.pipelined){
+        throw std::runtime_error("--speculate is not supported with --pipeline");
+    }
+    // a reducer partition mixes the tokens of every file - there is no per-file result to keep
+    if(config.incremental && config.reducerCount > 0){
+        throw std::runtime_error("--incremental is not supported with --reducers");
+    }
+    // the external sort never holds a whole file in memory - retaining mapper results would defeat it
+    if(config.externalSort && config.inMemoryShuffle){
+        throw std::runtime_error("--external-sort is not supported with --in-memory-shuffle");
+    }
+    // partitioners and the sorted runs of the external sort work on the token bytes
+    if(config.tokenIds && (config.reducerCount > 0 || config.externalSort)){
+        throw std::runtime_error("--token-ids is not supported with --reducers or --external-sort");
+    }
+    if(config.workerMemoryBytes > 0 && config.processCount == 0){
+        throw std::runtime_error("--worker-memory requires --processes");
+    }
+    // worker processes share nothing but the files of the job - retained mapper results, the token dictionary, the
+    // output writer and the backups and partitions planned by the driver all live in a single address space
+    if(config.processCount > 0 && (config.pipelined || config.inMemoryShuffle || config.reducerCount > 0 ||
+                                   config.speculate || config.tokenIds || config.asyncOutput)){
+        throw std::runtime_error("--processes is not supported with --pipeline, --external-sort, --in-memory-shuffle, "
+                                 "--reducers, --speculate, --token-ids or --async-output");
+    }
+    return config;
+}
+
+#endif //MAPREDUCELIB_JOBCONFIG_HPP
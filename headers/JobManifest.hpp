@@ -0,0 +1,162 @@
+/*
+ * Description: Manifest of the input files behind a final_output directory - lets an incremental run skip the files
+ * that did not change since the run that wrote it
+ */
+#ifndef MAPREDUCELIB_JOBMANIFEST_HPP
+#define MAPREDUCELIB_JOBMANIFEST_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "TokenCountTable.hpp"
+
+// Name of the manifest inside final_output - written last, after SUCCESS.ind, so it only exists next to a complete
+// output. A regular file beside final_output would be read as one more input file.
+constexpr const char* MANIFEST_FILE_NAME = "MANIFEST.tsv";
+// First line of the manifest - the digit is the format version
+constexpr const char* MANIFEST_HEADER = "MRMANIFEST1";
+
+// What a run knew about one input file
+struct ManifestEntry{
+    // base name - the name of its final_output file and of its temp_mapper and temp_shuffler sub-folders
+    std::string fileName;
+    std::uintmax_t size = 0;
+    // last write time, in nanoseconds of the file clock
+    long long modifiedNanos = 0;
+    // 64-bit FNV-1a of the contents
+    std::uint64_t contentHash = 0;
+};
+
+// Input files of a run, keyed by base name
+// One line per file: <content hash, hex> TAB <size> TAB <mtime ns> TAB <base name>
+class JobManifest{
+private:
+    std::map<std::string, ManifestEntry> entries;
+
+public:
+    // Default Constructor - no files
+    JobManifest(){};
+
+    // Loads the manifest of a final_output directory - an empty manifest if there is none
+    static JobManifest load(const std::string &final_directory){
+        JobManifest manifest;
+        std::string path = final_directory + "/" + MANIFEST_FILE_NAME;
+        std::ifstream input(path);
+        if(!input){
+            return manifest;
+        }
+        std::string line;
+        if(!std::getline(input, line) || line != MANIFEST_HEADER){
+            throw std::runtime_error("Unsupported manifest!: " + path);
+        }
+        while(std::getline(input, line)){
+            std::istringstream fields(line);
+            ManifestEntry entry;
+            fields >> std::hex >> entry.contentHash >> std::dec >> entry.size >> entry.modifiedNanos;
+            // the name is the rest of the line - it may hold spaces
+            if(!fields || fields.get() != '\t' || !std::getline(fields, entry.fileName) || entry.fileName.empty()){
+                throw std::runtime_error("Invalid manifest line in " + path + ": " + line);
+            }
+            manifest.entries[entry.fileName] = entry;
+        }
+        return manifest;
+    }
+
+    // Writes the manifest into a final_output directory - through a temporary file, so a crash never leaves half of one
+    void save(const std::string &final_directory) const{
+        std::string path = final_directory + "/" + MANIFEST_FILE_NAME;
+        std::string temporaryPath = path + ".tmp";
+        {
+            std::ofstream output(temporaryPath, std::ios::out | std::ios::trunc);
+            output << MANIFEST_HEADER << '\n';
+            for(const auto &entry: this->entries){
+                output << std::hex << entry.second.contentHash << std::dec << '\t' << entry.second.size << '\t'
+                       << entry.second.modifiedNanos << '\t' << entry.first << '\n';
+            }
+            if(!output.flush()){
+                throw std::runtime_error("Cannot write manifest!: " + temporaryPath);
+            }
+        }
+        if(std::rename(temporaryPath.c_str(), path.c_str()) != 0){
+            throw std::runtime_error("Cannot write manifest!: " + path);
+        }
+    }
+
+    // Describes an input file - the contents are only hashed when size and write time do not match the previous entry
+    // (nullptr: none), so an unchanged directory is checked without reading it; a touched but unchanged file still
+    // matches on its hash
+    static ManifestEntry describe(const std::filesystem::path &file, const ManifestEntry* previous){
+        ManifestEntry entry;
+        entry.fileName = file.filename().string();
+        entry.size = std::filesystem::file_size(file);
+        entry.modifiedNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::filesystem::last_write_time(file).time_since_epoch()).count();
+        if(previous && previous->size == entry.size && previous->modifiedNanos == entry.modifiedNanos){
+            entry.contentHash = previous->contentHash;
+            return entry;
+        }
+        entry.contentHash = hashFile(file);
+        return entry;
+    }
+
+    // Streamed 64-bit FNV-1a of a file
+    static std::uint64_t hashFile(const std::filesystem::path &file){
+        std::ifstream input(file, std::ios::in | std::ios::binary);
+        if(!input){
+            throw std::runtime_error("Cannot open file!: " + file.string());
+        }
+        std::uint64_t hash = TokenCountTable::hashToken("");
+        std::vector<char> buffer(1 << 20);
+        while(input){
+            input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            hash = TokenCountTable::hashToken(std::string_view(buffer.data(), input.gcount()), hash);
+        }
+        return hash;
+    }
+
+    // Whether the file described by entry is the one this manifest recorded - same size and contents
+    bool isUnchanged(const ManifestEntry &entry) const{
+        const ManifestEntry* previous = this->find(entry.fileName);
+        return previous && previous->size == entry.size && previous->contentHash == entry.contentHash;
+    }
+
+    // Entry of a base name - nullptr if the file is not in the manifest
+    const ManifestEntry* find(const std::string &file_name) const{
+        auto entry = this->entries.find(file_name);
+        return entry == this->entries.end() ? nullptr : &entry->second;
+    }
+
+    void add(const ManifestEntry &entry){
+        this->entries[entry.fileName] = entry;
+    }
+
+    std::size_t size() const{
+        return this->entries.size();
+    }
+};
+
+// Plan of an incremental run - which input files go through the job and which keep their final_output file
+// An inactive plan (the default, without --incremental) runs every file
+struct IncrementalPlan{
+    bool active = false;
+    // base names of the new and modified files - the only ones the job reads, maps, shuffles and reduces
+    std::set<std::string> runFiles;
+    // base names of the unchanged files - their final_output files, temp_mapper and temp_shuffler folders are kept
+    std::set<std::string> reusedFiles;
+    // manifest of the whole input directory - saved once the run succeeds
+    JobManifest manifest;
+
+    // Whether an input file, or a temp_mapper/temp_shuffler sub-folder named after one, belongs to this run
+    bool includes(const std::filesystem::path &path) const{
+        return !this->active || this->runFiles.count(path.filename().string()) > 0;
+    }
+};
+
+#endif //MAPREDUCELIB_JOBMANIFEST_HPP
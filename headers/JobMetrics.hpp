@@ -0,0 +1,318 @@
+/*
+ * Description: Job level metrics collected by mapReduceWorkflow
+ */
+#ifndef MAPREDUCELIB_JOBMETRICS_HPP
+#define MAPREDUCELIB_JOBMETRICS_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "JobPhase.hpp"
+#include "TaskMetrics.hpp"
+#include "WorkStealingPool.hpp"
+
+class JobMetrics{
+private:
+    // One blocking wait of the driver on a task result - the gaps at the stage barriers of the timeline
+    struct DriverWait{
+        JobPhase phase;
+        // seconds from job start
+        double startSeconds;
+        double seconds;
+    };
+
+    // time the driver spent blocked on the results of each phase
+    std::array<double, JOB_PHASE_COUNT> waitSeconds{};
+    // start of the job - metrics are created when the workflow starts
+    std::chrono::steady_clock::time_point jobStart = std::chrono::steady_clock::now();
+    // microseconds from job start until the first final output was written - 0 until then
+    std::atomic<long long> firstOutputMicros{0};
+    // microseconds from job start until the job finished
+    long long wallMicros = 0;
+    // collected from the executor at the end of the job
+    unsigned workerCount = 0;
+    std::vector<TaskMetrics> taskMetrics;
+    std::array<PhaseQueueStats, JOB_PHASE_COUNT> queueStats{};
+    // backup attempts launched by speculative execution, and how many of them finished first
+    std::array<std::size_t, JOB_PHASE_COUNT> backupsLaunched{};
+    std::array<std::size_t, JOB_PHASE_COUNT> backupWins{};
+    // seconds from job start to the executor's time base - shifts TaskMetrics::startSeconds onto the job's clock
+    double executorOffsetSeconds = 0;
+    // waits of the driver thread, in the order they happened
+    std::vector<DriverWait> driverWaits;
+    long driverThreadId = readThreadId();
+
+    long long elapsedMicros() const{
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->jobStart).count();
+    }
+
+    // Helper - writes a string as a JSON string literal
+    static void writeJsonString(std::ostream &out, const std::string &value){
+        out << '"';
+        for(char c: value){
+            if(c == '"' || c == '\\'){
+                out << '\\' << c;
+            } else if(static_cast<unsigned char>(c) < 0x20){
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    // Helper - writes one trace event of the job's process, timestamped in microseconds from job start
+    static void writeTraceEvent(std::ostream &out, const std::string &name, const char* category, char type,
+                                long thread_id, double seconds){
+        out << ",\n{\"name\":";
+        writeJsonString(out, name);
+        out << ",\"cat\":\"" << category << "\",\"ph\":\"" << type << "\",\"pid\":" << getpid()
+            << ",\"tid\":" << thread_id << ",\"ts\":" << seconds * 1e6;
+    }
+
+public:
+    // Accumulates driver wait time against a phase
+    void addWaitTime(JobPhase phase, double seconds){
+        this->waitSeconds[phaseIndex(phase)] += seconds;
+    }
+
+    // Getter - total driver wait time for a phase
+    double getWaitTime(JobPhase phase) const{
+        return this->waitSeconds[phaseIndex(phase)];
+    }
+
+    // Records the first final output of the job - safe to call from any task, only the first call counts
+    void recordFirstOutput(){
+        long long expected = 0;
+        this->firstOutputMicros.compare_exchange_strong(expected, std::max(this->elapsedMicros(), 1LL));
+    }
+
+    // Records the end of the job
+    void recordJobEnd(){
+        this->wallMicros = this->elapsedMicros();
+    }
+
+    // Getter - seconds until the first final output, 0 if none was written
+    double getTimeToFirstOutput() const{
+        return this->firstOutputMicros.load() / 1e6;
+    }
+
+    // Getter - seconds from job start to job end
+    double getWallTime() const{
+        return this->wallMicros / 1e6;
+    }
+
+    // Getter - peak resident set size of the process in kilobytes, 0 if unavailable
+    static long getPeakRssKilobytes(){
+        return readPeakRssKilobytes();
+    }
+
+    // Blocks on a task result and charges the wait to its phase
+    template<typename T>
+    T awaitResult(std::future<T> &result, JobPhase phase){
+        auto start = std::chrono::steady_clock::now();
+        T value = result.get();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        this->addWaitTime(phase, seconds);
+        this->driverWaits.push_back(DriverWait{phase, std::chrono::duration<double>(start - this->jobStart).count(), seconds});
+        return value;
+    }
+
+    // Blocks on a task result and charges the wait to its phase - while_waiting runs every millisecond until it is ready
+    template<typename T, typename F>
+    T awaitResult(std::future<T> &result, JobPhase phase, F while_waiting){
+        auto start = std::chrono::steady_clock::now();
+        while(result.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready){
+            while_waiting();
+        }
+        T value = result.get();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        this->addWaitTime(phase, seconds);
+        this->driverWaits.push_back(DriverWait{phase, std::chrono::duration<double>(start - this->jobStart).count(), seconds});
+        return value;
+    }
+
+    // Runs a barrier of the driver (a flush of the output writer) and charges its wait to a phase
+    template<typename F>
+    void awaitBarrier(JobPhase phase, F barrier){
+        auto start = std::chrono::steady_clock::now();
+        barrier();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        this->addWaitTime(phase, seconds);
+        this->driverWaits.push_back(DriverWait{phase, std::chrono::duration<double>(start - this->jobStart).count(), seconds});
+    }
+
+    // Records the outcome of speculative execution for a phase
+    void recordSpeculation(JobPhase phase, std::size_t launched, std::size_t won){
+        this->backupsLaunched[phaseIndex(phase)] += launched;
+        this->backupWins[phaseIndex(phase)] += won;
+    }
+
+    // Takes the task metrics and counters of the executor - call once every task of the job is done
+    void collectTaskMetrics(WorkStealingPool &pool){
+        this->workerCount = pool.getWorkerCount();
+        this->executorOffsetSeconds = std::chrono::duration<double>(pool.getStartTime() - this->jobStart).count();
+        std::vector<TaskMetrics> collected = pool.takeTaskMetrics();
+        this->taskMetrics.insert(this->taskMetrics.end(), collected.begin(), collected.end());
+        for(std::size_t i = 0; i < JOB_PHASE_COUNT; i++){
+            this->queueStats[i] = pool.getPhaseStats(static_cast<JobPhase>(i));
+        }
+    }
+
+    // Getter - metrics of every task collected so far
+    const std::vector<TaskMetrics>& getTaskMetrics() const{
+        return this->taskMetrics;
+    }
+
+    // Helper - writes the job summary as a JSON object: job totals, one entry per phase that ran (sums over its tasks,
+    // plus the executor counters and driver wait time) and, with include_tasks, one entry per task
+    void writeJson(std::ostream &out, bool include_tasks) const{
+        out << "{\"workers\":" << this->workerCount
+            << ",\"wall_seconds\":" << this->getWallTime()
+            << ",\"time_to_first_output_seconds\":" << this->getTimeToFirstOutput()
+            << ",\"peak_rss_kb\":" << getPeakRssKilobytes()
+            << ",\"phases\":{";
+        bool firstPhase = true;
+        for(std::size_t i = 0; i < JOB_PHASE_COUNT; i++){
+            const PhaseQueueStats &stats = this->queueStats[i];
+            if(stats.submitted == 0){
+                continue;
+            }
+            // totals over the tasks of the phase - the span runs from its first task start to its last task end
+            TaskMetrics total;
+            double firstStart = 0;
+            double lastEnd = 0;
+            std::size_t tasks = 0;
+            for(const TaskMetrics &task: this->taskMetrics){
+                if(phaseIndex(task.phase) != i){
+                    continue;
+                }
+                firstStart = tasks == 0 ? task.startSeconds : std::min(firstStart, task.startSeconds);
+                lastEnd = std::max(lastEnd, task.startSeconds + task.wallSeconds);
+                total.wallSeconds += task.wallSeconds;
+                total.cpuSeconds += task.cpuSeconds;
+                total.recordsIn += task.recordsIn;
+                total.recordsOut += task.recordsOut;
+                total.bytesIn += task.bytesIn;
+                total.bytesOut += task.bytesOut;
+                total.rssKilobytesAtEnd = std::max(total.rssKilobytesAtEnd, task.rssKilobytesAtEnd);
+                tasks++;
+            }
+            out << (firstPhase ? "" : ",") << "\"" << phaseName(static_cast<JobPhase>(i)) << "\":{"
+                << "\"tasks\":" << tasks
+                << ",\"stolen\":" << stats.stolen
+                << ",\"peak_queue_depth\":" << stats.peakQueueDepth
+                << ",\"wait_seconds\":" << this->waitSeconds[i]
+                << ",\"backups\":" << this->backupsLaunched[i]
+                << ",\"backup_wins\":" << this->backupWins[i]
+                << ",\"span_seconds\":" << (tasks == 0 ? 0 : lastEnd - firstStart)
+                << ",\"task_seconds\":" << total.wallSeconds
+                << ",\"cpu_seconds\":" << total.cpuSeconds
+                << ",\"records_in\":" << total.recordsIn
+                << ",\"records_out\":" << total.recordsOut
+                << ",\"bytes_in\":" << total.bytesIn
+                << ",\"bytes_out\":" << total.bytesOut
+                << ",\"rss_kb_at_end\":" << total.rssKilobytesAtEnd << "}";
+            firstPhase = false;
+        }
+        out << "}";
+        if(include_tasks){
+            out << ",\"tasks\":[";
+            for(std::size_t t = 0; t < this->taskMetrics.size(); t++){
+                const TaskMetrics &task = this->taskMetrics[t];
+                out << (t == 0 ? "" : ",") << "{\"phase\":\"" << phaseName(task.phase) << "\""
+                    << ",\"worker\":" << task.worker
+                    << ",\"file\":";
+                writeJsonString(out, task.file);
+                out << ",\"partition\":" << task.partition
+                    << ",\"start_seconds\":" << task.startSeconds
+                    << ",\"wall_seconds\":" << task.wallSeconds
+                    << ",\"cpu_seconds\":" << task.cpuSeconds
+                    << ",\"records_in\":" << task.recordsIn
+                    << ",\"records_out\":" << task.recordsOut
+                    << ",\"bytes_in\":" << task.bytesIn
+                    << ",\"bytes_out\":" << task.bytesOut
+                    << ",\"rss_kb_at_end\":" << task.rssKilobytesAtEnd << "}";
+            }
+            out << "]";
+        }
+        out << "}" << std::endl;
+    }
+
+    // Helper - writes the timeline of the job in the Chrome trace-event format (chrome://tracing, Perfetto)
+    // One track per executor worker, named after its kernel thread id, with a begin/end pair per task tagged with
+    // the file and partition it worked on; the driver's track shows where it blocked on a phase
+    void writeChromeTrace(std::ostream &out) const{
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+            << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"args\":{\"name\":\"MapReduce\"}}";
+        // thread names - the driver first, then the workers in order
+        std::vector<long> workerThreads(this->workerCount, 0);
+        for(const TaskMetrics &task: this->taskMetrics){
+            if(task.worker < workerThreads.size()){
+                workerThreads[task.worker] = task.threadId;
+            }
+        }
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"tid\":" << this->driverThreadId
+            << ",\"args\":{\"name\":\"driver\"}}";
+        out << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"tid\":" << this->driverThreadId
+            << ",\"args\":{\"sort_index\":-1}}";
+        for(std::size_t w = 0; w < workerThreads.size(); w++){
+            if(workerThreads[w] == 0){
+                continue;
+            }
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"tid\":" << workerThreads[w]
+                << ",\"args\":{\"name\":\"worker " << w << "\"}}";
+            out << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"tid\":" << workerThreads[w]
+                << ",\"args\":{\"sort_index\":" << w << "}}";
+        }
+        // the tasks of a worker never overlap, so the pairs nest trivially on each track
+        for(const TaskMetrics &task: this->taskMetrics){
+            double start = this->executorOffsetSeconds + task.startSeconds;
+            std::string name = phaseName(task.phase);
+            writeTraceEvent(out, name, "task", 'B', task.threadId, start);
+            out << "}";
+            writeTraceEvent(out, name, "task", 'E', task.threadId, start + task.wallSeconds);
+            out << ",\"args\":{\"file\":";
+            writeJsonString(out, task.file);
+            out << ",\"partition\":" << task.partition
+                << ",\"cpu_ms\":" << task.cpuSeconds * 1000.0
+                << ",\"records_in\":" << task.recordsIn
+                << ",\"records_out\":" << task.recordsOut
+                << ",\"bytes_in\":" << task.bytesIn
+                << ",\"bytes_out\":" << task.bytesOut << "}}";
+        }
+        for(const DriverWait &wait: this->driverWaits){
+            std::string name = std::string("wait ") + phaseName(wait.phase);
+            writeTraceEvent(out, name, "driver", 'B', this->driverThreadId, wait.startSeconds);
+            out << "}";
+            writeTraceEvent(out, name, "driver", 'E', this->driverThreadId, wait.startSeconds + wait.seconds);
+            out << "}";
+        }
+        out << "\n]}" << std::endl;
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    // Helper - prints the per-phase wait times in milliseconds
+    void printWaitTimes(std::ostream &out) const{
+        out << "Phase wait times:" << std::endl;
+        for(std::size_t i = 0; i < JOB_PHASE_COUNT; i++){
+            out << "  " << phaseName(static_cast<JobPhase>(i)) << ": "
+                << this->waitSeconds[i] * 1000.0 << " ms" << std::endl;
+        }
+        out << "Time to first output: " << this->getTimeToFirstOutput() * 1000.0 << " ms" << std::endl;
+        out << "Wall time: " << this->getWallTime() * 1000.0 << " ms" << std::endl;
+        out << "Peak RSS: " << getPeakRssKilobytes() << " KB" << std::endl;
+    }
+};
+
+#endif //MAPREDUCELIB_JOBMETRICS_HPP
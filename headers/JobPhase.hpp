@@ -0,0 +1,42 @@
+/*
+ * Description: Phases of the MapReduce workflow - shared by the executor and the driver bookkeeping
+ */
+#ifndef MAPREDUCELIB_JOBPHASE_HPP
+#define MAPREDUCELIB_JOBPHASE_HPP
+
+#include <cstddef>
+
+// Every task submitted by mapReduceWorkflow belongs to exactly one of these phases
+enum class JobPhase : std::size_t {
+    Input = 0,
+    Map,
+    MapOutput,
+    Shuffle,
+    ShuffleOutput,
+    Reduce,
+    ReduceOutput
+};
+
+// Number of phases - used to size per-phase counter arrays
+constexpr std::size_t JOB_PHASE_COUNT = 7;
+
+// Index of a phase within per-phase counter arrays
+inline std::size_t phaseIndex(JobPhase phase){
+    return static_cast<std::size_t>(phase);
+}
+
+// Printable name of a phase
+inline const char* phaseName(JobPhase phase){
+    switch(phase){
+        case JobPhase::Input: return "input";
+        case JobPhase::Map: return "map";
+        case JobPhase::MapOutput: return "map-output";
+        case JobPhase::Shuffle: return "shuffle";
+        case JobPhase::ShuffleOutput: return "shuffle-output";
+        case JobPhase::Reduce: return "reduce";
+        case JobPhase::ReduceOutput: return "reduce-output";
+    }
+    return "unknown";
+}
+
+#endif //MAPREDUCELIB_JOBPHASE_HPP
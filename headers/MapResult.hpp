@@ -0,0 +1,54 @@
+/*
+ * Description: Result of a single mapper task as handed between phases by the driver
+ */
+#ifndef MAPREDUCELIB_MAPRESULT_HPP
+#define MAPREDUCELIB_MAPRESULT_HPP
+
+#include "MapperBase.hpp"
+#include "CompactMapperOutput.hpp"
+#include "InMemoryShuffler.hpp"
+
+// Library mappers produce the nested mapperOutput_t, NativeMapper produces a CompactMapperOutput.
+// Exactly one of the two is populated, as indicated by compact.
+struct MapResult{
+    // originating partition number
+    int partitionNum = 0;
+    // true when compactOutput holds the result
+    bool compact = false;
+    mapperOutput_t nestedOutput;
+    CompactMapperOutput compactOutput;
+
+    // Getter - input file the result belongs to (empty if the mapper produced nothing)
+    std::string getFileName() const{
+        if(this->compact){
+            return this->compactOutput.getFileName();
+        }
+        return this->nestedOutput.empty() ? std::string() : this->nestedOutput.begin()->first;
+    }
+
+    // Approximate heap footprint - used to enforce the in-memory budget
+    std::size_t getMemoryBytes() const{
+        return this->compact ? this->compactOutput.getMemoryBytes() : estimateMapperOutputBytes(this->nestedOutput);
+    }
+
+    // Hands the result over in compact form - converting a nested result frees its per-token strings
+    CompactMapperOutput takeCompact(){
+        if(this->compact){
+            return std::move(this->compactOutput);
+        }
+        CompactMapperOutput converted = CompactMapperOutput::fromMapperOutput(this->nestedOutput, this->partitionNum);
+        this->nestedOutput.clear();
+        return converted;
+    }
+};
+
+// Helper - nested form of the compact results of a file, for shuffler libraries that export createInMemoryObj
+inline std::map<int, mapperOutput_t> toMapperPartitions(const std::map<int, CompactMapperOutput> &compact_partitions){
+    std::map<int, mapperOutput_t> mapperPartitions;
+    for(const auto &partition: compact_partitions){
+        mapperPartitions.insert({partition.first, partition.second.toMapperOutput()});
+    }
+    return mapperPartitions;
+}
+
+#endif //MAPREDUCELIB_MAPRESULT_HPP
@@ -0,0 +1,163 @@
+/*
+ * Description: Memory-mapped input file - zero-copy alternative to the partitions of FileProcessorInput
+ */
+#ifndef MAPREDUCELIB_MAPPEDINPUTFILE_HPP
+#define MAPREDUCELIB_MAPPEDINPUTFILE_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only private mapping of a whole input file - unmapped when the last owner goes away
+class MappedInputFile{
+private:
+    std::string fileName;
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+public:
+    // Initialization Constructor - maps the file, throws if it cannot be opened or mapped
+    // advice is the expected access pattern (madvise) - mappers walk their partitions front to back
+    explicit MappedInputFile(const std::string &file_name, int advice = MADV_SEQUENTIAL) : fileName(file_name){
+        int descriptor = open(file_name.c_str(), O_RDONLY);
+        if(descriptor < 0){
+            throw std::runtime_error("Cannot open file!: " + file_name + " - " + std::strerror(errno));
+        }
+        struct stat status{};
+        if(fstat(descriptor, &status) != 0){
+            int error = errno;
+            close(descriptor);
+            throw std::runtime_error("Cannot stat file!: " + file_name + " - " + std::strerror(error));
+        }
+        this->size = static_cast<std::size_t>(status.st_size);
+        // an empty file cannot be mapped - it simply has no partitions
+        if(this->size > 0){
+            void* mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if(mapping == MAP_FAILED){
+                int error = errno;
+                close(descriptor);
+                throw std::runtime_error("Cannot map file!: " + file_name + " - " + std::strerror(error));
+            }
+            madvise(mapping, this->size, advice);
+            this->data = static_cast<const char*>(mapping);
+        }
+        // the mapping stays valid once the descriptor is closed
+        close(descriptor);
+    }
+
+    // Not copyable - the mapping has a single owner
+    MappedInputFile(const MappedInputFile &) = delete;
+    MappedInputFile& operator=(const MappedInputFile &) = delete;
+
+    // Destructor
+    ~MappedInputFile(){
+        if(this->data){
+            munmap(const_cast<char*>(this->data), this->size);
+        }
+    }
+
+    // Drops the pages that lie entirely within [begin, end) from memory - for ranges that will not be read again
+    // The mapping stays valid: a dropped page is read back from the file if it is touched after all
+    void releaseRange(std::size_t begin, std::size_t end) const{
+        auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t first = (begin + pageSize - 1) / pageSize * pageSize;
+        std::size_t last = std::min(end, this->size) / pageSize * pageSize;
+        if(this->data && first < last){
+            madvise(const_cast<char*>(this->data) + first, last - first, MADV_DONTNEED);
+        }
+    }
+
+    // Getters
+    const std::string& getFileName() const{
+        return this->fileName;
+    }
+    std::string_view getContents() const{
+        return std::string_view(this->data, this->size);
+    }
+};
+
+// One partition of a mapped file - a byte range that starts at a record and ends after a '\n' (or at the end of the file)
+// Holds a reference to the mapping, so the mapping lives until every partition is mapped
+struct InputSlice{
+    std::shared_ptr<const MappedInputFile> file;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    // number of records in the range
+    std::size_t records = 0;
+
+    std::string_view getRecords() const{
+        return this->file->getContents().substr(this->begin, this->end - this->begin);
+    }
+
+    // Drops the pages of the slice from memory - pages shared with a neighbouring slice are kept
+    void release() const{
+        this->file->releaseRange(this->begin, this->end);
+    }
+};
+
+// Splits a mapped file into partitions of records_per_partition records - the same partitions FileProcessorInput builds,
+// without copying a single record
+// With release_scanned, every partition is dropped from memory once scanned - the scan then never holds the whole file
+inline std::vector<InputSlice> partitionMappedFile(const std::shared_ptr<const MappedInputFile> &file,
+                                                   std::size_t records_per_partition = 2000, bool release_scanned = false){
+    std::vector<InputSlice> partitions;
+    std::string_view contents = file->getContents();
+    std::size_t begin = 0;
+    std::size_t position = 0;
+    std::size_t records = 0;
+    while(position < contents.size()){
+        const void* newline = std::memchr(contents.data() + position, '\n', contents.size() - position);
+        position = newline ? static_cast<const char*>(newline) - contents.data() + 1 : contents.size();
+        if(++records == records_per_partition){
+            partitions.push_back(InputSlice{file, begin, position, records});
+            if(release_scanned){
+                partitions.back().release();
+            }
+            begin = position;
+            records = 0;
+        }
+    }
+    if(records > 0){
+        partitions.push_back(InputSlice{file, begin, contents.size(), records});
+    }
+    return partitions;
+}
+
+// Splits a mapped file into partitions of about bytes_per_partition bytes - every partition ends on the first line
+// boundary at or past the target, so lines of very different lengths still give partitions of similar work
+inline std::vector<InputSlice> partitionMappedFileBySize(const std::shared_ptr<const MappedInputFile> &file,
+                                                         std::size_t bytes_per_partition, bool release_scanned = false){
+    std::vector<InputSlice> partitions;
+    std::string_view contents = file->getContents();
+    std::size_t begin = 0;
+    while(begin < contents.size()){
+        std::size_t end = contents.size();
+        if(contents.size() - begin > bytes_per_partition){
+            std::size_t target = begin + bytes_per_partition - 1;
+            const void* newline = std::memchr(contents.data() + target, '\n', contents.size() - target);
+            end = newline ? static_cast<const char*>(newline) - contents.data() + 1 : contents.size();
+        }
+        // records are only counted for the job metrics - a line without '\n' at the end of the file counts too
+        std::size_t records = std::count(contents.data() + begin, contents.data() + end, '\n');
+        if(end == contents.size() && contents.back() != '\n'){
+            records++;
+        }
+        partitions.push_back(InputSlice{file, begin, end, records});
+        if(release_scanned){
+            partitions.back().release();
+        }
+        begin = end;
+    }
+    return partitions;
+}
+
+#endif //MAPREDUCELIB_MAPPEDINPUTFILE_HPP
@@ -10,7 +10,14 @@
 #include <vector>
 #include <map>
 #include <sstream>
+#include <utility>
 
+// Optional mapper-side combiner - see CombinerBase.hpp
+class CombinerBase;
+
+// Concurrency contract:
+// Each instance owns its partition and its output - nothing is shared between instances.
+// Different instances can run runMapOperation concurrently without any external lock.
 class MapperBase{
 // Private data members
 private:
@@ -43,6 +50,10 @@ public:
     void setProcessedFilePartition(const std::map<std::string, std::vector<std::string>> &processed_file_partition){
         this->processedFilePartition = processed_file_partition;
     }
+    // Move variant - takes ownership of the partition instead of copying it
+    void setProcessedFilePartition(std::map<std::string, std::vector<std::string>> &&processed_file_partition){
+        this->processedFilePartition = std::move(processed_file_partition);
+    }
 
     // This will set the partition num
     void setPartitionNum(const int partition_num){
@@ -54,6 +65,10 @@ public:
     void setMapperOutputData(const std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> &mapped_output){
         this->mapperOutput = mapped_output;
     }
+    // Move variant - takes ownership of the map output instead of copying it
+    void setMapperOutputData(std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> &&mapped_output){
+        this->mapperOutput = std::move(mapped_output);
+    }
 
     // Getters
     // This will retrieve the processedDirectory private data member within the Mapper object
@@ -71,15 +86,47 @@ public:
         return this->mapperOutput;
     }
 
+    // Take accessors - hand a data member over to the caller without copying it, leaving it empty
+    // Inline and non-virtual, so libraries built against the previous header keep working
+    std::map<std::string, std::vector<std::string>> takeProcessedFilePartition(){
+        return std::exchange(this->processedFilePartition, {});
+    }
+    std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> takeMapperOutput(){
+        return std::exchange(this->mapperOutput, {});
+    }
+
+    // Combiner hook - pre-aggregates the map output in place once runMapOperation is done
+    // Inline and non-virtual, so libraries built against the previous header keep working
+    template<typename Combiner>
+    void combineMapperOutput(Combiner &combiner){
+        combiner.combine(this->mapperOutput);
+    }
+
+    // Reset hook - returns a pooled instance to its default constructed state, so it can be handed the next partition
+    // Inline and non-virtual, so libraries built against the previous header keep working
+    void reset(){
+        this->partitionNum = 0;
+        this->processedFilePartition = {};
+        this->mapperOutput = {};
+    }
+
     // Virtual method to run operations
     // Primary method that will act on processed input data and create a map
     virtual void runMapOperation() = 0;
 
 };
 
+// the type of a single mapper result - file name -> records -> (token, count, partition)
+typedef std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> mapperOutput_t;
+
 // the types of the class factories
 typedef MapperBase* createMapper_t(const int partitionNum, const std::map<std::string, std::vector<std::string>> &inputPartition);
 typedef void destroyMapper_t(MapperBase*);
 
+// Optional factory - exported by a mapper library as createCombinerObj to supply its own combiner
+// mapReduceWorkflow falls back to TokenCountCombiner when the library lacks it
+typedef CombinerBase* createCombiner_t();
+typedef void destroyCombiner_t(CombinerBase*);
+
 
 #endif //MRHOPE_MAPPERBASE_H
@@ -0,0 +1,93 @@
+/*
+ * Description: Mapper implementation built into the driver - tokenizes straight into a CompactMapperOutput
+ */
+#ifndef MAPREDUCELIB_NATIVEMAPPER_HPP
+#define MAPREDUCELIB_NATIVEMAPPER_HPP
+
+#include "MapperBase.hpp"
+#include "CompactMapperOutput.hpp"
+#include "MappedInputFile.hpp"
+#include "Tokenizer.hpp"
+#include "TaskMetrics.hpp"
+
+// Concurrency contract: same as MapperBase - every instance owns its input and output
+class NativeMapper : public MapperBase{
+private:
+    // file the partition belongs to
+    std::string fileName;
+    // records of the partition - held here rather than in MapperBase so they can be moved in
+    std::vector<std::string> records;
+    // records of the partition as a slice of a mapped file - used instead of records when set
+    InputSlice slice;
+    // result of runMapOperation
+    CompactMapperOutput compactOutput;
+
+public:
+    // Initialization Constructor - same arguments as the createMapper_t factory
+    NativeMapper(const int partition_num, const std::map<std::string, std::vector<std::string>> &input_partition){
+        this->setPartitionNum(partition_num);
+        if(!input_partition.empty()){
+            this->fileName = input_partition.begin()->first;
+            this->records = input_partition.begin()->second;
+        }
+    }
+
+    // Initialization Constructor - takes ownership of the records
+    NativeMapper(const int partition_num, const std::string &file_name, std::vector<std::string> &&input_records)
+            : fileName(file_name), records(std::move(input_records)){
+        this->setPartitionNum(partition_num);
+    }
+
+    // Initialization Constructor - reads the records straight from a mapped file
+    NativeMapper(const int partition_num, InputSlice input_slice)
+            : fileName(input_slice.file->getFileName()), slice(std::move(input_slice)){
+        this->setPartitionNum(partition_num);
+    }
+
+    // Tokenizes every record - the result is only available through the compact accessors,
+    // getMapperOutput() stays empty so no nested copy is ever built
+    void runMapOperation() override{
+        this->compactOutput = CompactMapperOutput(this->fileName, this->getPartitionNum());
+        if(this->slice.file){
+            // records are the '\n' separated lines of the slice, as std::getline splits them
+            std::string_view contents = this->slice.getRecords();
+            this->compactOutput.reserve(contents.size() / 6 + 1, contents.size() + TOKENIZER_ARENA_SLACK);
+            // one kernel call for the whole slice - lines are split by the kernel, not before it
+            tokenizeRecords(contents.data(), contents.size(), this->compactOutput);
+            countTaskInput(this->slice.records, contents.size());
+            // every token is copied to the arena - the pages of the slice are not read again, so they need not stay
+            // resident until the whole file is unmapped
+            this->slice.release();
+            // drop the reference - the file is unmapped once its last partition is done
+            this->slice = InputSlice();
+        } else {
+            std::size_t bytes = 0;
+            for(const std::string &record: this->records){
+                bytes += record.size();
+            }
+            // roughly one token per six input bytes
+            this->compactOutput.reserve(bytes / 6 + 1, bytes + TOKENIZER_ARENA_SLACK);
+            for(const std::string &record: this->records){
+                tokenizeRecord(record.data(), record.size(), this->compactOutput);
+            }
+            countTaskInput(this->records.size(), bytes);
+        }
+        // the reservation is sized on the input - trim it to what the tokens actually use
+        this->compactOutput.shrinkToFit();
+        // the input is no longer needed once mapped
+        this->records.clear();
+        this->records.shrink_to_fit();
+    }
+
+    // Getter - compact output of runMapOperation
+    const CompactMapperOutput& getCompactOutput() const{
+        return this->compactOutput;
+    }
+
+    // Hands the compact output over to the caller without copying it
+    CompactMapperOutput takeCompactOutput(){
+        return std::move(this->compactOutput);
+    }
+};
+
+#endif //MAPREDUCELIB_NATIVEMAPPER_HPP
@@ -0,0 +1,90 @@
+/*
+ * Description: Reducer implementation built into the driver - merges a temp_shuffler sub-folder in a TokenCountTable
+ */
+#ifndef MAPREDUCELIB_NATIVEREDUCER_HPP
+#define MAPREDUCELIB_NATIVEREDUCER_HPP
+
+#include "ReducerBase.hpp"
+#include "TokenCountTable.hpp"
+#include "AggregationResult.hpp"
+#include "SpillFormat.hpp"
+
+// Produces the same final_output file as ReducerImpl, but the result is only available through
+// takeAggregatedOutput() - getReducedOutput() stays empty so no std::map is ever built.
+// With setTokenDictionary() it reads ID spill files and aggregates by token ID - tokens are resolved on output.
+// Concurrency contract: same as ReducerBase
+class NativeReducer : public ReducerBase{
+private:
+    // result of runReduceOperations - a single final_output file, or one per input file with perFileOutput
+    aggregatedOutput_t aggregatedOutput;
+    // keep the files of the sub-folder apart - used for the part-<r> folders of a partitioned job
+    bool perFileOutput = false;
+    // --token-ids - dictionary of the job, nullptr aggregates by token
+    const TokenDictionary* dictionary = nullptr;
+
+    // Empty result for one final_output file - keyed by token ID when the job has a dictionary
+    AggregatedFile makeAggregatedFile(const std::string &path) const{
+        AggregatedFile file{path, TokenCountTable()};
+        file.dictionary = this->dictionary;
+        return file;
+    }
+
+    // Aggregates one temp_shuffler file into the result
+    void aggregateFile(const std::string &file_path, AggregatedFile &file) const{
+        if(file.dictionary){
+            aggregateIdSpillFile(file_path, file.ids);
+        } else {
+            aggregateSpillFile(file_path, file.table);
+        }
+    }
+
+public:
+    // explicit constructor - reads a temp_shuffler sub-folder, like ReducerImpl (text or binary spill files)
+    explicit NativeReducer(const std::string &parent_shuffle_directory) : ReducerBase(parent_shuffle_directory){
+    }
+    // explicit constructor - with per_file_output, every file of the sub-folder is reduced to final_output/<file>
+    // on its own; the driver merges the tables of a file that come from different reducers
+    NativeReducer(const std::string &parent_shuffle_directory, bool per_file_output)
+            : ReducerBase(parent_shuffle_directory), perFileOutput(per_file_output){
+    }
+
+    // Switches to aggregation by token ID - the temp_shuffler files must be ID spill files of token_dictionary
+    void setTokenDictionary(const TokenDictionary* token_dictionary){
+        this->dictionary = token_dictionary;
+    }
+
+    // Merges every partition file of the sub-folder into <input dir>/final_output/<file>
+    // (<file> is the sub-folder name - part-<r> in a partitioned job)
+    void runReduceOperations() override{
+        std::filesystem::path shuffleDirectory(this->getShuffleOutputDirectory());
+        if(!shuffleDirectory.has_filename()){
+            shuffleDirectory = shuffleDirectory.parent_path();
+        }
+        std::filesystem::path finalDirectory = shuffleDirectory.parent_path().parent_path() / "final_output";
+        this->aggregatedOutput.clear();
+        if(this->perFileOutput){
+            for(const auto &entry: std::filesystem::directory_iterator(shuffleDirectory)){
+                if(entry.is_regular_file()){
+                    AggregatedFile reduced = this->makeAggregatedFile((finalDirectory / entry.path().filename()).string());
+                    this->aggregateFile(entry.path().string(), reduced);
+                    this->aggregatedOutput.push_back(std::move(reduced));
+                }
+            }
+            return;
+        }
+        AggregatedFile reduced = this->makeAggregatedFile((finalDirectory / shuffleDirectory.filename()).string());
+        for(const auto &entry: std::filesystem::directory_iterator(shuffleDirectory)){
+            if(entry.is_regular_file()){
+                this->aggregateFile(entry.path().string(), reduced);
+            }
+        }
+        this->aggregatedOutput.push_back(std::move(reduced));
+    }
+
+    // Hands the aggregated output over to the caller without copying it
+    aggregatedOutput_t takeAggregatedOutput(){
+        return std::exchange(this->aggregatedOutput, {});
+    }
+};
+
+#endif //MAPREDUCELIB_NATIVEREDUCER_HPP
@@ -0,0 +1,164 @@
+/*
+ * Description: Shuffler implementation built into the driver - aggregates in a TokenCountTable instead of a std::map
+ */
+#ifndef MAPREDUCELIB_NATIVESHUFFLER_HPP
+#define MAPREDUCELIB_NATIVESHUFFLER_HPP
+
+#include "ShufflerBase.hpp"
+#include "InMemoryShuffler.hpp"
+#include "TokenCountTable.hpp"
+#include "AggregationResult.hpp"
+#include "SpillFormat.hpp"
+#include "Partitioner.hpp"
+
+// Produces the same temp_shuffler files as ShufflerImpl (one per temp_mapper file), but the result is only
+// available through takeAggregatedOutput() - getShuffledOutput() stays empty so no std::map is ever built.
+// With setPartitioning() it writes one file per reducer instead (temp_shuffler/part-<r>/<file>).
+// With setTokenDictionary() it reads interned mapper output / ID spill files and aggregates by token ID.
+// Concurrency contract: same as ShufflerBase
+class NativeShuffler : public ShufflerBase{
+private:
+    // mapper results handed over in memory - empty when reading a temp_mapper sub-folder
+    std::map<int, CompactMapperOutput> mapperPartitions;
+    bool inMemory = false;
+    // result of runShuffleOperation
+    aggregatedOutput_t aggregatedOutput;
+    // partitioned mode - tokens are bucketed across reducerCount reducers instead of kept per temp_mapper file
+    partitionKey_t* partitioner = nullptr;
+    std::size_t reducerCount = 0;
+    // --token-ids - dictionary of the job, nullptr aggregates by token
+    const TokenDictionary* dictionary = nullptr;
+
+    // Empty result for one output file - keyed by token ID when the job has a dictionary
+    AggregatedFile makeAggregatedFile(const std::string &path) const{
+        AggregatedFile file{path, TokenCountTable()};
+        file.dictionary = this->dictionary;
+        return file;
+    }
+
+    // Aggregates one temp_mapper file into the result
+    void aggregateFile(const std::string &file_path, AggregatedFile &file) const{
+        if(file.dictionary){
+            aggregateIdSpillFile(file_path, file.ids);
+        } else {
+            aggregateSpillFile(file_path, file.table);
+        }
+    }
+
+    // temp_mapper sub-folder of a file -> <input dir>/temp_shuffler/<file>/
+    static std::filesystem::path shuffleDirectoryOf(std::filesystem::path mapper_directory){
+        if(!mapper_directory.has_filename()){
+            mapper_directory = mapper_directory.parent_path();
+        }
+        return mapper_directory.parent_path().parent_path() / "temp_shuffler" / mapper_directory.filename();
+    }
+
+    // Partitioned mode - aggregates the whole file once, then splits the distinct tokens across the reducers
+    // Every reducer gets a table, empty or not, so that every part-<r> folder lists every file
+    void runPartitionedShuffle(){
+        TokenCountTable fileTable;
+        std::filesystem::path shuffleRoot;
+        std::string baseFileName;
+        if(this->inMemory){
+            for(const auto &partition: this->mapperPartitions){
+                aggregateMapperOutput(partition.second, fileTable);
+                if(baseFileName.empty()){
+                    std::filesystem::path inputFile(partition.second.getFileName());
+                    shuffleRoot = inputFile.parent_path() / "temp_shuffler";
+                    baseFileName = inputFile.filename().string();
+                }
+            }
+            this->mapperPartitions.clear();
+        } else {
+            std::filesystem::path shuffleDirectory = shuffleDirectoryOf(this->getMapOutputDirectory());
+            shuffleRoot = shuffleDirectory.parent_path();
+            baseFileName = shuffleDirectory.filename().string();
+            for(const auto &entry: std::filesystem::directory_iterator(this->getMapOutputDirectory())){
+                if(entry.is_regular_file()){
+                    aggregateSpillFile(entry.path().string(), fileTable);
+                }
+            }
+        }
+        if(baseFileName.empty()){
+            return;
+        }
+        for(std::size_t reducer = 0; reducer < this->reducerCount; reducer++){
+            this->aggregatedOutput.push_back(AggregatedFile{
+                    (shuffleRoot / reducerPartitionName(reducer) / baseFileName).string(), TokenCountTable()});
+        }
+        fileTable.forEachEntry([this](std::string_view token, std::size_t count){
+            std::size_t reducer = this->partitioner(token, this->reducerCount);
+            if(reducer >= this->reducerCount){
+                throw std::runtime_error("Partitioner returned reducer " + std::to_string(reducer) + " of "
+                                         + std::to_string(this->reducerCount) + "!");
+            }
+            this->aggregatedOutput[reducer].table.add(token, count);
+        });
+    }
+
+public:
+    // explicit constructor - reads a temp_mapper sub-folder, like ShufflerImpl (text or binary spill files)
+    explicit NativeShuffler(const std::string &mapper_directory) : ShufflerBase(mapper_directory){
+    }
+    // explicit constructor - takes ownership of the compact mapper results of a file
+    explicit NativeShuffler(std::map<int, CompactMapperOutput> &&mapper_partitions)
+            : mapperPartitions(std::move(mapper_partitions)), inMemory(true){
+    }
+
+    // Switches to partitioned mode - the file's tokens go to reducer_count tables, one per reducer:
+    // <input dir>/temp_shuffler/part-<r>/<file>
+    void setPartitioning(partitionKey_t* key_partitioner, std::size_t reducer_count){
+        if(!key_partitioner || reducer_count == 0){
+            throw std::runtime_error("Partitioning needs a partitioner and at least one reducer!");
+        }
+        this->partitioner = key_partitioner;
+        this->reducerCount = reducer_count;
+    }
+
+    // Switches to aggregation by token ID - the mapper output must be interned in token_dictionary
+    // Not supported together with partitioning - partitioners route by token
+    void setTokenDictionary(const TokenDictionary* token_dictionary){
+        this->dictionary = token_dictionary;
+    }
+
+    // One table per temp_mapper file (partition) of the file - or one per reducer in partitioned mode
+    void runShuffleOperation() override{
+        this->aggregatedOutput.clear();
+        if(this->partitioner){
+            if(this->dictionary){
+                throw std::runtime_error("Partitioned shuffle does not support token IDs!");
+            }
+            this->runPartitionedShuffle();
+            return;
+        }
+        if(this->inMemory){
+            for(const auto &partition: this->mapperPartitions){
+                AggregatedFile shuffled = this->makeAggregatedFile(shuffleOutputPath(partition.second.getFileName(), partition.first));
+                if(shuffled.dictionary){
+                    aggregateMapperOutput(partition.second, shuffled.ids);
+                } else {
+                    aggregateMapperOutput(partition.second, shuffled.table);
+                }
+                this->aggregatedOutput.push_back(std::move(shuffled));
+            }
+            this->mapperPartitions.clear();
+            return;
+        }
+        std::filesystem::path shuffleDirectory = shuffleDirectoryOf(this->getMapOutputDirectory());
+        for(const auto &entry: std::filesystem::directory_iterator(this->getMapOutputDirectory())){
+            if(!entry.is_regular_file()){
+                continue;
+            }
+            AggregatedFile shuffled = this->makeAggregatedFile((shuffleDirectory / entry.path().filename()).string());
+            this->aggregateFile(entry.path().string(), shuffled);
+            this->aggregatedOutput.push_back(std::move(shuffled));
+        }
+    }
+
+    // Hands the aggregated output over to the caller without copying it
+    aggregatedOutput_t takeAggregatedOutput(){
+        return std::exchange(this->aggregatedOutput, {});
+    }
+};
+
+#endif //MAPREDUCELIB_NATIVESHUFFLER_HPP
@@ -0,0 +1,285 @@
+/*
+ * Description: Sorted binary index over a final_output file - point and prefix lookups through a memory mapping,
+ * without parsing the text file
+ */
+#ifndef MAPREDUCELIB_OUTPUTINDEX_HPP
+#define MAPREDUCELIB_OUTPUTINDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TokenCountTable.hpp"
+#include "SpillFormat.hpp"
+#include "MappedInputFile.hpp"
+
+// Sub-folder of final_output holding the indexes - a folder, so the file checks of SUCCESS.ind never see them
+constexpr const char* OUTPUT_INDEX_DIRECTORY = "index";
+// Index of final_output/<file> is final_output/index/<file>.idx
+constexpr const char* OUTPUT_INDEX_SUFFIX = ".idx";
+// Entries per fence pointer - a lookup binary searches the fences, then at most this many entries
+constexpr std::size_t OUTPUT_INDEX_FENCE_INTERVAL = 64;
+
+// Index file layout - every integer is a little-endian uint64:
+//  * header       64 bytes
+//      magic "MRINDEX1" (the digit is the format version), entries, fence interval, fences, keys offset, keys bytes,
+//      size and 64-bit FNV-1a of the final_output file the index was built from
+//  * entries      32 bytes each, in ascending token order - key offset, key length, line offset in final_output, count
+//  * fences       16 bytes each, one per fence interval entries - offset and length of its key in the fence keys
+//  * fence keys   the first token of every fence interval, back to back - the fences and their keys are a few KiB
+//                 that stay cached, so a cold lookup touches the pages of one interval only
+//  * keys         every token, back to back
+// Tokens compare as unsigned bytes - the order of final_output.
+constexpr char OUTPUT_INDEX_MAGIC[8] = {'M', 'R', 'I', 'N', 'D', 'E', 'X', '1'};
+constexpr std::size_t OUTPUT_INDEX_HEADER_BYTES = 64;
+constexpr std::size_t OUTPUT_INDEX_ENTRY_BYTES = 32;
+constexpr std::size_t OUTPUT_INDEX_FENCE_BYTES = 16;
+
+// Helper - index file of a final_output file
+inline std::filesystem::path outputIndexPath(const std::filesystem::path &output_file){
+    return output_file.parent_path() / OUTPUT_INDEX_DIRECTORY / (output_file.filename().string() + OUTPUT_INDEX_SUFFIX);
+}
+
+// Helper - builds the index of a final_output file held in memory
+// Throws on a line that is not "(token,count)" or a token that is out of order
+inline std::string buildOutputIndex(std::string_view output){
+    std::string entries;
+    std::string fences;
+    std::string fenceKeys;
+    std::string keys;
+    std::string_view previous;
+    std::uint64_t entryCount = 0;
+    std::size_t position = 0;
+    while(position < output.size()){
+        std::size_t end = output.find('\n', position);
+        if(end == std::string_view::npos){
+            end = output.size();
+        }
+        std::string_view line = output.substr(position, end - position);
+        std::string_view token;
+        std::size_t count = 0;
+        if(!parseTokenCountLine(line, token, count)){
+            throw std::runtime_error("Invalid final output line at byte " + std::to_string(position) + "!");
+        }
+        // std::string_view compares through char_traits<char>, i.e. as unsigned bytes
+        if(entryCount > 0 && !(previous < token)){
+            throw std::runtime_error("Final output is not sorted at byte " + std::to_string(position) + "!");
+        }
+        if(entryCount % OUTPUT_INDEX_FENCE_INTERVAL == 0){
+            char fence[OUTPUT_INDEX_FENCE_BYTES];
+            storeLittleEndian64(fence, fenceKeys.size());
+            storeLittleEndian64(fence + 8, token.size());
+            fences.append(fence, sizeof(fence));
+            fenceKeys.append(token.data(), token.size());
+        }
+        char entry[OUTPUT_INDEX_ENTRY_BYTES];
+        storeLittleEndian64(entry, keys.size());
+        storeLittleEndian64(entry + 8, token.size());
+        storeLittleEndian64(entry + 16, position);
+        storeLittleEndian64(entry + 24, count);
+        entries.append(entry, sizeof(entry));
+        keys.append(token.data(), token.size());
+        previous = token;
+        entryCount++;
+        position = end + 1;
+    }
+    std::uint64_t fenceCount = fences.size() / OUTPUT_INDEX_FENCE_BYTES;
+    std::uint64_t keysOffset = OUTPUT_INDEX_HEADER_BYTES + entries.size() + fences.size() + fenceKeys.size();
+    std::string index(OUTPUT_INDEX_HEADER_BYTES, '\0');
+    std::copy(OUTPUT_INDEX_MAGIC, OUTPUT_INDEX_MAGIC + 8, &index[0]);
+    storeLittleEndian64(&index[8], entryCount);
+    storeLittleEndian64(&index[16], OUTPUT_INDEX_FENCE_INTERVAL);
+    storeLittleEndian64(&index[24], fenceCount);
+    storeLittleEndian64(&index[32], keysOffset);
+    storeLittleEndian64(&index[40], keys.size());
+    storeLittleEndian64(&index[48], output.size());
+    storeLittleEndian64(&index[56], TokenCountTable::hashToken(output));
+    index.reserve(keysOffset + keys.size());
+    index += entries;
+    index += fences;
+    index += fenceKeys;
+    index += keys;
+    return index;
+}
+
+// Helper - builds final_output/index/<file>.idx for a final_output file; returns the number of entries
+// Written through a temporary file and renamed, so a reader never maps half of an index
+inline std::size_t writeOutputIndex(const std::string &output_file){
+    std::string output = readWholeFile(output_file);
+    std::string index;
+    try{
+        index = buildOutputIndex(output);
+    } catch(std::runtime_error &error){
+        throw std::runtime_error(std::string(error.what()) + " " + output_file);
+    }
+    std::filesystem::path indexPath = outputIndexPath(output_file);
+    std::filesystem::create_directories(indexPath.parent_path());
+    std::string temporaryPath = indexPath.string() + ".tmp";
+    {
+        std::ofstream stream(temporaryPath, std::ios::out | std::ios::trunc | std::ios::binary);
+        stream.write(index.data(), static_cast<std::streamsize>(index.size()));
+        if(!stream.flush()){
+            throw std::runtime_error("Cannot write output index!: " + temporaryPath);
+        }
+    }
+    if(std::rename(temporaryPath.c_str(), indexPath.c_str()) != 0){
+        throw std::runtime_error("Cannot write output index!: " + indexPath.string());
+    }
+    countTaskInput(0, output.size());
+    countTaskOutput(loadLittleEndian64(index.data() + 8), index.size());
+    return static_cast<std::size_t>(loadLittleEndian64(index.data() + 8));
+}
+
+// One entry of an index - token is a view into the mapping of its OutputIndex
+struct OutputIndexEntry{
+    std::string_view token;
+    std::size_t count = 0;
+    // byte offset of the "(token,count)" line in final_output
+    std::uint64_t outputOffset = 0;
+};
+
+// Read-only view of an index file - the file is mapped, never read as a whole
+// Lookups are O(log n): a binary search over the fences, then over the entries of a single fence interval
+// Thread safe: every method is const and the mapping is immutable
+class OutputIndex{
+private:
+    std::unique_ptr<MappedInputFile> file;
+    const char* data = nullptr;
+    std::uint64_t entryCount = 0;
+    std::uint64_t fenceInterval = 0;
+    std::uint64_t fenceCount = 0;
+    const char* entries = nullptr;
+    const char* fences = nullptr;
+    const char* fenceKeys = nullptr;
+    const char* keys = nullptr;
+    std::uint64_t keysBytes = 0;
+    std::uint64_t fenceKeysBytes = 0;
+    std::uint64_t outputBytes = 0;
+    std::uint64_t outputHash = 0;
+
+    // Key of a (offset, length) record within a key section - checked on access rather than when the index is
+    // opened, so opening never touches more than the header
+    static std::string_view keyAt(const char* record, const char* section, std::uint64_t section_bytes){
+        std::uint64_t offset = loadLittleEndian64(record);
+        std::uint64_t length = loadLittleEndian64(record + 8);
+        if(offset > section_bytes || length > section_bytes - offset){
+            throw std::runtime_error("Corrupt output index!");
+        }
+        return std::string_view(section + offset, length);
+    }
+
+    std::string_view keyOf(std::uint64_t index) const{
+        return keyAt(this->entries + index * OUTPUT_INDEX_ENTRY_BYTES, this->keys, this->keysBytes);
+    }
+
+    std::string_view fenceKeyOf(std::uint64_t fence) const{
+        return keyAt(this->fences + fence * OUTPUT_INDEX_FENCE_BYTES, this->fenceKeys, this->fenceKeysBytes);
+    }
+
+public:
+    // Initialization Constructor - maps an index file and checks its layout
+    explicit OutputIndex(const std::string &index_file)
+            : file(std::make_unique<MappedInputFile>(index_file, MADV_RANDOM)){
+        std::string_view contents = this->file->getContents();
+        if(contents.size() < OUTPUT_INDEX_HEADER_BYTES
+           || contents.compare(0, sizeof(OUTPUT_INDEX_MAGIC), OUTPUT_INDEX_MAGIC, sizeof(OUTPUT_INDEX_MAGIC)) != 0){
+            throw std::runtime_error("Not an output index!: " + index_file);
+        }
+        this->data = contents.data();
+        this->entryCount = loadLittleEndian64(this->data + 8);
+        this->fenceInterval = loadLittleEndian64(this->data + 16);
+        this->fenceCount = loadLittleEndian64(this->data + 24);
+        std::uint64_t keysOffset = loadLittleEndian64(this->data + 32);
+        this->keysBytes = loadLittleEndian64(this->data + 40);
+        this->outputBytes = loadLittleEndian64(this->data + 48);
+        this->outputHash = loadLittleEndian64(this->data + 56);
+        std::uint64_t fencesOffset = OUTPUT_INDEX_HEADER_BYTES + this->entryCount * OUTPUT_INDEX_ENTRY_BYTES;
+        std::uint64_t fenceKeysOffset = fencesOffset + this->fenceCount * OUTPUT_INDEX_FENCE_BYTES;
+        if(this->fenceInterval == 0 || this->entryCount > contents.size() / OUTPUT_INDEX_ENTRY_BYTES
+           || this->fenceCount != (this->entryCount + this->fenceInterval - 1) / this->fenceInterval
+           || fenceKeysOffset > keysOffset || keysOffset > contents.size()
+           || this->keysBytes != contents.size() - keysOffset){
+            throw std::runtime_error("Corrupt output index!: " + index_file);
+        }
+        this->entries = this->data + OUTPUT_INDEX_HEADER_BYTES;
+        this->fences = this->data + fencesOffset;
+        this->fenceKeys = this->data + fenceKeysOffset;
+        this->fenceKeysBytes = keysOffset - fenceKeysOffset;
+        this->keys = this->data + keysOffset;
+    }
+
+    // Number of entries - distinct tokens of the final_output file
+    std::size_t size() const{
+        return static_cast<std::size_t>(this->entryCount);
+    }
+    // Size and 64-bit FNV-1a of the final_output file the index was built from
+    std::uint64_t getOutputBytes() const{
+        return this->outputBytes;
+    }
+    std::uint64_t getOutputHash() const{
+        return this->outputHash;
+    }
+
+    // Entry at a position in token order
+    OutputIndexEntry entry(std::size_t index) const{
+        const char* record = this->entries + index * OUTPUT_INDEX_ENTRY_BYTES;
+        return OutputIndexEntry{this->keyOf(index), static_cast<std::size_t>(loadLittleEndian64(record + 24)),
+                                loadLittleEndian64(record + 16)};
+    }
+
+    // Position of the first entry whose token is not less than key - size() if there is none
+    std::size_t lowerBound(std::string_view key) const{
+        // last fence whose key is not greater than key - the entries before its interval are all less than key
+        std::uint64_t low = 0;
+        std::uint64_t high = this->fenceCount;
+        while(low < high){
+            std::uint64_t middle = low + (high - low) / 2;
+            if(this->fenceKeyOf(middle) <= key){
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        std::uint64_t first = low == 0 ? 0 : (low - 1) * this->fenceInterval;
+        std::uint64_t last = std::min(this->entryCount, first + this->fenceInterval);
+        while(first < last){
+            std::uint64_t middle = first + (last - first) / 2;
+            if(this->keyOf(middle) < key){
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        return static_cast<std::size_t>(first);
+    }
+
+    // Entry of a token - empty if the token is not in the file
+    std::optional<OutputIndexEntry> find(std::string_view token) const{
+        std::size_t position = this->lowerBound(token);
+        if(position < this->entryCount && this->keyOf(position) == token){
+            return this->entry(position);
+        }
+        return std::nullopt;
+    }
+
+    // Entries whose token starts with prefix, in token order - at most limit of them (0: no limit)
+    std::vector<OutputIndexEntry> findPrefix(std::string_view prefix, std::size_t limit = 0) const{
+        std::vector<OutputIndexEntry> matches;
+        for(std::size_t position = this->lowerBound(prefix); position < this->entryCount; position++){
+            if(this->keyOf(position).substr(0, prefix.size()) != prefix || (limit > 0 && matches.size() == limit)){
+                break;
+            }
+            matches.push_back(this->entry(position));
+        }
+        return matches;
+    }
+};
+
+#endif //MAPREDUCELIB_OUTPUTINDEX_HPP
@@ -0,0 +1,50 @@
+/*
+ * Description: Partitioners - assign every token to one of R reducers when the job runs with --reducers=R
+ */
+#ifndef MAPREDUCELIB_PARTITIONER_HPP
+#define MAPREDUCELIB_PARTITIONER_HPP
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "TokenCountTable.hpp"
+
+// Maps a token to a reducer in [0, reducer_count) - must be a pure function of its arguments
+// A mapper library may export its own as partitionKey (--partitioner=library)
+typedef std::size_t partitionKey_t(std::string_view token, std::size_t reducer_count);
+
+// Hash partitioner - spreads tokens evenly whatever their distribution; every part file is sorted on its own
+inline std::size_t hashPartition(std::string_view token, std::size_t reducer_count){
+    return static_cast<std::size_t>(TokenCountTable::hashToken(token) % reducer_count);
+}
+
+// Range partitioner - splits the byte range of the first token byte evenly, so the part files in order form one
+// sorted output; the load follows the distribution of first letters
+inline std::size_t rangePartition(std::string_view token, std::size_t reducer_count){
+    std::size_t firstByte = token.empty() ? 0 : static_cast<unsigned char>(token.front());
+    return firstByte * reducer_count / 256;
+}
+
+// Helper - built-in partitioner of a --partitioner value; nullptr for "library", which the driver resolves
+inline partitionKey_t* parsePartitioner(const std::string &value){
+    if(value == "hash"){
+        return hashPartition;
+    }
+    if(value == "range"){
+        return rangePartition;
+    }
+    if(value == "library"){
+        return nullptr;
+    }
+    throw std::runtime_error("Unsupported partitioner!: " + value);
+}
+
+// Helper - name of the temp_shuffler sub-folder and final_output file of a reducer: part-00000, part-00001, ...
+inline std::string reducerPartitionName(std::size_t reducer){
+    char name[32];
+    std::snprintf(name, sizeof(name), "part-%05zu", reducer);
+    return name;
+}
+
+#endif //MAPREDUCELIB_PARTITIONER_HPP
@@ -0,0 +1,230 @@
+/*
+ * Description: Registry of the plugin libraries of a job - loads every library once, owns the handles, and pools the
+ * Mapper/Shuffler/Reducer instances the libraries create so a job builds a handful of them instead of one per task
+ */
+#ifndef MAPREDUCELIB_PLUGINREGISTRY_HPP
+#define MAPREDUCELIB_PLUGINREGISTRY_HPP
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <dlfcn.h>
+#include "FileProcessorBase.hpp"
+#include "MapperBase.hpp"
+#include "ReducerBase.hpp"
+#include "ShufflerBase.hpp"
+
+// Idle instances a pool keeps at most - tasks acquire their instance when they start, so at most one instance per
+// worker is ever idle; anything beyond this goes back to its library
+constexpr std::size_t PLUGIN_POOL_IDLE_LIMIT = 64;
+
+// Whether instances of a base class can be pooled - it has a reset
+template<typename Base, typename = void>
+struct IsPoolable : std::false_type{};
+template<typename Base>
+struct IsPoolable<Base, std::void_t<decltype(std::declval<Base&>().reset())>> : std::true_type{};
+
+// Instances of one plugin base class - every object handed back through release is accounted for:
+//  - pooled: created through acquire by the pool's library - reset and kept for the next acquire
+//  - adopted: created by a library outside the pool (e.g. by an optional factory, or a FileProcessor) - destroyed
+//    through the removeInputObj of the library that created it
+//  - anything else is a built-in class of the driver and is deleted
+// Base::reset must bring an instance back to its default constructed state - see MapperBase, ShufflerBase and
+// ReducerBase; a base without one can only adopt. Thread safe: tasks acquire and release concurrently.
+template<typename Base, typename Destroy>
+class PluginPool{
+private:
+    std::mutex mutex;
+    // removeInputObj of the library behind acquire - nullptr until setDestroy
+    Destroy* destroy = nullptr;
+    std::vector<Base*> idle;
+    std::unordered_set<Base*> pooled;
+    std::unordered_map<Base*, Destroy*> adopted;
+    std::size_t created = 0;
+    std::size_t reused = 0;
+
+public:
+    PluginPool() = default;
+    PluginPool(const PluginPool &) = delete;
+    PluginPool& operator=(const PluginPool &) = delete;
+
+    // Destructor - the idle instances go back to their library; the library must still be loaded
+    ~PluginPool(){
+        this->drain();
+    }
+
+    // Setter - the destroy function of the library whose instances are pooled
+    void setDestroy(Destroy* destroy_function){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->destroy = destroy_function;
+    }
+
+    // Hands out an idle instance, or a new one from create when none is idle - the caller sets the task's inputs
+    Base* acquire(const std::function<Base*()> &create){
+        static_assert(IsPoolable<Base>::value, "Instances without a reset cannot be pooled!");
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if(!this->destroy){
+                throw std::runtime_error("Plugin pool has no destroy function!");
+            }
+            if(!this->idle.empty()){
+                Base* obj = this->idle.back();
+                this->idle.pop_back();
+                this->reused++;
+                return obj;
+            }
+        }
+        // outside the lock - a library constructor may take a while
+        Base* obj = create();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pooled.insert(obj);
+        this->created++;
+        return obj;
+    }
+
+    // Takes an instance created by a library outside the pool - release destroys it through destroy_function
+    Base* adopt(Base* obj, Destroy* destroy_function){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->adopted[obj] = destroy_function;
+        return obj;
+    }
+
+    // Hands an instance back once its results are taken - see the class comment for what happens to it
+    void release(Base* obj){
+        if(!obj){
+            return;
+        }
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if constexpr(IsPoolable<Base>::value){
+            if(this->pooled.count(obj) > 0){
+                lock.unlock();
+                // frees whatever the task left behind before the instance sits idle
+                obj->reset();
+                lock.lock();
+                if(this->idle.size() < PLUGIN_POOL_IDLE_LIMIT){
+                    this->idle.push_back(obj);
+                    return;
+                }
+                this->pooled.erase(obj);
+                lock.unlock();
+                this->destroy(obj);
+                return;
+            }
+        }
+        auto entry = this->adopted.find(obj);
+        if(entry != this->adopted.end()){
+            Destroy* destroy_function = entry->second;
+            this->adopted.erase(entry);
+            lock.unlock();
+            destroy_function(obj);
+            return;
+        }
+        lock.unlock();
+        delete obj;
+    }
+
+    // Destroys the idle instances - instances still out are left alone
+    void drain(){
+        std::vector<Base*> instances;
+        Destroy* destroy_function;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            instances.swap(this->idle);
+            for(Base* obj: instances){
+                this->pooled.erase(obj);
+            }
+            destroy_function = this->destroy;
+        }
+        for(Base* obj: instances){
+            destroy_function(obj);
+        }
+    }
+
+    // Getters - instances created through acquire, and acquires served by an idle instance
+    std::size_t getCreated(){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->created;
+    }
+    std::size_t getReused(){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->reused;
+    }
+};
+
+// Libraries and pooled instances of the running job - a single registry per process (see instance)
+// The driver opens every library through open, hands each plugin object back through the matching pool's release
+// as soon as its results are taken, and calls close once the job is done
+class PluginRegistry{
+private:
+    std::mutex mutex;
+    // library file -> dlopen handle
+    std::map<std::string, void*> handles;
+
+public:
+    PluginPool<MapperBase, destroyMapper_t> mappers;
+    PluginPool<ShufflerBase, destroyShuffler_t> shufflers;
+    PluginPool<ReducerBase, destroyReducer_t> reducers;
+    // FileProcessors have no reset - they are only adopted, and destroyed once written out
+    PluginPool<FileProcessorBase, destroy_t> fileProcessors;
+
+    PluginRegistry() = default;
+    PluginRegistry(const PluginRegistry &) = delete;
+    PluginRegistry& operator=(const PluginRegistry &) = delete;
+
+    // The registry of the process
+    static PluginRegistry& instance(){
+        static PluginRegistry registry;
+        return registry;
+    }
+
+    // Loads a library the first time it is asked for, afterwards returns the same handle
+    // nullptr if the library cannot be loaded - like dlopen, so dlerror still tells why
+    void* open(const char* library_file){
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto entry = this->handles.find(library_file);
+        if(entry != this->handles.end()){
+            return entry->second;
+        }
+        void* handle = dlopen(library_file, RTLD_LAZY);
+        if(handle){
+            this->handles[library_file] = handle;
+        }
+        return handle;
+    }
+
+    // Prints the library instances created and reused by the job - nothing when no library object was pooled
+    void printStats(std::ostream &output){
+        std::size_t created[] = {this->mappers.getCreated(), this->shufflers.getCreated(), this->reducers.getCreated()};
+        std::size_t reused[] = {this->mappers.getReused(), this->shufflers.getReused(), this->reducers.getReused()};
+        if(created[0] + created[1] + created[2] == 0){
+            return;
+        }
+        output << "Plugin objects (created/reused) - mappers: " << created[0] << "/" << reused[0]
+               << ", shufflers: " << created[1] << "/" << reused[1]
+               << ", reducers: " << created[2] << "/" << reused[2] << std::endl;
+    }
+
+    // Destroys the idle instances and unloads every library - objects of a library must not outlive this
+    void close(){
+        this->mappers.drain();
+        this->shufflers.drain();
+        this->reducers.drain();
+        this->fileProcessors.drain();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for(const auto &entry: this->handles){
+            dlclose(entry.second);
+        }
+        this->handles.clear();
+    }
+};
+
+#endif //MAPREDUCELIB_PLUGINREGISTRY_HPP
@@ -10,7 +10,11 @@
 #include <filesystem>
 #include <map>
 #include <vector>
+#include <utility>
 
+// Concurrency contract:
+// Each instance reads its own temp_shuffler sub-folder and owns its reduced output.
+// Different instances can run runReduceOperations concurrently without any external lock.
 class ReducerBase{
 private:
     // Private data member - directory containing shuffler outputs
@@ -54,12 +58,27 @@ public:
     void setReducedOutput(const std::map<std::string, std::map<std::string, size_t>> &reduced_result){
         this->reducedOutput = reduced_result;
     }
+    // Move variant - takes ownership of the reduced output instead of copying it
+    void setReducedOutput(std::map<std::string, std::map<std::string, size_t>> &&reduced_result){
+        this->reducedOutput = std::move(reduced_result);
+    }
 
     // Getters
     // This method retrieves the reducedOutput private data member
     std::map<std::string, std::map<std::string, size_t>> getReducedOutput(){
         return this->reducedOutput;
     }
+    // This method hands the reducedOutput private data member over without copying it, leaving it empty
+    std::map<std::string, std::map<std::string, size_t>> takeReducedOutput(){
+        return std::exchange(this->reducedOutput, {});
+    }
+
+    // Reset hook - returns a pooled instance to its default constructed state, so it can be pointed at the next
+    // temp_shuffler sub-folder. Inline and non-virtual, so libraries built against the previous header keep working
+    void reset(){
+        this->parentShuffleDirectory.clear();
+        this->reducedOutput = {};
+    }
 
     // Virtual method to run reduce operations
     // Primary method that will act on shuffled files and create reduced results in memory
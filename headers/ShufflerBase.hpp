@@ -11,7 +11,12 @@
 #include <vector>
 #include <map>
 #include <fstream>
+#include <utility>
+#include "MapperBase.hpp"
 
+// Concurrency contract:
+// Each instance reads its own temp_mapper sub-folder and owns its shuffled output.
+// Different instances can run runShuffleOperation concurrently without any external lock.
 class ShufflerBase {
     //private data members
 private:
@@ -47,6 +52,10 @@ public:
     void setShuffledOutput(const std::vector<std::map<std::string, std::map<std::string,size_t>>> &shuffled_output){
         this->shuffledOutput = shuffled_output;
     }
+    // Move variant - takes ownership of the shuffled output instead of copying it
+    void setShuffledOutput(std::vector<std::map<std::string, std::map<std::string,size_t>>> &&shuffled_output){
+        this->shuffledOutput = std::move(shuffled_output);
+    }
 
     // Getters -
     // This method retrieves the mapOutputDirectory private data member
@@ -57,6 +66,17 @@ public:
     std::vector<std::map<std::string, std::map<std::string,size_t>>> getShuffledOutput(){
         return this->shuffledOutput;
     }
+    // This method hands the shuffledOutput private data member over without copying it, leaving it empty
+    std::vector<std::map<std::string, std::map<std::string,size_t>>> takeShuffledOutput(){
+        return std::exchange(this->shuffledOutput, {});
+    }
+
+    // Reset hook - returns a pooled instance to its default constructed state, so it can be pointed at the next
+    // temp_mapper sub-folder. Inline and non-virtual, so libraries built against the previous header keep working
+    void reset(){
+        this->mapOutputDirectory.clear();
+        this->shuffledOutput = {};
+    }
 
     // Virtual method to run operations
     // Primary method that will act on processed mapped files and create shuffled results in memory
@@ -68,5 +88,10 @@ public:
 typedef ShufflerBase* createShuffler_t(const std::string &mapper_directory);
 typedef void destroyShuffler_t(ShufflerBase*);
 
+// Optional factory - shuffles mapper results handed over in memory instead of a temp_mapper sub-folder
+// Input: every mapper result of a single file, keyed by partition number
+// Exported as createInMemoryObj; mapReduceWorkflow falls back to InMemoryShuffler when a library lacks it
+typedef ShufflerBase* createInMemoryShuffler_t(const std::map<int, mapperOutput_t> &mapper_partitions);
+
 
 #endif //MRHOPE_SHUFFLERBASE_HPP
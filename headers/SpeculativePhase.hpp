@@ -0,0 +1,163 @@
+/*
+ * Description: Speculative execution of the tasks of a phase - backup attempts of stragglers on idle workers
+ */
+#ifndef MAPREDUCELIB_SPECULATIVEPHASE_HPP
+#define MAPREDUCELIB_SPECULATIVEPHASE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include "JobPhase.hpp"
+#include "JobMetrics.hpp"
+#include "WorkStealingPool.hpp"
+
+// Share of the tasks of a phase that must be done before any backup is launched - until then the mean task time
+// is not known well enough to call a task slow
+constexpr double SPECULATION_PHASE_FRACTION = 0.75;
+// A running task is a straggler once it has taken this many times the mean time of the finished tasks...
+constexpr double SPECULATION_SLOWDOWN = 1.5;
+// ...and at least this long - backups of tasks this short cost more than they save
+constexpr double SPECULATION_MIN_SECONDS = 0.01;
+
+// Tasks of one phase, each run by a primary attempt and, if it straggles, by one backup attempt.
+// Both attempts of a task race to fulfil the same promise: the first result wins and is the only one the driver ever
+// sees - the attempts hand back in-memory results, so the loser's output is simply dropped and nothing is written
+// twice. Backups are launched by the driver while it waits on the phase (see await), only onto idle workers.
+template<typename R>
+class SpeculativePhase{
+private:
+    // One logical task - shared with its attempts, which may outlive the phase object when a loser is still running
+    struct SpeculativeTask{
+        std::function<R()> primary;
+        // builds fresh inputs and runs the task again - empty if the task cannot be re-run
+        std::function<R()> backup;
+        std::promise<R> result;
+        // set by the attempt that fulfils the promise
+        std::atomic<bool> done{false};
+        // 0 - primary, 1 - backup, -1 - not done yet
+        std::atomic<int> winner{-1};
+        // microseconds since the phase start at which the first attempt started running - 0 while queued
+        std::atomic<long long> startMicros{0};
+        // only touched by the driver
+        bool backupLaunched = false;
+    };
+    // Finished tasks of the phase - updated by the winning attempts
+    struct PhaseProgress{
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::atomic<std::size_t> completed{0};
+        std::atomic<long long> completedMicros{0};
+
+        long long elapsedMicros() const{
+            return std::max<long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - this->start).count(), 1);
+        }
+    };
+
+    WorkStealingPool &pool;
+    JobPhase phase;
+    bool enabled;
+    std::vector<std::shared_ptr<SpeculativeTask>> tasks;
+    std::shared_ptr<PhaseProgress> progress = std::make_shared<PhaseProgress>();
+    std::size_t backupsLaunched = 0;
+
+    // Runs one attempt of a task - an attempt that starts after the task is done does nothing
+    static void runAttempt(const std::shared_ptr<SpeculativeTask> &task, const std::shared_ptr<PhaseProgress> &progress,
+                           int attempt){
+        if(task->done.load()){
+            return;
+        }
+        long long startMicros = progress->elapsedMicros();
+        long long expected = 0;
+        task->startMicros.compare_exchange_strong(expected, startMicros);
+        try{
+            R value = attempt == 0 ? task->primary() : task->backup();
+            if(!task->done.exchange(true)){
+                task->winner = attempt;
+                progress->completedMicros += progress->elapsedMicros() - startMicros;
+                progress->completed++;
+                task->result.set_value(std::move(value));
+            }
+        } catch(...){
+            if(!task->done.exchange(true)){
+                task->winner = attempt;
+                progress->completed++;
+                task->result.set_exception(std::current_exception());
+            }
+        }
+    }
+
+public:
+    // Constructor - a disabled phase submits every task once, straight to the executor
+    SpeculativePhase(WorkStealingPool &executor, JobPhase job_phase, bool speculate)
+            : pool(executor), phase(job_phase), enabled(speculate){
+    }
+
+    // Submits a task - backup must redo the work of primary from scratch; without it the task is never speculated
+    std::future<R> submit(std::function<R()> primary, std::function<R()> backup = nullptr){
+        if(!this->enabled || !backup){
+            return this->pool.submit(this->phase, std::move(primary));
+        }
+        auto task = std::make_shared<SpeculativeTask>();
+        task->primary = std::move(primary);
+        task->backup = std::move(backup);
+        std::future<R> result = task->result.get_future();
+        this->tasks.push_back(task);
+        std::shared_ptr<PhaseProgress> phaseProgress = this->progress;
+        this->pool.submit(this->phase, [task, phaseProgress]{ runAttempt(task, phaseProgress, 0); });
+        return result;
+    }
+
+    // Launches a backup of every straggler, as long as workers are idle - called by the driver thread only
+    void launchBackups(){
+        std::size_t completed = this->progress->completed.load();
+        if(completed == 0 || completed < SPECULATION_PHASE_FRACTION * this->tasks.size()){
+            return;
+        }
+        unsigned idleWorkers = this->pool.getIdleWorkerCount();
+        double meanSeconds = this->progress->completedMicros.load() / 1e6 / completed;
+        double thresholdSeconds = std::max(SPECULATION_MIN_SECONDS, SPECULATION_SLOWDOWN * meanSeconds);
+        long long nowMicros = this->progress->elapsedMicros();
+        for(const auto &task: this->tasks){
+            if(idleWorkers == 0){
+                return;
+            }
+            long long startMicros = task->startMicros.load();
+            if(task->backupLaunched || task->done.load() || startMicros == 0 ||
+               (nowMicros - startMicros) / 1e6 < thresholdSeconds){
+                continue;
+            }
+            task->backupLaunched = true;
+            this->backupsLaunched++;
+            idleWorkers--;
+            std::shared_ptr<PhaseProgress> phaseProgress = this->progress;
+            this->pool.submit(this->phase, [task, phaseProgress]{ runAttempt(task, phaseProgress, 1); });
+        }
+    }
+
+    // Blocks on a task result like JobMetrics::awaitResult - while it waits, stragglers get their backups
+    R await(std::future<R> &result, JobMetrics &metrics){
+        if(!this->enabled){
+            return metrics.awaitResult(result, this->phase);
+        }
+        return metrics.awaitResult(result, this->phase, [this]{ this->launchBackups(); });
+    }
+
+    // Getter - backups launched so far
+    std::size_t getBackupsLaunched() const{
+        return this->backupsLaunched;
+    }
+
+    // Getter - tasks whose backup finished first
+    std::size_t getBackupWins() const{
+        std::size_t wins = 0;
+        for(const auto &task: this->tasks){
+            wins += task->winner.load() == 1;
+        }
+        return wins;
+    }
+};
+
+#endif //MAPREDUCELIB_SPECULATIVEPHASE_HPP
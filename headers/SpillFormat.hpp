@@ -0,0 +1,334 @@
+/*
+ * Description: Intermediate file formats of temp_mapper and temp_shuffler - "(token,count)" text or binary spill files
+ */
+#ifndef MAPREDUCELIB_SPILLFORMAT_HPP
+#define MAPREDUCELIB_SPILLFORMAT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "TokenCountTable.hpp"
+#include "TokenIdTable.hpp"
+#include "TaskMetrics.hpp"
+
+// Format of the intermediate files written by the built-in processors - final_output is always text
+enum class SpillFormat {
+    // one "(token,count)" line per entry - what the library shufflers and reducers read
+    Text = 0,
+    // length-prefixed binary records - read by NativeShuffler and NativeReducer only
+    Binary
+};
+
+// Binary spill file layout - every integer of the header is little-endian:
+//  * magic        8 bytes  "MRSPILL1" (the digit is the format version)
+//  * records      8 bytes  number of records
+//  * payload      8 bytes  size of the payload in bytes
+//  * checksum     8 bytes  64-bit FNV-1a of the payload
+//  * payload      one record per entry, in the order written:
+//      varint reference - 0 for a token seen for the first time in the file, else 1 + its dictionary index
+//      for a new token only (it becomes the next dictionary entry):
+//          varint shared - bytes shared with the previous new token (prefix compression - sorted tables share a lot)
+//          varint suffix - length of the rest of the token
+//          suffix bytes
+//      varint count
+// The dictionary is implicit - temp_mapper files repeat the same tokens over and over, a repeat costs its reference only.
+// Varints are LEB128: 7 bits per byte, least significant group first, high bit set on all but the last byte.
+constexpr char SPILL_MAGIC[8] = {'M', 'R', 'S', 'P', 'I', 'L', 'L', '1'};
+constexpr std::size_t SPILL_HEADER_BYTES = 32;
+
+// Token ID spill file layout (--token-ids) - the header of a binary spill file with its own magic, "MRIDSPL1",
+// then one record per entry:
+//      varint token ID - an ID of the job's TokenDictionary
+//      varint count
+// The IDs only mean something to the process that wrote them - the files are intermediate data of a single job.
+constexpr char ID_SPILL_MAGIC[8] = {'M', 'R', 'I', 'D', 'S', 'P', 'L', '1'};
+
+// Helper - appends a LEB128 varint
+inline void appendVarint(std::string &buffer, std::uint64_t value){
+    while(value >= 0x80){
+        buffer += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buffer += static_cast<char>(value);
+}
+
+// Helper - decodes a LEB128 varint at position, which is advanced past it
+inline std::uint64_t readVarint(std::string_view buffer, std::size_t &position){
+    // most lengths, references and counts fit in one byte
+    if(position < buffer.size() && static_cast<unsigned char>(buffer[position]) < 0x80){
+        return static_cast<unsigned char>(buffer[position++]);
+    }
+    std::uint64_t value = 0;
+    for(unsigned shift = 0; shift < 64; shift += 7){
+        if(position >= buffer.size()){
+            throw std::runtime_error("Truncated varint in spill file!");
+        }
+        auto byte = static_cast<unsigned char>(buffer[position++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0){
+            return value;
+        }
+    }
+    throw std::runtime_error("Overlong varint in spill file!");
+}
+
+// Helper - fixed width little-endian fields of the header
+inline void storeLittleEndian64(char* destination, std::uint64_t value){
+    for(int i = 0; i < 8; i++){
+        destination[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+inline std::uint64_t loadLittleEndian64(const char* source){
+    std::uint64_t value = 0;
+    for(int i = 0; i < 8; i++){
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(source[i])) << (8 * i);
+    }
+    return value;
+}
+
+// Helper - fills in the header of a spill file that starts at header_offset of buffer and runs to its end
+inline void finishSpillHeader(std::string &buffer, std::size_t header_offset, const char (&magic)[8], std::uint64_t records){
+    std::size_t payloadOffset = header_offset + SPILL_HEADER_BYTES;
+    std::string_view payload(buffer.data() + payloadOffset, buffer.size() - payloadOffset);
+    char* header = &buffer[header_offset];
+    std::copy(magic, magic + 8, header);
+    storeLittleEndian64(header + 8, records);
+    storeLittleEndian64(header + 16, payload.size());
+    storeLittleEndian64(header + 24, TokenCountTable::hashToken(payload));
+}
+
+// Helper - checks the header of a whole spill file held in memory; returns its payload and sets records
+inline std::string_view verifySpillHeader(std::string_view buffer, const char (&magic)[8], std::uint64_t &records){
+    if(buffer.size() < SPILL_HEADER_BYTES || buffer.compare(0, sizeof(magic), magic, sizeof(magic)) != 0){
+        throw std::runtime_error("Missing spill file header!");
+    }
+    records = loadLittleEndian64(buffer.data() + 8);
+    std::uint64_t payloadBytes = loadLittleEndian64(buffer.data() + 16);
+    std::uint64_t checksum = loadLittleEndian64(buffer.data() + 24);
+    std::string_view payload = buffer.substr(SPILL_HEADER_BYTES);
+    if(payload.size() != payloadBytes){
+        throw std::runtime_error("Spill file size does not match its header!");
+    }
+    if(TokenCountTable::hashToken(payload) != checksum){
+        throw std::runtime_error("Spill file checksum mismatch!");
+    }
+    return payload;
+}
+
+// Builds one binary spill file in memory - the header is filled in by finish()
+class SpillWriter{
+private:
+    std::string &buffer;
+    std::size_t headerOffset;
+    std::uint64_t records = 0;
+    // token -> 1 + dictionary index
+    TokenCountTable dictionary;
+    std::string previousToken;
+
+public:
+    // Constructor - the file is appended to buffer
+    explicit SpillWriter(std::string &output_buffer) : buffer(output_buffer), headerOffset(output_buffer.size()){
+        this->buffer.append(SPILL_HEADER_BYTES, '\0');
+    }
+
+    // Appends a (token, count) record
+    void add(std::string_view token, std::uint64_t count){
+        std::size_t entries = this->dictionary.size();
+        std::size_t reference = this->dictionary.findOrAdd(token, entries + 1);
+        if(this->dictionary.size() == entries){
+            appendVarint(this->buffer, reference);
+        } else {
+            std::size_t shared = 0;
+            std::size_t limit = std::min(token.size(), this->previousToken.size());
+            while(shared < limit && token[shared] == this->previousToken[shared]){
+                shared++;
+            }
+            appendVarint(this->buffer, 0);
+            appendVarint(this->buffer, shared);
+            appendVarint(this->buffer, token.size() - shared);
+            this->buffer.append(token.data() + shared, token.size() - shared);
+            this->previousToken.assign(token.data(), token.size());
+        }
+        appendVarint(this->buffer, count);
+        this->records++;
+    }
+
+    // Writes the header - record count, payload size and checksum
+    void finish(){
+        finishSpillHeader(this->buffer, this->headerOffset, SPILL_MAGIC, this->records);
+    }
+};
+
+// Builds one token ID spill file in memory - the header is filled in by finish()
+class IdSpillWriter{
+private:
+    std::string &buffer;
+    std::size_t headerOffset;
+    std::uint64_t records = 0;
+
+public:
+    // Constructor - the file is appended to buffer
+    explicit IdSpillWriter(std::string &output_buffer) : buffer(output_buffer), headerOffset(output_buffer.size()){
+        this->buffer.append(SPILL_HEADER_BYTES, '\0');
+    }
+
+    // Appends a (token ID, count) record
+    void add(std::uint32_t id, std::uint64_t count){
+        appendVarint(this->buffer, id);
+        appendVarint(this->buffer, count);
+        this->records++;
+    }
+
+    // Writes the header - record count, payload size and checksum
+    void finish(){
+        finishSpillHeader(this->buffer, this->headerOffset, ID_SPILL_MAGIC, this->records);
+    }
+};
+
+// Helper - true when a file starts with the binary spill magic; text files start with '('
+inline bool isBinarySpill(std::string_view buffer){
+    return buffer.size() >= sizeof(SPILL_MAGIC) && buffer.compare(0, sizeof(SPILL_MAGIC), SPILL_MAGIC, sizeof(SPILL_MAGIC)) == 0;
+}
+
+// Decodes a binary spill file - the header is verified up front, so a truncated or corrupt file throws
+// before any record is visited
+class SpillReader{
+private:
+    std::string_view payload;
+    std::uint64_t records = 0;
+    // dictionary entries (offset, length), their bytes back to back in one arena
+    std::string arena;
+    std::vector<std::pair<std::size_t, std::size_t>> dictionary;
+
+public:
+    // Constructor - checks the header of a whole file held in memory, which must outlive the reader
+    explicit SpillReader(std::string_view buffer){
+        this->payload = verifySpillHeader(buffer, SPILL_MAGIC, this->records);
+    }
+
+    // Decodes every record in file order, calling visit(dictionary index, count)
+    // The token of an index is available through getToken() from the first record that uses it
+    template<typename Visitor>
+    void forEachRecord(Visitor &&visit){
+        this->arena.clear();
+        this->dictionary.clear();
+        // a new token costs at least three payload bytes
+        this->arena.reserve(this->payload.size());
+        this->dictionary.reserve(std::min<std::uint64_t>(this->records, this->payload.size() / 3));
+        std::size_t position = 0;
+        for(std::uint64_t record = 0; record < this->records; record++){
+            std::uint64_t reference = readVarint(this->payload, position);
+            if(reference == 0){
+                std::uint64_t shared = readVarint(this->payload, position);
+                std::uint64_t suffix = readVarint(this->payload, position);
+                std::pair<std::size_t, std::size_t> previous{0, 0};
+                if(!this->dictionary.empty()){
+                    previous = this->dictionary.back();
+                }
+                if(shared > previous.second || suffix > this->payload.size() - position){
+                    throw std::runtime_error("Corrupt spill file record!");
+                }
+                std::size_t offset = this->arena.size();
+                this->arena.append(this->arena, previous.first, static_cast<std::size_t>(shared));
+                this->arena.append(this->payload.data() + position, static_cast<std::size_t>(suffix));
+                position += static_cast<std::size_t>(suffix);
+                this->dictionary.emplace_back(offset, this->arena.size() - offset);
+                reference = this->dictionary.size();
+            } else if(reference > this->dictionary.size()){
+                throw std::runtime_error("Corrupt spill file reference!");
+            }
+            std::size_t count = static_cast<std::size_t>(readVarint(this->payload, position));
+            visit(static_cast<std::size_t>(reference - 1), count);
+        }
+        if(position != this->payload.size()){
+            throw std::runtime_error("Trailing bytes in spill file!");
+        }
+    }
+
+    // Getters
+    std::uint64_t getRecordCount() const{
+        return this->records;
+    }
+    std::size_t getDictionarySize() const{
+        return this->dictionary.size();
+    }
+    std::string_view getToken(std::size_t index) const{
+        return std::string_view(this->arena.data() + this->dictionary[index].first, this->dictionary[index].second);
+    }
+};
+
+// Helper - aggregates an intermediate file of either format, held in memory, into a table; returns the number of records
+// Binary files are summed per dictionary entry first - the table sees every distinct token of the file once
+inline std::size_t aggregateSpillBuffer(std::string_view buffer, TokenCountTable &table){
+    if(!isBinarySpill(buffer)){
+        return aggregateTokenCountLines(buffer, table);
+    }
+    SpillReader reader(buffer);
+    std::vector<std::size_t> totals;
+    reader.forEachRecord([&totals](std::size_t entry, std::size_t count){
+        if(entry == totals.size()){
+            totals.push_back(count);
+        } else {
+            totals[entry] += count;
+        }
+    });
+    // the distinct tokens of the file are known up front - grow the table once rather than step by step
+    table.reserve(table.size() + totals.size());
+    for(std::size_t entry = 0; entry < totals.size(); entry++){
+        table.add(reader.getToken(entry), totals[entry]);
+    }
+    return static_cast<std::size_t>(reader.getRecordCount());
+}
+
+// Helper - aggregates an intermediate file of either format into a table - reported as input of the running task
+inline void aggregateSpillFile(const std::string &file_path, TokenCountTable &table){
+    std::string buffer = readWholeFile(file_path);
+    try{
+        countTaskInput(aggregateSpillBuffer(buffer, table), buffer.size());
+    } catch(std::runtime_error &error){
+        throw std::runtime_error(std::string(error.what()) + " " + file_path);
+    }
+}
+
+// Helper - aggregates a token ID spill file, held in memory, into a table; returns the number of records
+// The tight loop of --token-ids: two varints and one integer table add per record
+inline std::size_t aggregateIdSpillBuffer(std::string_view buffer, TokenIdTable &table){
+    std::uint64_t records = 0;
+    std::string_view payload = verifySpillHeader(buffer, ID_SPILL_MAGIC, records);
+    std::size_t position = 0;
+    for(std::uint64_t record = 0; record < records; record++){
+        auto id = static_cast<std::uint32_t>(readVarint(payload, position));
+        table.add(id, static_cast<std::size_t>(readVarint(payload, position)));
+    }
+    if(position != payload.size()){
+        throw std::runtime_error("Trailing bytes in spill file!");
+    }
+    return static_cast<std::size_t>(records);
+}
+
+// Helper - aggregates a token ID spill file into a table - reported as input of the running task
+inline void aggregateIdSpillFile(const std::string &file_path, TokenIdTable &table){
+    std::string buffer = readWholeFile(file_path);
+    try{
+        countTaskInput(aggregateIdSpillBuffer(buffer, table), buffer.size());
+    } catch(std::runtime_error &error){
+        throw std::runtime_error(std::string(error.what()) + " " + file_path);
+    }
+}
+
+// Helper - name of a format as given on the command line
+inline SpillFormat parseSpillFormat(const std::string &value){
+    if(value == "text"){
+        return SpillFormat::Text;
+    }
+    if(value == "binary"){
+        return SpillFormat::Binary;
+    }
+    throw std::runtime_error("Unsupported spill format!: " + value);
+}
+
+#endif //MAPREDUCELIB_SPILLFORMAT_HPP
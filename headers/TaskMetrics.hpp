@@ -0,0 +1,134 @@
+/*
+ * Description: Per-task metrics - time, CPU, records and bytes of every task run by the executor
+ */
+#ifndef MAPREDUCELIB_TASKMETRICS_HPP
+#define MAPREDUCELIB_TASKMETRICS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "JobPhase.hpp"
+
+// Measurements of one executed task - filled in by WorkStealingPool around the task, except for the record and byte
+// counts, which the task reports itself through countTaskInput/countTaskOutput
+struct TaskMetrics{
+    JobPhase phase = JobPhase::Input;
+    // executor worker that ran the task, and its kernel thread id (as shown by perf and top)
+    unsigned worker = 0;
+    long threadId = 0;
+    // base name of the input file and the partition the task worked on - set by the task through tagTask, if known
+    std::string file;
+    int partition = -1;
+    // seconds from executor start until the task started
+    double startSeconds = 0;
+    double wallSeconds = 0;
+    // CPU time of the worker thread while it ran the task, plus any CPU time charged through countTaskCpu
+    double cpuSeconds = 0;
+    std::uint64_t recordsIn = 0;
+    std::uint64_t recordsOut = 0;
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    // resident set size of the process when the task finished - RSS is process-wide and shared with the tasks running
+    // next to it, so this is not a per-task peak (the job's peak RSS is the process high-water mark)
+    long rssKilobytesAtEnd = 0;
+};
+
+// Helper - current resident set size of the process in kilobytes (/proc/self/statm), 0 if unavailable
+inline long readRssKilobytes(){
+    int descriptor = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    if(descriptor < 0){
+        return 0;
+    }
+    char buffer[128];
+    ssize_t length = read(descriptor, buffer, sizeof(buffer) - 1);
+    close(descriptor);
+    long pages = 0;
+    long residentPages = 0;
+    if(length <= 0){
+        return 0;
+    }
+    buffer[length] = '\0';
+    // size, then resident - in pages
+    if(std::sscanf(buffer, "%ld %ld", &pages, &residentPages) != 2){
+        return 0;
+    }
+    return residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Helper - peak resident set size of the process in kilobytes, 0 if unavailable
+inline long readPeakRssKilobytes(){
+    struct rusage usage{};
+    if(getrusage(RUSAGE_SELF, &usage) != 0){
+        return 0;
+    }
+    // Linux reports ru_maxrss in kilobytes
+    return usage.ru_maxrss;
+}
+
+// Helper - CPU time consumed by the calling thread so far
+inline double readThreadCpuSeconds(){
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) / 1e9;
+}
+
+// Helper - kernel thread id of the calling thread
+inline long readThreadId(){
+    return static_cast<long>(syscall(SYS_gettid));
+}
+
+// Metrics of the task running on the calling thread - nullptr outside a task
+inline TaskMetrics*& currentTaskMetrics(){
+    static thread_local TaskMetrics* current = nullptr;
+    return current;
+}
+
+// Reports what the running task read and wrote - records are lines, tokens or table entries, whichever the task handles
+// No-ops outside a task, so shared helpers can report unconditionally
+inline void countTaskInput(std::uint64_t records, std::uint64_t bytes){
+    if(TaskMetrics* metrics = currentTaskMetrics()){
+        metrics->recordsIn += records;
+        metrics->bytesIn += bytes;
+    }
+}
+inline void countTaskOutput(std::uint64_t records, std::uint64_t bytes){
+    if(TaskMetrics* metrics = currentTaskMetrics()){
+        metrics->recordsOut += records;
+        metrics->bytesOut += bytes;
+    }
+}
+
+// Charges CPU time spent for the running task outside the calling thread - a worker process that ran it
+inline void countTaskCpu(double seconds){
+    if(TaskMetrics* metrics = currentTaskMetrics()){
+        metrics->cpuSeconds += seconds;
+    }
+}
+
+// Reports the end-of-task RSS of another process that ran the task - kept if it is larger than the calling process's own
+inline void countTaskRss(long kilobytes){
+    if(TaskMetrics* metrics = currentTaskMetrics()){
+        metrics->rssKilobytesAtEnd = std::max(metrics->rssKilobytesAtEnd, kilobytes);
+    }
+}
+
+// Labels the running task with the input file (and partition) it works on - the first file given sticks, so the
+// driver's label is not replaced by the names of intermediate files; no-op outside a task
+inline void tagTask(const std::string &file, int partition = -1){
+    if(TaskMetrics* metrics = currentTaskMetrics()){
+        if(metrics->file.empty() && !file.empty()){
+            metrics->file = file.substr(file.rfind('/') + 1);
+        }
+        if(partition >= 0){
+            metrics->partition = partition;
+        }
+    }
+}
+
+#endif //MAPREDUCELIB_TASKMETRICS_HPP
@@ -0,0 +1,109 @@
+/*
+ * Description: Byte based sizing of the map tasks - the target bytes per task, re-cutting record partitions to it and
+ * coalescing small partitions into one task
+ */
+#ifndef MAPREDUCELIB_TASKSIZING_HPP
+#define MAPREDUCELIB_TASKSIZING_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "Tokenizer.hpp"
+
+// Tasks per worker aimed for - a few per worker, so the workers that finish early can steal from the stragglers
+constexpr std::size_t TASKS_PER_WORKER = 4;
+// Bounds of the target - below the lower one the per-task overhead dominates, above the upper one a single task
+// holds too much of the input (and of its mapper output) at once
+constexpr std::size_t MIN_TASK_BYTES = 64 << 10;
+constexpr std::size_t MAX_TASK_BYTES = 32 << 20;
+// Upper bound of an explicit --task-bytes - the mapper output of a task addresses its token arena with 32-bit offsets
+// (CompactMapperOutput), and a task runs past its target up to the next record boundary
+constexpr unsigned long long MAX_EXPLICIT_TASK_BYTES = 1ULL << 30;
+
+// Target input bytes per map task - the whole input spread over TASKS_PER_WORKER tasks per worker
+inline std::size_t chooseTaskBytes(std::uintmax_t total_input_bytes, unsigned worker_count){
+    std::uintmax_t tasks = static_cast<std::uintmax_t>(std::max(worker_count, 1U)) * TASKS_PER_WORKER;
+    std::uintmax_t target = total_input_bytes / tasks;
+    return static_cast<std::size_t>(std::clamp<std::uintmax_t>(target, MIN_TASK_BYTES, MAX_TASK_BYTES));
+}
+
+// Re-cuts the record partitions of a file into partitions of about task_bytes - records are moved, never split,
+// so a partition ends on the first record boundary at or past the target
+inline std::vector<std::vector<std::string>> resizePartitions(std::vector<std::vector<std::string>> &&partitions,
+                                                              std::size_t task_bytes){
+    std::vector<std::vector<std::string>> resized;
+    std::vector<std::string> current;
+    std::size_t currentBytes = 0;
+    for(std::vector<std::string> &partition: partitions){
+        for(std::string &record: partition){
+            // +1 for the '\n' the record was read with
+            currentBytes += record.size() + 1;
+            current.push_back(std::move(record));
+            if(currentBytes >= task_bytes){
+                resized.push_back(std::move(current));
+                current.clear();
+                currentBytes = 0;
+            }
+        }
+        partition = std::vector<std::string>();
+    }
+    if(!current.empty()){
+        resized.push_back(std::move(current));
+    }
+    return resized;
+}
+
+// Makes every partition of a file start with a record that has tokens - FileProcessorMapOutput takes the partition
+// number from the first token of the first record, so a partition starting with a blank (or punctuation only) record
+// cannot be written. Such records move to the end of the previous partition, or right after the first record with
+// tokens at the start of the file; the counts stay the same. A partition left empty is dropped.
+inline void anchorPartitions(std::vector<std::vector<std::string>> &partitions){
+    std::vector<std::vector<std::string>> anchored;
+    // records without tokens ahead of the first record with tokens of the file
+    std::vector<std::string> leading;
+    for(std::vector<std::string> &partition: partitions){
+        auto first = std::find_if(partition.begin(), partition.end(), [](const std::string &record){
+            return recordHasTokens(record);
+        });
+        std::vector<std::string> &previous = anchored.empty() ? leading : anchored.back();
+        std::move(partition.begin(), first, std::back_inserter(previous));
+        if(first == partition.end()){
+            continue;
+        }
+        anchored.emplace_back(std::make_move_iterator(first), std::make_move_iterator(partition.end()));
+        std::move(leading.begin(), leading.end(), std::back_inserter(anchored.back()));
+        leading.clear();
+    }
+    // a file without a single token keeps its records in one partition
+    if(!leading.empty()){
+        anchored.push_back(std::move(leading));
+    }
+    partitions = std::move(anchored);
+}
+
+// Groups consecutive tasks into batches of at least task_bytes - small tasks (the partitions of small files) share
+// a batch, a task of task_bytes or more stays on its own (task_bytes == 0: every task); returns the task indexes of
+// every batch
+inline std::vector<std::vector<std::size_t>> coalesceTasks(const std::vector<std::size_t> &bytes_per_task,
+                                                           std::size_t task_bytes){
+    std::vector<std::vector<std::size_t>> batches;
+    std::vector<std::size_t> current;
+    std::size_t currentBytes = 0;
+    for(std::size_t i = 0; i < bytes_per_task.size(); i++){
+        current.push_back(i);
+        currentBytes += bytes_per_task[i];
+        if(currentBytes >= task_bytes){
+            batches.push_back(std::move(current));
+            current.clear();
+            currentBytes = 0;
+        }
+    }
+    if(!current.empty()){
+        batches.push_back(std::move(current));
+    }
+    return batches;
+}
+
+#endif //MAPREDUCELIB_TASKSIZING_HPP
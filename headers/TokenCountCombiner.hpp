@@ -0,0 +1,50 @@
+/*
+ * Description: Combiner implementation built into the driver - sums the counts of repeated tokens
+ */
+#ifndef MAPREDUCELIB_TOKENCOUNTCOMBINER_HPP
+#define MAPREDUCELIB_TOKENCOUNTCOMBINER_HPP
+
+#include "CombinerBase.hpp"
+#include "TokenCountTable.hpp"
+
+// Word-count combiner - one (token, summed count, partition) entry per distinct token, in token order.
+// The result is a single record per file; FileProcessorMapOutput and the shufflers do not depend on record boundaries.
+// Used when MapperImpl does not export createCombinerObj.
+class TokenCountCombiner : public CombinerBase{
+public:
+    void combine(mapperOutput_t &mapper_output) override{
+        for(auto &file: mapper_output){
+            // tokens of different partitions must stay apart - they go to different temp_mapper files
+            std::map<int, TokenCountTable> partitions;
+            for(const auto &record: file.second){
+                for(const auto &token: record){
+                    partitions[std::get<2>(token)].add(std::get<0>(token), static_cast<std::size_t>(std::get<1>(token)));
+                }
+            }
+            std::vector<std::tuple<std::string, int, int>> combined;
+            for(const auto &partition: partitions){
+                for(const auto &entry: partition.second.sortedEntries()){
+                    combined.emplace_back(std::string(entry.first), static_cast<int>(entry.second), partition.first);
+                }
+            }
+            file.second.clear();
+            file.second.push_back(std::move(combined));
+        }
+    }
+
+    void combineCompact(CompactMapperOutput &mapper_output) override{
+        TokenCountTable table;
+        for(std::size_t i = 0; i < mapper_output.getTokenCount(); i++){
+            table.add(mapper_output.getToken(i), mapper_output.getCount(i));
+        }
+        CompactMapperOutput combined(mapper_output.getFileName(), mapper_output.getPartitionNum());
+        for(const auto &entry: table.sortedEntries()){
+            combined.addToken(entry.first, static_cast<std::uint32_t>(entry.second));
+        }
+        combined.endRecord();
+        combined.shrinkToFit();
+        mapper_output = std::move(combined);
+    }
+};
+
+#endif //MAPREDUCELIB_TOKENCOUNTCOMBINER_HPP
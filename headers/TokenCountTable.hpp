@@ -0,0 +1,282 @@
+/*
+ * Description: Hash aggregation engine - open addressing (token -> count) table with arena-stored keys
+ */
+#ifndef MAPREDUCELIB_TOKENCOUNTTABLE_HPP
+#define MAPREDUCELIB_TOKENCOUNTTABLE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Replacement for std::map<std::string, size_t> while counts are being aggregated:
+//  * keys are copied once into an arena, the table only holds offsets into it
+//  * every slot keeps the full 64-bit hash of its key - probes compare hashes before bytes and growing never rehashes a key
+//  * linear probing over a power-of-two slot array, grown at 3/4 load
+// Entries are unordered - sortedEntries()/toMap() sort once, when the result is written out.
+class TokenCountTable{
+private:
+    struct Slot{
+        std::uint64_t hash;
+        std::uint32_t offset;
+        // EMPTY_SLOT marks an unused slot
+        std::uint32_t length;
+        std::size_t count;
+    };
+    static constexpr std::uint32_t EMPTY_SLOT = std::numeric_limits<std::uint32_t>::max();
+
+    std::vector<Slot> slots;
+    std::size_t entries = 0;
+    std::string arena;
+
+    bool matches(const Slot &slot, std::uint64_t hash, std::string_view token) const{
+        return slot.hash == hash && slot.length == token.size()
+               && std::memcmp(this->arena.data() + slot.offset, token.data(), token.size()) == 0;
+    }
+
+    // Slot of a token - inserted with a zero count if absent
+    Slot& findOrInsert(std::string_view token, std::uint64_t hash){
+        if((this->entries + 1) * 4 > this->slots.size() * 3){
+            this->grow();
+        }
+        std::size_t mask = this->slots.size() - 1;
+        std::size_t index = hash & mask;
+        while(this->slots[index].length != EMPTY_SLOT){
+            if(this->matches(this->slots[index], hash, token)){
+                return this->slots[index];
+            }
+            index = (index + 1) & mask;
+        }
+        if(this->arena.size() + token.size() >= EMPTY_SLOT){
+            throw std::runtime_error("Token arena exceeds 4 GiB!");
+        }
+        this->slots[index] = Slot{hash, static_cast<std::uint32_t>(this->arena.size()),
+                                  static_cast<std::uint32_t>(token.size()), 0};
+        this->arena.append(token.data(), token.size());
+        this->entries++;
+        return this->slots[index];
+    }
+
+    void grow(){
+        std::vector<Slot> previous(this->slots.empty() ? 16 : this->slots.size() * 2, Slot{0, 0, EMPTY_SLOT, 0});
+        previous.swap(this->slots);
+        std::size_t mask = this->slots.size() - 1;
+        for(const Slot &slot: previous){
+            if(slot.length == EMPTY_SLOT){
+                continue;
+            }
+            std::size_t index = slot.hash & mask;
+            while(this->slots[index].length != EMPTY_SLOT){
+                index = (index + 1) & mask;
+            }
+            this->slots[index] = slot;
+        }
+    }
+
+public:
+    // Default constructor
+    TokenCountTable(){};
+
+    // Initialization Constructor - pre-sizes the table for an expected number of distinct tokens
+    explicit TokenCountTable(std::size_t expected_tokens){
+        this->reserve(expected_tokens);
+    }
+
+    // 64-bit FNV-1a - computed once per token, then kept in the slot
+    // Passing the hash of a prefix as seed continues it over the rest of the bytes - used for streamed checksums
+    static std::uint64_t hashToken(std::string_view token, std::uint64_t hash = 14695981039346656037ULL){
+        for(unsigned char byte: token){
+            hash ^= byte;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Pre-sizes the table so that expected_tokens distinct tokens fit without growing
+    void reserve(std::size_t expected_tokens){
+        while(this->slots.size() * 3 < expected_tokens * 4){
+            this->grow();
+        }
+    }
+
+    // Adds count occurrences of a token
+    void add(std::string_view token, std::size_t count = 1){
+        this->add(token, hashToken(token), count);
+    }
+
+    // Adds count occurrences of a token whose hash is already known
+    void add(std::string_view token, std::uint64_t hash, std::size_t count){
+        this->findOrInsert(token, hash).count += count;
+    }
+
+    // Returns the count of a token - a token that is absent is inserted with count first
+    std::size_t findOrAdd(std::string_view token, std::size_t count){
+        std::size_t entriesBefore = this->entries;
+        Slot &slot = this->findOrInsert(token, hashToken(token));
+        if(this->entries != entriesBefore){
+            slot.count = count;
+        }
+        return slot.count;
+    }
+
+    // Adds every entry of another table
+    void merge(const TokenCountTable &other){
+        for(const Slot &slot: other.slots){
+            if(slot.length != EMPTY_SLOT){
+                this->add(std::string_view(other.arena.data() + slot.offset, slot.length), slot.hash, slot.count);
+            }
+        }
+    }
+
+    // Getter - count of a token, 0 if absent
+    std::size_t getCount(std::string_view token) const{
+        if(this->slots.empty()){
+            return 0;
+        }
+        std::uint64_t hash = hashToken(token);
+        std::size_t mask = this->slots.size() - 1;
+        for(std::size_t index = hash & mask; this->slots[index].length != EMPTY_SLOT; index = (index + 1) & mask){
+            if(this->matches(this->slots[index], hash, token)){
+                return this->slots[index].count;
+            }
+        }
+        return 0;
+    }
+
+    // Getters
+    std::size_t size() const{
+        return this->entries;
+    }
+    bool empty() const{
+        return this->entries == 0;
+    }
+    std::size_t getMemoryBytes() const{
+        return this->getSlotBytes() + this->arena.capacity();
+    }
+    // Bytes of the slot array alone - getMemoryBytes() less the arena
+    std::size_t getSlotBytes() const{
+        return this->slots.capacity() * sizeof(Slot);
+    }
+    // Total bytes of the distinct tokens
+    std::size_t getTokenBytes() const{
+        return this->arena.size();
+    }
+
+    // Calls visit(token, count) for every entry, in slot order - for passes that do not need the sort
+    template<typename Visitor>
+    void forEachEntry(Visitor &&visit) const{
+        for(const Slot &slot: this->slots){
+            if(slot.length != EMPTY_SLOT){
+                visit(std::string_view(this->arena.data() + slot.offset, slot.length), slot.count);
+            }
+        }
+    }
+
+    // Entries in ascending token order (std::string ordering) - the only sort of the aggregation
+    // The views point into this table and stay valid until it is modified
+    std::vector<std::pair<std::string_view, std::size_t>> sortedEntries() const{
+        std::vector<std::pair<std::string_view, std::size_t>> sorted;
+        sorted.reserve(this->entries);
+        for(const Slot &slot: this->slots){
+            if(slot.length != EMPTY_SLOT){
+                sorted.emplace_back(std::string_view(this->arena.data() + slot.offset, slot.length), slot.count);
+            }
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto &left, const auto &right){
+            return left.first < right.first;
+        });
+        return sorted;
+    }
+
+    // Conversion to the container used by the library shufflers and reducers
+    std::map<std::string, std::size_t> toMap() const{
+        std::map<std::string, std::size_t> tokenCounts;
+        for(const auto &entry: this->sortedEntries()){
+            // keys arrive in order - every insert lands at the end of the tree
+            tokenCounts.emplace_hint(tokenCounts.end(), std::string(entry.first), entry.second);
+        }
+        return tokenCounts;
+    }
+
+    // Serialises the table in the "(token,count)" line format of temp_shuffler and final_output
+    void appendSortedLines(std::string &buffer) const{
+        for(const auto &entry: this->sortedEntries()){
+            buffer += '(';
+            buffer.append(entry.first.data(), entry.first.size());
+            buffer += ',';
+            buffer += std::to_string(entry.second);
+            buffer += ")\n";
+        }
+    }
+
+    void clear(){
+        this->slots.clear();
+        this->arena.clear();
+        this->entries = 0;
+    }
+};
+
+// Helper - parses one "(token,count)" line of temp_mapper/temp_shuffler/final_output
+// Returns false for lines that do not follow the format
+inline bool parseTokenCountLine(std::string_view line, std::string_view &token, std::size_t &count){
+    if(!line.empty() && line.back() == '\r'){
+        line.remove_suffix(1);
+    }
+    if(line.size() < 4 || line.front() != '(' || line.back() != ')'){
+        return false;
+    }
+    std::string_view body = line.substr(1, line.size() - 2);
+    std::size_t separator = body.rfind(',');
+    if(separator == std::string_view::npos || separator + 1 == body.size()){
+        return false;
+    }
+    std::size_t value = 0;
+    for(char digit: body.substr(separator + 1)){
+        if(digit < '0' || digit > '9'){
+            return false;
+        }
+        value = value * 10 + static_cast<std::size_t>(digit - '0');
+    }
+    token = body.substr(0, separator);
+    count = value;
+    return true;
+}
+
+// Helper - aggregates every "(token,count)" line of a buffer into a table; returns the number of lines aggregated
+inline std::size_t aggregateTokenCountLines(std::string_view buffer, TokenCountTable &table){
+    std::string_view token;
+    std::size_t count = 0;
+    std::size_t lines = 0;
+    while(!buffer.empty()){
+        std::size_t end = buffer.find('\n');
+        std::string_view line = buffer.substr(0, end);
+        if(parseTokenCountLine(line, token, count)){
+            table.add(token, count);
+            lines++;
+        }
+        buffer.remove_prefix(end == std::string_view::npos ? buffer.size() : end + 1);
+    }
+    return lines;
+}
+
+// Helper - reads a whole file in one go
+inline std::string readWholeFile(const std::string &file_path){
+    std::ifstream input(file_path, std::ios::in | std::ios::binary);
+    if(!input){
+        throw std::runtime_error("Cannot open file!: " + file_path);
+    }
+    input.seekg(0, std::ios::end);
+    std::string buffer(static_cast<std::size_t>(input.tellg()), '\0');
+    input.seekg(0, std::ios::beg);
+    input.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    return buffer;
+}
+
+#endif //MAPREDUCELIB_TOKENCOUNTTABLE_HPP
@@ -0,0 +1,211 @@
+/*
+ * Description: Concurrent token dictionary - interns the tokens of a job and assigns them dense 32-bit IDs
+ */
+#ifndef MAPREDUCELIB_TOKENDICTIONARY_HPP
+#define MAPREDUCELIB_TOKENDICTIONARY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "TokenCountTable.hpp"
+
+// Shards of the dictionary - picked by the low bits of the token hash, so concurrent mappers rarely share a lock
+constexpr std::size_t TOKEN_DICTIONARY_SHARDS = 64;
+// IDs per segment of the ID -> token index - segments are allocated as the dictionary grows and never move
+constexpr std::size_t TOKEN_DICTIONARY_SEGMENT_IDS = 1 << 16;
+// Bytes per block of token storage - tokens are copied into blocks that never move
+constexpr std::size_t TOKEN_DICTIONARY_BLOCK_BYTES = 1 << 20;
+
+// Token <-> ID mapping shared by every task of a job:
+//  * intern assigns IDs 0, 1, 2, ... in the order tokens are first seen - the IDs of a job are dense
+//  * lookup resolves an ID back to its token - the views stay valid for the lifetime of the dictionary
+// Concurrency contract: intern and lookup may be called from any number of threads. An ID handed to another thread
+// through a future or a task is always resolvable there - its token is stored before the ID is returned.
+class TokenDictionary{
+private:
+    struct Slot{
+        std::uint64_t hash;
+        // EMPTY_ID marks an unused slot
+        std::uint32_t id;
+    };
+    // Tokens whose hash falls in this shard - open addressing over the full 64-bit hash, like TokenCountTable
+    struct Shard{
+        std::shared_mutex mutex;
+        std::vector<Slot> slots;
+        std::size_t entries = 0;
+        // token storage - blocks of TOKEN_DICTIONARY_BLOCK_BYTES, or one block per larger token
+        std::vector<std::unique_ptr<char[]>> blocks;
+        // block the small tokens are copied into
+        char* currentBlock = nullptr;
+        std::size_t blockUsed = 0;
+        std::size_t storedBytes = 0;
+    };
+    static constexpr std::uint32_t EMPTY_ID = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::size_t MAX_SEGMENTS = (std::size_t(1) << 32) / TOKEN_DICTIONARY_SEGMENT_IDS;
+
+    std::array<Shard, TOKEN_DICTIONARY_SHARDS> shards;
+    // ID -> token, one segment of TOKEN_DICTIONARY_SEGMENT_IDS views at a time
+    std::unique_ptr<std::atomic<std::string_view*>[]> segments;
+    std::atomic<std::uint32_t> nextId{0};
+
+    static std::size_t shardOf(std::uint64_t hash){
+        return hash % TOKEN_DICTIONARY_SHARDS;
+    }
+
+    // Slot index of a hash within a shard - the bits above the shard bits
+    static std::size_t slotOf(std::uint64_t hash, std::size_t mask){
+        return (hash / TOKEN_DICTIONARY_SHARDS) & mask;
+    }
+
+    // Index of an existing token in the shard's slots - the first empty slot of its probe sequence if absent
+    std::size_t probe(const Shard &shard, std::uint64_t hash, std::string_view token) const{
+        std::size_t mask = shard.slots.size() - 1;
+        std::size_t index = slotOf(hash, mask);
+        while(shard.slots[index].id != EMPTY_ID){
+            if(shard.slots[index].hash == hash && this->lookup(shard.slots[index].id) == token){
+                return index;
+            }
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    static void grow(Shard &shard){
+        std::vector<Slot> previous(shard.slots.empty() ? 64 : shard.slots.size() * 2, Slot{0, EMPTY_ID});
+        previous.swap(shard.slots);
+        std::size_t mask = shard.slots.size() - 1;
+        for(const Slot &slot: previous){
+            if(slot.id == EMPTY_ID){
+                continue;
+            }
+            std::size_t index = slotOf(slot.hash, mask);
+            while(shard.slots[index].id != EMPTY_ID){
+                index = (index + 1) & mask;
+            }
+            shard.slots[index] = slot;
+        }
+    }
+
+    // Copies a token into the shard's storage - the copy never moves
+    static std::string_view store(Shard &shard, std::string_view token){
+        char* destination;
+        if(token.size() > TOKEN_DICTIONARY_BLOCK_BYTES / 16){
+            // a large token gets a block of its own - the current block keeps filling up
+            shard.blocks.push_back(std::make_unique<char[]>(token.size()));
+            destination = shard.blocks.back().get();
+        } else {
+            if(!shard.currentBlock || shard.blockUsed + token.size() > TOKEN_DICTIONARY_BLOCK_BYTES){
+                shard.blocks.push_back(std::make_unique<char[]>(TOKEN_DICTIONARY_BLOCK_BYTES));
+                shard.currentBlock = shard.blocks.back().get();
+                shard.blockUsed = 0;
+            }
+            destination = shard.currentBlock + shard.blockUsed;
+            shard.blockUsed += token.size();
+        }
+        std::memcpy(destination, token.data(), token.size());
+        shard.storedBytes += token.size();
+        return std::string_view(destination, token.size());
+    }
+
+    // Stores the view of a new ID - allocates its segment if it is the first ID of one
+    void publish(std::uint32_t id, std::string_view token){
+        std::atomic<std::string_view*> &segment = this->segments[id / TOKEN_DICTIONARY_SEGMENT_IDS];
+        std::string_view* views = segment.load(std::memory_order_acquire);
+        if(!views){
+            auto* allocated = new std::string_view[TOKEN_DICTIONARY_SEGMENT_IDS];
+            if(segment.compare_exchange_strong(views, allocated, std::memory_order_acq_rel)){
+                views = allocated;
+            } else {
+                // another shard allocated it first
+                delete[] allocated;
+            }
+        }
+        views[id % TOKEN_DICTIONARY_SEGMENT_IDS] = token;
+    }
+
+public:
+    // Default Constructor - an empty dictionary
+    TokenDictionary() : segments(new std::atomic<std::string_view*>[MAX_SEGMENTS]){
+        for(std::size_t i = 0; i < MAX_SEGMENTS; i++){
+            this->segments[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // Not copyable - tasks share the dictionary of their job
+    TokenDictionary(const TokenDictionary &) = delete;
+    TokenDictionary& operator=(const TokenDictionary &) = delete;
+
+    // Destructor
+    ~TokenDictionary(){
+        for(std::size_t i = 0; i < MAX_SEGMENTS; i++){
+            delete[] this->segments[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // ID of a token - assigned on first sight
+    std::uint32_t intern(std::string_view token){
+        return this->intern(token, TokenCountTable::hashToken(token));
+    }
+
+    // ID of a token whose hash is already known
+    std::uint32_t intern(std::string_view token, std::uint64_t hash){
+        Shard &shard = this->shards[shardOf(hash)];
+        {
+            // most tokens of a job are seen many times - they only take the shared lock
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            if(!shard.slots.empty()){
+                const Slot &slot = shard.slots[this->probe(shard, hash, token)];
+                if(slot.id != EMPTY_ID){
+                    return slot.id;
+                }
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if((shard.entries + 1) * 4 > shard.slots.size() * 3){
+            grow(shard);
+        }
+        // another mapper may have added it in between
+        std::size_t index = this->probe(shard, hash, token);
+        if(shard.slots[index].id != EMPTY_ID){
+            return shard.slots[index].id;
+        }
+        std::uint32_t id = this->nextId.fetch_add(1);
+        if(id == EMPTY_ID){
+            throw std::runtime_error("Token dictionary exceeds 2^32 - 1 tokens!");
+        }
+        this->publish(id, store(shard, token));
+        shard.slots[index] = Slot{hash, id};
+        shard.entries++;
+        return id;
+    }
+
+    // Token of an ID - the ID must have been returned by intern
+    std::string_view lookup(std::uint32_t id) const{
+        return this->segments[id / TOKEN_DICTIONARY_SEGMENT_IDS].load(std::memory_order_acquire)[id % TOKEN_DICTIONARY_SEGMENT_IDS];
+    }
+
+    // Getters
+    // Distinct tokens interned so far
+    std::size_t size() const{
+        return this->nextId.load();
+    }
+    // Bytes of the distinct tokens
+    std::size_t getTokenBytes(){
+        std::size_t bytes = 0;
+        for(Shard &shard: this->shards){
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            bytes += shard.storedBytes;
+        }
+        return bytes;
+    }
+};
+
+#endif //MAPREDUCELIB_TOKENDICTIONARY_HPP
@@ -0,0 +1,158 @@
+/*
+ * Description: Hash aggregation keyed by token ID - the counterpart of TokenCountTable for jobs run with --token-ids
+ */
+#ifndef MAPREDUCELIB_TOKENIDTABLE_HPP
+#define MAPREDUCELIB_TOKENIDTABLE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "TokenDictionary.hpp"
+
+// (token ID -> count) table - adding a count is an integer multiply, a mask and (mostly) one slot compare:
+//  * the IDs come from the job's TokenDictionary, the table never sees a token byte
+//  * Fibonacci hashing over a power-of-two slot array, linear probing, grown at 3/4 load
+// Entries are unordered - the tokens are only looked up and sorted once, when final_output is written.
+class TokenIdTable{
+private:
+    struct Slot{
+        // EMPTY_ID marks an unused slot
+        std::uint32_t id;
+        std::size_t count;
+    };
+    static constexpr std::uint32_t EMPTY_ID = std::numeric_limits<std::uint32_t>::max();
+
+    std::vector<Slot> slots;
+    std::size_t entries = 0;
+    // 64 - log2(slot count)
+    unsigned shift = 64;
+
+    std::size_t slotOf(std::uint32_t id) const{
+        return static_cast<std::size_t>((id * 0x9E3779B97F4A7C15ULL) >> this->shift);
+    }
+
+    void grow(){
+        std::vector<Slot> previous(this->slots.empty() ? 16 : this->slots.size() * 2, Slot{EMPTY_ID, 0});
+        previous.swap(this->slots);
+        this->shift = 64;
+        for(std::size_t size = this->slots.size(); size > 1; size >>= 1){
+            this->shift--;
+        }
+        std::size_t mask = this->slots.size() - 1;
+        for(const Slot &slot: previous){
+            if(slot.id == EMPTY_ID){
+                continue;
+            }
+            std::size_t index = this->slotOf(slot.id);
+            while(this->slots[index].id != EMPTY_ID){
+                index = (index + 1) & mask;
+            }
+            this->slots[index] = slot;
+        }
+    }
+
+public:
+    // Default constructor
+    TokenIdTable(){};
+
+    // Pre-sizes the table so that expected_tokens distinct IDs fit without growing
+    void reserve(std::size_t expected_tokens){
+        while(this->slots.size() * 3 < expected_tokens * 4){
+            this->grow();
+        }
+    }
+
+    // Adds count occurrences of a token ID
+    void add(std::uint32_t id, std::size_t count = 1){
+        if((this->entries + 1) * 4 > this->slots.size() * 3){
+            this->grow();
+        }
+        std::size_t mask = this->slots.size() - 1;
+        std::size_t index = this->slotOf(id);
+        while(this->slots[index].id != id){
+            if(this->slots[index].id == EMPTY_ID){
+                this->slots[index].id = id;
+                this->entries++;
+                break;
+            }
+            index = (index + 1) & mask;
+        }
+        this->slots[index].count += count;
+    }
+
+    // Adds every entry of another table
+    void merge(const TokenIdTable &other){
+        this->reserve(this->entries + other.entries);
+        for(const Slot &slot: other.slots){
+            if(slot.id != EMPTY_ID){
+                this->add(slot.id, slot.count);
+            }
+        }
+    }
+
+    // Getters
+    std::size_t size() const{
+        return this->entries;
+    }
+    bool empty() const{
+        return this->entries == 0;
+    }
+    std::size_t getMemoryBytes() const{
+        return this->slots.capacity() * sizeof(Slot);
+    }
+
+    // Calls visit(id, count) for every entry, in slot order
+    template<typename Visitor>
+    void forEachEntry(Visitor &&visit) const{
+        for(const Slot &slot: this->slots){
+            if(slot.id != EMPTY_ID){
+                visit(slot.id, slot.count);
+            }
+        }
+    }
+
+    // Entries in ascending token order, resolved through the dictionary - the same order as TokenCountTable::sortedEntries
+    std::vector<std::pair<std::string_view, std::size_t>> sortedEntries(const TokenDictionary &dictionary) const{
+        std::vector<std::pair<std::string_view, std::size_t>> sorted;
+        sorted.reserve(this->entries);
+        this->forEachEntry([&sorted, &dictionary](std::uint32_t id, std::size_t count){
+            sorted.emplace_back(dictionary.lookup(id), count);
+        });
+        std::sort(sorted.begin(), sorted.end(), [](const auto &left, const auto &right){
+            return left.first < right.first;
+        });
+        return sorted;
+    }
+
+    // Appends one "(token,count)" line per entry, in token order - the final_output layout
+    void appendSortedLines(std::string &buffer, const TokenDictionary &dictionary) const{
+        for(const auto &entry: this->sortedEntries(dictionary)){
+            buffer += '(';
+            buffer.append(entry.first.data(), entry.first.size());
+            buffer += ',';
+            buffer += std::to_string(entry.second);
+            buffer += ")\n";
+        }
+    }
+
+    // Bytes of the tokens of the entries - looked up in the dictionary
+    std::size_t getTokenBytes(const TokenDictionary &dictionary) const{
+        std::size_t bytes = 0;
+        this->forEachEntry([&bytes, &dictionary](std::uint32_t id, std::size_t){
+            bytes += dictionary.lookup(id).size();
+        });
+        return bytes;
+    }
+
+    void clear(){
+        this->slots.clear();
+        this->entries = 0;
+        this->shift = 64;
+    }
+};
+
+#endif //MAPREDUCELIB_TOKENIDTABLE_HPP
@@ -0,0 +1,305 @@
+/*
+ * Description: Tokenizer kernels of NativeMapper - scalar, SSE2 and AVX2, chosen once at runtime
+ */
+#ifndef MAPREDUCELIB_TOKENIZER_HPP
+#define MAPREDUCELIB_TOKENIZER_HPP
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "CompactMapperOutput.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MAPREDUCELIB_TOKENIZER_X86 1
+#include <immintrin.h>
+#endif
+
+// Byte classes of the tokenizer - the same rules as MapperImpl:
+// ' ' separates tokens, punctuation (and '\n') is dropped, upper case ASCII is folded, empty tokens are skipped
+enum TokenByteClass : unsigned char {
+    TOKEN_KEEP = 0,
+    TOKEN_DELIMITER = 1,
+    TOKEN_DROP = 2
+};
+
+// Helper - byte class and folded value of every byte, computed once
+struct TokenizerTable{
+    std::array<unsigned char, 256> byteClass{};
+    std::array<char, 256> folded{};
+
+    TokenizerTable(){
+        for(int c = 0; c < 256; c++){
+            // bytes above 0x7f are neither punctuation nor upper case in the "C" locale the libraries run under
+            bool ascii = c < 0x80;
+            if(c == ' '){
+                this->byteClass[c] = TOKEN_DELIMITER;
+            } else if(c == '\n' || (ascii && std::ispunct(c))){
+                this->byteClass[c] = TOKEN_DROP;
+            } else {
+                this->byteClass[c] = TOKEN_KEEP;
+            }
+            this->folded[c] = static_cast<char>(ascii ? std::tolower(c) : c);
+        }
+    }
+
+    static const TokenizerTable& instance(){
+        static const TokenizerTable table;
+        return table;
+    }
+};
+
+// Kernel signature - tokenizes a buffer into the arena of a compact output
+//  * split_records == false: the buffer is one record ('\n' is dropped like punctuation)
+//  * split_records == true:  the buffer holds '\n' terminated records, split the way std::getline splits them
+typedef void tokenizerKernel_t(const char* data, std::size_t size, CompactMapperOutput &output, bool split_records);
+
+// Bytes the kernels may write past the end of the tokens - every run of kept bytes is copied as one full chunk
+constexpr std::size_t TOKENIZER_ARENA_SLACK = 64;
+
+// Tokenizer state carried across the chunks of one buffer
+// The arena is sized for the whole buffer up front (tokens are never longer than their input) and written through a
+// raw pointer - no capacity check per byte; finish() trims it to the bytes actually used
+struct TokenizerCursor{
+    CompactMapperOutput &output;
+    std::string &arena;
+    char* base;
+    std::size_t written;
+    std::size_t tokenStart;
+
+    TokenizerCursor(CompactMapperOutput &compact_output, std::size_t input_size)
+            : output(compact_output), arena(compact_output.getArena()){
+        this->written = this->arena.size();
+        this->tokenStart = this->written;
+        this->arena.resize(this->written + input_size + TOKENIZER_ARENA_SLACK);
+        this->base = &this->arena[0];
+    }
+
+    // Closes the current token, if it has any bytes
+    void endToken(){
+        if(this->written > this->tokenStart){
+            this->output.commitTokenAt(this->tokenStart, this->written - this->tokenStart);
+        }
+        this->tokenStart = this->written;
+    }
+
+    // Closes the current record - and the token it ends with
+    void endRecord(){
+        this->endToken();
+        this->output.endRecord();
+    }
+
+    // Drops the unused tail of the arena
+    void finish(){
+        this->arena.resize(this->written);
+    }
+};
+
+// Helper - scalar tokenization of a byte range, one table lookup per byte
+template<bool SplitRecords>
+inline void tokenizeBytesScalar(const char* data, std::size_t size, TokenizerCursor &cursor){
+    const TokenizerTable &table = TokenizerTable::instance();
+    for(std::size_t i = 0; i < size; i++){
+        unsigned char byte = static_cast<unsigned char>(data[i]);
+        if(SplitRecords && byte == '\n'){
+            cursor.endRecord();
+            continue;
+        }
+        unsigned char byteClass = table.byteClass[byte];
+        if(byteClass == TOKEN_KEEP){
+            cursor.base[cursor.written++] = table.folded[byte];
+        } else if(byteClass == TOKEN_DELIMITER){
+            cursor.endToken();
+        }
+    }
+}
+
+// Helper - closes a buffer: the last token, and the last record unless a '\n' already closed it
+template<bool SplitRecords>
+inline void finishTokenizing(const char* data, std::size_t size, TokenizerCursor &cursor){
+    if(!SplitRecords || (size > 0 && data[size - 1] != '\n')){
+        cursor.endRecord();
+    }
+    cursor.finish();
+}
+
+inline void tokenizeScalar(const char* data, std::size_t size, CompactMapperOutput &output, bool split_records){
+    TokenizerCursor cursor(output, size);
+    if(split_records){
+        tokenizeBytesScalar<true>(data, size, cursor);
+        finishTokenizing<true>(data, size, cursor);
+    } else {
+        tokenizeBytesScalar<false>(data, size, cursor);
+        finishTokenizing<false>(data, size, cursor);
+    }
+}
+
+#ifdef MAPREDUCELIB_TOKENIZER_X86
+// Helper - applies one classified chunk of width (16 or 32) bytes
+// folded holds the case-folded bytes followed by 32 bytes of padding, bit i of each mask describes byte i:
+//  * delimiters - ' ' (and '\n' when splitting records)
+//  * newlines   - '\n' when splitting records
+//  * drops      - punctuation (and '\n' when not splitting records)
+// Every run of kept bytes is one fixed 32-byte copy and one bit scan - there is no per-byte branch
+inline void applyClassifiedChunk(const char* folded, std::size_t width, std::uint64_t delimiters, std::uint64_t newlines,
+                                 std::uint64_t drops, TokenizerCursor &cursor){
+    std::uint64_t removed = delimiters | drops;
+    std::size_t position = 0;
+    while(true){
+        std::uint64_t remaining = removed >> position;
+        // the copy may run past the run - the bytes beyond it are overwritten next, or trimmed by finish()
+        std::memcpy(cursor.base + cursor.written, folded + position, 32);
+        if(remaining == 0){
+            cursor.written += width - position;
+            return;
+        }
+        std::size_t removedAt = position + static_cast<std::size_t>(__builtin_ctzll(remaining));
+        cursor.written += removedAt - position;
+        if((newlines >> removedAt) & 1U){
+            cursor.endRecord();
+        } else if((delimiters >> removedAt) & 1U){
+            cursor.endToken();
+        }
+        position = removedAt + 1;
+        if(position == width){
+            return;
+        }
+    }
+}
+
+// SSE2 - part of the x86-64 baseline, classifies 16 bytes per step
+template<bool SplitRecords>
+inline void tokenizeBytesSse2(const char* data, std::size_t size, TokenizerCursor &cursor){
+    alignas(16) char folded[16 + 32] = {};
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    // signed compares - bytes above 0x7f are negative and fall outside every ASCII range
+    auto inRange = [](__m128i bytes, char low, char high){
+        return _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(static_cast<char>(low - 1))),
+                             _mm_cmplt_epi8(bytes, _mm_set1_epi8(static_cast<char>(high + 1))));
+    };
+    std::size_t i = 0;
+    for(; i + 16 <= size; i += 16){
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i punctuation = _mm_or_si128(_mm_or_si128(inRange(bytes, 0x21, 0x2F), inRange(bytes, 0x3A, 0x40)),
+                                           _mm_or_si128(inRange(bytes, 0x5B, 0x60), inRange(bytes, 0x7B, 0x7E)));
+        __m128i upper = inRange(bytes, 'A', 'Z');
+        _mm_store_si128(reinterpret_cast<__m128i*>(folded), _mm_add_epi8(bytes, _mm_and_si128(upper, caseBit)));
+        auto spaces = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, space)));
+        auto newlines = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+        auto drops = static_cast<std::uint32_t>(_mm_movemask_epi8(punctuation));
+        if(SplitRecords){
+            applyClassifiedChunk(folded, 16, spaces | newlines, newlines, drops, cursor);
+        } else {
+            applyClassifiedChunk(folded, 16, spaces, 0, drops | newlines, cursor);
+        }
+    }
+    tokenizeBytesScalar<SplitRecords>(data + i, size - i, cursor);
+}
+
+inline void tokenizeSse2(const char* data, std::size_t size, CompactMapperOutput &output, bool split_records){
+    TokenizerCursor cursor(output, size);
+    if(split_records){
+        tokenizeBytesSse2<true>(data, size, cursor);
+        finishTokenizing<true>(data, size, cursor);
+    } else {
+        tokenizeBytesSse2<false>(data, size, cursor);
+        finishTokenizing<false>(data, size, cursor);
+    }
+}
+
+// AVX2 - classifies 32 bytes per step; compiled for AVX2 only here, so the rest of the build keeps the baseline ISA
+__attribute__((target("avx2")))
+inline __m256i avx2ByteRange(__m256i bytes, char low, char high){
+    return _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(static_cast<char>(low - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(high + 1)), bytes));
+}
+
+template<bool SplitRecords>
+__attribute__((target("avx2")))
+inline void tokenizeBytesAvx2(const char* data, std::size_t size, TokenizerCursor &cursor){
+    alignas(32) char folded[32 + 32] = {};
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    std::size_t i = 0;
+    for(; i + 32 <= size; i += 32){
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i punctuation = _mm256_or_si256(
+                _mm256_or_si256(avx2ByteRange(bytes, 0x21, 0x2F), avx2ByteRange(bytes, 0x3A, 0x40)),
+                _mm256_or_si256(avx2ByteRange(bytes, 0x5B, 0x60), avx2ByteRange(bytes, 0x7B, 0x7E)));
+        __m256i upper = avx2ByteRange(bytes, 'A', 'Z');
+        _mm256_store_si256(reinterpret_cast<__m256i*>(folded), _mm256_add_epi8(bytes, _mm256_and_si256(upper, caseBit)));
+        auto spaces = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, space)));
+        auto newlines = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+        auto drops = static_cast<std::uint32_t>(_mm256_movemask_epi8(punctuation));
+        if(SplitRecords){
+            applyClassifiedChunk(folded, 32, spaces | newlines, newlines, drops, cursor);
+        } else {
+            applyClassifiedChunk(folded, 32, spaces, 0, drops | newlines, cursor);
+        }
+    }
+    tokenizeBytesScalar<SplitRecords>(data + i, size - i, cursor);
+}
+
+inline void tokenizeAvx2(const char* data, std::size_t size, CompactMapperOutput &output, bool split_records){
+    TokenizerCursor cursor(output, size);
+    if(split_records){
+        tokenizeBytesAvx2<true>(data, size, cursor);
+        finishTokenizing<true>(data, size, cursor);
+    } else {
+        tokenizeBytesAvx2<false>(data, size, cursor);
+        finishTokenizing<false>(data, size, cursor);
+    }
+}
+#endif
+
+// A tokenizer kernel and the name it is reported under
+struct TokenizerKernel{
+    const char* name;
+    tokenizerKernel_t* tokenize;
+};
+
+// Every kernel the running CPU supports, fastest last
+inline std::vector<TokenizerKernel> availableTokenizerKernels(){
+    std::vector<TokenizerKernel> kernels{{"scalar", tokenizeScalar}};
+#ifdef MAPREDUCELIB_TOKENIZER_X86
+    kernels.push_back({"sse2", tokenizeSse2});
+    if(__builtin_cpu_supports("avx2")){
+        kernels.push_back({"avx2", tokenizeAvx2});
+    }
+#endif
+    return kernels;
+}
+
+// The kernel NativeMapper uses - picked once per process
+inline const TokenizerKernel& activeTokenizerKernel(){
+    static const TokenizerKernel kernel = availableTokenizerKernels().back();
+    return kernel;
+}
+
+// Helper - true when a record yields at least one token
+inline bool recordHasTokens(std::string_view record){
+    const TokenizerTable &table = TokenizerTable::instance();
+    for(char c: record){
+        if(table.byteClass[static_cast<unsigned char>(c)] == TOKEN_KEEP){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tokenizes one input record into the arena of a compact output and closes the record
+inline void tokenizeRecord(const char* data, std::size_t size, CompactMapperOutput &output){
+    activeTokenizerKernel().tokenize(data, size, output, false);
+}
+
+// Tokenizes a buffer of '\n' terminated records - one record per line, as std::getline splits them
+inline void tokenizeRecords(const char* data, std::size_t size, CompactMapperOutput &output){
+    activeTokenizerKernel().tokenize(data, size, output, true);
+}
+
+#endif //MAPREDUCELIB_TOKENIZER_HPP
@@ -0,0 +1,323 @@
+/*
+ * Description: Bounded work-stealing executor shared by all phases of mapReduceWorkflow
+ */
+#ifndef MAPREDUCELIB_WORKSTEALINGPOOL_HPP
+#define MAPREDUCELIB_WORKSTEALINGPOOL_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "JobPhase.hpp"
+#include "TaskMetrics.hpp"
+
+// Snapshot of the per-phase executor counters
+struct PhaseQueueStats{
+    // tasks handed to the executor
+    std::size_t submitted = 0;
+    // tasks that finished running
+    std::size_t executed = 0;
+    // tasks taken from another worker's deque
+    std::size_t stolen = 0;
+    // highest number of tasks of this phase waiting in the deques at once
+    std::size_t peakQueueDepth = 0;
+};
+
+// A fixed set of worker threads, each owning a deque of tasks.
+// Workers pop their own deque from the back (most recent first) and, when it is empty,
+// steal from the front of the other deques. Tasks submitted from outside the pool are
+// spread round-robin across the deques; tasks submitted by a worker land on its own deque.
+class WorkStealingPool{
+private:
+    // Unit of work - the phase is kept for accounting
+    struct Task{
+        JobPhase phase;
+        std::function<void()> run;
+    };
+    // Deque owned by a single worker
+    struct WorkerQueue{
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        // metrics of the tasks run by the owning worker - only ever touched by that worker until the pool is idle,
+        // so recording takes no lock; the same buffer backs the --trace timeline
+        std::vector<TaskMetrics> taskMetrics;
+        // kernel thread id of the owning worker - set by the worker before it runs any task
+        long threadId = 0;
+    };
+    // Per-phase counters - updated without locks
+    struct PhaseCounters{
+        std::atomic<std::size_t> submitted{0};
+        std::atomic<std::size_t> executed{0};
+        std::atomic<std::size_t> stolen{0};
+        std::atomic<std::size_t> queueDepth{0};
+        std::atomic<std::size_t> peakQueueDepth{0};
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    // time base of TaskMetrics::startSeconds
+    std::chrono::steady_clock::time_point poolStart = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    std::array<PhaseCounters, JOB_PHASE_COUNT> counters;
+    // next deque used for submissions from outside the pool
+    std::atomic<std::size_t> nextQueue{0};
+    // tasks sitting in the deques - guarded by wakeMutex for sleeping/waking workers
+    std::size_t pendingTasks = 0;
+    // tasks currently running - guarded by wakeMutex
+    std::size_t runningTasks = 0;
+    bool stopping = false;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    // signalled whenever the pool runs out of queued and running tasks
+    std::condition_variable idleCondition;
+
+    // Identifies the pool and deque owned by the calling thread, if it is a worker
+    struct WorkerIdentity{
+        const WorkStealingPool* pool = nullptr;
+        std::size_t index = 0;
+    };
+    static WorkerIdentity& currentWorker(){
+        static thread_local WorkerIdentity identity;
+        return identity;
+    }
+
+    // Places a task on a deque and wakes a sleeping worker
+    void enqueue(Task task){
+        PhaseCounters &phaseCounters = this->counters[phaseIndex(task.phase)];
+        WorkerIdentity &identity = currentWorker();
+        std::size_t target = identity.pool == this
+                ? identity.index
+                : this->nextQueue.fetch_add(1, std::memory_order_relaxed) % this->queues.size();
+        phaseCounters.submitted.fetch_add(1, std::memory_order_relaxed);
+        std::size_t depth = phaseCounters.queueDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::size_t peak = phaseCounters.peakQueueDepth.load(std::memory_order_relaxed);
+        while(depth > peak && !phaseCounters.peakQueueDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)){
+        }
+        {
+            // counted and queued in one critical section - a worker that takes the task at once and decrements
+            // pendingTasks in execute() must never find it uncounted
+            std::lock_guard<std::mutex> wakeLock(this->wakeMutex);
+            this->pendingTasks++;
+            std::lock_guard<std::mutex> queueLock(this->queues[target]->mutex);
+            this->queues[target]->tasks.push_back(std::move(task));
+        }
+        this->wakeCondition.notify_one();
+    }
+
+    // Pops the most recent task of the worker's own deque
+    bool popLocal(std::size_t index, Task &task){
+        std::lock_guard<std::mutex> queueLock(this->queues[index]->mutex);
+        if(this->queues[index]->tasks.empty()){
+            return false;
+        }
+        task = std::move(this->queues[index]->tasks.back());
+        this->queues[index]->tasks.pop_back();
+        return true;
+    }
+
+    // Takes the oldest task of another worker's deque
+    bool steal(std::size_t index, Task &task){
+        for(std::size_t offset = 1; offset < this->queues.size(); offset++){
+            WorkerQueue &victim = *this->queues[(index + offset) % this->queues.size()];
+            std::lock_guard<std::mutex> queueLock(victim.mutex);
+            if(!victim.tasks.empty()){
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                this->counters[phaseIndex(task.phase)].stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Runs a dequeued task, measures it and updates the counters
+    void execute(std::size_t index, Task &task){
+        {
+            std::lock_guard<std::mutex> wakeLock(this->wakeMutex);
+            this->pendingTasks--;
+            this->runningTasks++;
+        }
+        this->counters[phaseIndex(task.phase)].queueDepth.fetch_sub(1, std::memory_order_relaxed);
+        // two clock reads and one read of /proc/self/statm per task - cheap next to any task of the workflow
+        TaskMetrics metrics;
+        metrics.phase = task.phase;
+        metrics.worker = static_cast<unsigned>(index);
+        metrics.threadId = this->queues[index]->threadId;
+        auto start = std::chrono::steady_clock::now();
+        metrics.startSeconds = std::chrono::duration<double>(start - this->poolStart).count();
+        double cpuStart = readThreadCpuSeconds();
+        currentTaskMetrics() = &metrics;
+        task.run();
+        currentTaskMetrics() = nullptr;
+        metrics.cpuSeconds += readThreadCpuSeconds() - cpuStart;
+        metrics.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        metrics.rssKilobytesAtEnd = std::max(metrics.rssKilobytesAtEnd, readRssKilobytes());
+        this->queues[index]->taskMetrics.push_back(std::move(metrics));
+        // release the task (and whatever it captured) before reporting the pool idle
+        task.run = nullptr;
+        bool idle;
+        {
+            std::lock_guard<std::mutex> wakeLock(this->wakeMutex);
+            this->runningTasks--;
+            idle = this->pendingTasks == 0 && this->runningTasks == 0;
+        }
+        if(idle){
+            this->idleCondition.notify_all();
+        }
+    }
+
+    // Worker loop - own deque first, then steal, then sleep until new work arrives
+    void workerLoop(std::size_t index){
+        currentWorker() = WorkerIdentity{this, index};
+        this->queues[index]->threadId = readThreadId();
+        Task task;
+        while(true){
+            if(this->popLocal(index, task) || this->steal(index, task)){
+                this->execute(index, task);
+                continue;
+            }
+            std::unique_lock<std::mutex> wakeLock(this->wakeMutex);
+            this->wakeCondition.wait(wakeLock, [this]{ return this->stopping || this->pendingTasks > 0; });
+            if(this->stopping && this->pendingTasks == 0){
+                return;
+            }
+        }
+    }
+
+public:
+    // Constructor - starts the requested number of workers (at least one)
+    explicit WorkStealingPool(unsigned worker_count){
+        if(worker_count == 0){
+            worker_count = 1;
+        }
+        for(unsigned i = 0; i < worker_count; i++){
+            this->queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for(unsigned i = 0; i < worker_count; i++){
+            this->workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool &) = delete;
+
+    // Destructor - drains every queued task, then joins the workers
+    ~WorkStealingPool(){
+        {
+            std::lock_guard<std::mutex> wakeLock(this->wakeMutex);
+            this->stopping = true;
+        }
+        this->wakeCondition.notify_all();
+        for(auto &worker: this->workers){
+            worker.join();
+        }
+    }
+
+    // Submits a task on behalf of a phase - mirrors std::async, the result (or exception) comes back via the future
+    template<typename F, typename... Args>
+    auto submit(JobPhase phase, F&& function, Args&&... args){
+        using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        auto bound = std::bind(std::forward<F>(function), std::forward<Args>(args)...);
+        auto work = std::make_shared<decltype(bound)>(std::move(bound));
+        auto promise = std::make_shared<std::promise<R>>();
+        std::future<R> result = promise->get_future();
+        PhaseCounters *phaseCounters = &this->counters[phaseIndex(phase)];
+        // the task is counted as executed before its future becomes ready, so the counters
+        // are consistent for anyone who has collected every result of a phase
+        this->enqueue(Task{phase, [work, promise, phaseCounters]{
+            try{
+                if constexpr(std::is_void_v<R>){
+                    (*work)();
+                    phaseCounters->executed.fetch_add(1, std::memory_order_relaxed);
+                    promise->set_value();
+                } else {
+                    R value = (*work)();
+                    phaseCounters->executed.fetch_add(1, std::memory_order_relaxed);
+                    promise->set_value(std::move(value));
+                }
+            } catch(...){
+                phaseCounters->executed.fetch_add(1, std::memory_order_relaxed);
+                promise->set_exception(std::current_exception());
+            }
+        }});
+        return result;
+    }
+
+    // Blocks until no task is queued or running - including tasks submitted by other tasks
+    // Must not be called from a worker thread
+    void waitIdle(){
+        std::unique_lock<std::mutex> wakeLock(this->wakeMutex);
+        this->idleCondition.wait(wakeLock, [this]{ return this->pendingTasks == 0 && this->runningTasks == 0; });
+    }
+
+    // Hands over the metrics of every task run so far, ordered by start time - waits for the pool to go idle first
+    // Must not be called from a worker thread
+    std::vector<TaskMetrics> takeTaskMetrics(){
+        this->waitIdle();
+        std::vector<TaskMetrics> taskMetrics;
+        for(auto &queue: this->queues){
+            taskMetrics.insert(taskMetrics.end(), queue->taskMetrics.begin(), queue->taskMetrics.end());
+            queue->taskMetrics.clear();
+        }
+        std::sort(taskMetrics.begin(), taskMetrics.end(), [](const TaskMetrics &left, const TaskMetrics &right){
+            return left.startSeconds < right.startSeconds;
+        });
+        return taskMetrics;
+    }
+
+    // Getter - time base of TaskMetrics::startSeconds
+    std::chrono::steady_clock::time_point getStartTime() const{
+        return this->poolStart;
+    }
+
+    // Getter - number of workers
+    unsigned getWorkerCount() const{
+        return static_cast<unsigned>(this->workers.size());
+    }
+
+    // Getter - workers neither running a task nor about to pick up a queued one (a snapshot)
+    unsigned getIdleWorkerCount(){
+        std::lock_guard<std::mutex> wakeLock(this->wakeMutex);
+        std::size_t busy = this->runningTasks + this->pendingTasks;
+        return busy >= this->workers.size() ? 0 : static_cast<unsigned>(this->workers.size() - busy);
+    }
+
+    // Getter - counters for a single phase
+    PhaseQueueStats getPhaseStats(JobPhase phase) const{
+        const PhaseCounters &phaseCounters = this->counters[phaseIndex(phase)];
+        PhaseQueueStats stats;
+        stats.submitted = phaseCounters.submitted.load(std::memory_order_relaxed);
+        stats.executed = phaseCounters.executed.load(std::memory_order_relaxed);
+        stats.stolen = phaseCounters.stolen.load(std::memory_order_relaxed);
+        stats.peakQueueDepth = phaseCounters.peakQueueDepth.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Helper - prints the per-phase counters, skipping phases that never ran
+    void printStats(std::ostream &out) const{
+        out << "Executor statistics (" << this->getWorkerCount() << " workers):" << std::endl;
+        for(std::size_t i = 0; i < JOB_PHASE_COUNT; i++){
+            JobPhase phase = static_cast<JobPhase>(i);
+            PhaseQueueStats stats = this->getPhaseStats(phase);
+            if(stats.submitted == 0){
+                continue;
+            }
+            out << "  " << phaseName(phase)
+                << ": submitted=" << stats.submitted
+                << " executed=" << stats.executed
+                << " stolen=" << stats.stolen
+                << " peak_queue_depth=" << stats.peakQueueDepth << std::endl;
+        }
+    }
+};
+
+#endif //MAPREDUCELIB_WORKSTEALINGPOOL_HPP
@@ -0,0 +1,296 @@
+/*
+ * Description: Coordinator of the worker processes of a job - spawns them, hands them tasks over a Unix domain socket
+ * and replaces the ones that die
+ */
+#ifndef MAPREDUCELIB_WORKERCOORDINATOR_HPP
+#define MAPREDUCELIB_WORKERCOORDINATOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "WorkerProtocol.hpp"
+
+// Attempts of a task before the job fails - a task is only retried when its worker process died while running it
+constexpr unsigned WORKER_TASK_ATTEMPTS = 3;
+// Time a new worker process has to connect and load the plugin libraries
+constexpr int WORKER_START_TIMEOUT_MILLIS = 30000;
+
+// Runs tasks in a fixed number of worker processes (MRExec --worker=<socket>):
+//  * every worker is the MRExec binary itself - it loads the same libs/*.so plugins as the job and runs one task at a
+//    time, so a plugin that crashes or exceeds the memory limit only takes its own process down
+//  * run blocks the calling thread until a worker has run the task - the executor's tasks call it, one per worker
+//  * a worker that dies is reaped and replaced, and its task is run again on the next idle worker
+// A task that fails with an error (rather than a dead process) fails the job, as it would in-process.
+class WorkerCoordinator{
+private:
+    struct Worker{
+        pid_t pid = -1;
+        // coordinator end of the worker's connection
+        int socket = -1;
+    };
+
+    // command line of the job - sent to every worker, which builds its own JobConfig from it
+    std::vector<std::string> jobArguments;
+    // RLIMIT_AS of every worker - 0 leaves it unlimited
+    unsigned long long memoryLimitBytes;
+    std::string socketDirectory;
+    std::string socketPath;
+    int listenSocket = -1;
+    std::vector<Worker> workers;
+    // workers waiting for a task, and the number still running at all
+    std::vector<std::size_t> idleWorkers;
+    std::size_t liveWorkers = 0;
+    std::mutex mutex;
+    std::condition_variable idleCondition;
+    // one worker is started at a time - a connection on the socket belongs to the worker being started
+    std::mutex spawnMutex;
+    std::atomic<std::uint64_t> nextTaskId{1};
+    std::atomic<std::size_t> tasksRun{0};
+    std::atomic<std::size_t> taskRetries{0};
+    std::atomic<std::size_t> workerRestarts{0};
+
+    // Helper - how a worker process ended
+    static std::string describeExit(int status){
+        if(WIFSIGNALED(status)){
+            return "was killed by signal " + std::to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")";
+        }
+        if(WIFEXITED(status)){
+            return "exited with status " + std::to_string(WEXITSTATUS(status));
+        }
+        return "stopped";
+    }
+
+    // Waits for a new worker to connect and load the plugins - kills it if it does not
+    int acceptWorker(pid_t pid){
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(WORKER_START_TIMEOUT_MILLIS);
+        pollfd listening{this->listenSocket, POLLIN, 0};
+        int status = 0;
+        while(poll(&listening, 1, 100) <= 0){
+            if(waitpid(pid, &status, WNOHANG) == pid){
+                throw std::runtime_error("Worker process " + std::to_string(pid) + " " + describeExit(status) + " before it connected");
+            }
+            if(std::chrono::steady_clock::now() > deadline){
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                throw std::runtime_error("Worker process " + std::to_string(pid) + " did not connect");
+            }
+        }
+        int connection = accept4(this->listenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+        if(connection < 0){
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            throw std::runtime_error("Cannot accept a worker connection!: " + std::string(strerror(errno)));
+        }
+        std::string setup;
+        appendVarint(setup, this->jobArguments.size());
+        for(const std::string &argument: this->jobArguments){
+            appendMessageString(setup, argument);
+        }
+        WorkerMessage hello;
+        WorkerMessage ready;
+        std::size_t position = 0;
+        if(!receiveWorkerMessage(connection, hello) || hello.type != WorkerMessageType::Hello ||
+           readVarint(hello.payload, position) != static_cast<std::uint64_t>(pid) ||
+           !sendWorkerMessage(connection, WorkerMessageType::Setup, setup) ||
+           !receiveWorkerMessage(connection, ready) || ready.type != WorkerMessageType::Ready){
+            close(connection);
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            throw std::runtime_error("Worker process " + std::to_string(pid) + " failed to start");
+        }
+        position = 0;
+        std::string error = readMessageString(ready.payload, position);
+        if(!error.empty()){
+            close(connection);
+            waitpid(pid, &status, 0);
+            throw std::runtime_error(error);
+        }
+        return connection;
+    }
+
+    // Starts the worker of a slot
+    void spawnWorker(std::size_t slot){
+        std::lock_guard<std::mutex> spawnLock(this->spawnMutex);
+        // everything the child needs is prepared before the fork - it only calls setrlimit and execv
+        std::string socketOption = "--worker=" + this->socketPath;
+        char programName[] = "MRExec";
+        char* arguments[] = {programName, socketOption.data(), nullptr};
+        rlimit limit{this->memoryLimitBytes, this->memoryLimitBytes};
+        pid_t pid = fork();
+        if(pid < 0){
+            throw std::runtime_error("Cannot start a worker process!: " + std::string(strerror(errno)));
+        }
+        if(pid == 0){
+            if(this->memoryLimitBytes > 0){
+                setrlimit(RLIMIT_AS, &limit);
+            }
+            execv("/proc/self/exe", arguments);
+            _exit(127);
+        }
+        int connection = this->acceptWorker(pid);
+        this->workers[slot] = Worker{pid, connection};
+    }
+
+    // Reaps the worker of a slot once its connection dropped - returns how it ended
+    std::string reapWorker(std::size_t slot){
+        Worker &worker = this->workers[slot];
+        close(worker.socket);
+        int status = 0;
+        std::string cause = waitpid(worker.pid, &status, 0) == worker.pid ? describeExit(status) : "was lost";
+        worker = Worker{};
+        return cause;
+    }
+
+    // Takes an idle worker - blocks until there is one
+    std::size_t acquireWorker(){
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->idleCondition.wait(lock, [this]{ return !this->idleWorkers.empty() || this->liveWorkers == 0; });
+        if(this->idleWorkers.empty()){
+            throw std::runtime_error("No worker process is left!");
+        }
+        std::size_t slot = this->idleWorkers.back();
+        this->idleWorkers.pop_back();
+        return slot;
+    }
+
+    void releaseWorker(std::size_t slot){
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->idleWorkers.push_back(slot);
+        }
+        this->idleCondition.notify_one();
+    }
+
+    // A slot whose worker could not be replaced
+    void retireWorker(){
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->liveWorkers--;
+        }
+        this->idleCondition.notify_all();
+    }
+
+public:
+    // Constructor - starts worker_count workers, each with the job's command line; throws if one of them cannot start
+    WorkerCoordinator(unsigned worker_count, std::vector<std::string> job_arguments, unsigned long long memory_limit_bytes)
+            : jobArguments(std::move(job_arguments)), memoryLimitBytes(memory_limit_bytes), workers(worker_count){
+        std::string directory = (std::filesystem::temp_directory_path() / "mrexec-XXXXXX").string();
+        if(!mkdtemp(directory.data())){
+            throw std::runtime_error("Cannot create the worker socket directory!: " + std::string(strerror(errno)));
+        }
+        this->socketDirectory = directory;
+        this->socketPath = directory + "/coordinator.sock";
+        sockaddr_un address = workerSocketAddress(this->socketPath);
+        this->listenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(this->listenSocket < 0 || bind(this->listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+           listen(this->listenSocket, static_cast<int>(worker_count)) != 0){
+            std::string error = strerror(errno);
+            this->shutdown();
+            throw std::runtime_error("Cannot listen on the worker socket!: " + error);
+        }
+        try{
+            for(std::size_t slot = 0; slot < this->workers.size(); slot++){
+                this->spawnWorker(slot);
+                this->idleWorkers.push_back(slot);
+                this->liveWorkers++;
+            }
+        } catch(...){
+            this->shutdown();
+            throw;
+        }
+    }
+
+    // Not copyable - owns the worker processes
+    WorkerCoordinator(const WorkerCoordinator &) = delete;
+    WorkerCoordinator& operator=(const WorkerCoordinator &) = delete;
+
+    // Destructor - every task must be done
+    ~WorkerCoordinator(){
+        this->shutdown();
+    }
+
+    // Runs a task in a worker process and returns its result - throws if the task fails, or if the workers running
+    // it died WORKER_TASK_ATTEMPTS times
+    WorkerResult run(WorkerTask task){
+        task.id = this->nextTaskId.fetch_add(1);
+        std::string request = encodeWorkerTask(task);
+        for(unsigned attempt = 1; ; attempt++){
+            std::size_t slot = this->acquireWorker();
+            Worker worker = this->workers[slot];
+            WorkerMessage reply;
+            if(sendWorkerMessage(worker.socket, WorkerMessageType::Task, request) &&
+               receiveWorkerMessage(worker.socket, reply) && reply.type == WorkerMessageType::Result){
+                this->releaseWorker(slot);
+                this->tasksRun++;
+                WorkerResult result = decodeWorkerResult(reply.payload);
+                if(!result.succeeded){
+                    throw std::runtime_error("The " + std::string(phaseName(task.phase)) + " task of " + task.argument +
+                                             " failed in worker process " + std::to_string(worker.pid) + ": " + result.output);
+                }
+                return result;
+            }
+            // the connection dropped while the task ran - the worker crashed, hit its memory limit or was killed
+            std::string cause = this->reapWorker(slot);
+            std::cout << "Worker process " << worker.pid << " " << cause << " during the " << phaseName(task.phase)
+                      << " task of " << task.argument << std::endl;
+            try{
+                this->spawnWorker(slot);
+                this->workerRestarts++;
+                this->releaseWorker(slot);
+            } catch(std::runtime_error &){
+                this->retireWorker();
+                throw;
+            }
+            if(attempt >= WORKER_TASK_ATTEMPTS){
+                throw std::runtime_error("The " + std::string(phaseName(task.phase)) + " task of " + task.argument +
+                                         " failed in " + std::to_string(attempt) + " worker processes - the last one " + cause);
+            }
+            this->taskRetries++;
+        }
+    }
+
+    // Stops every worker and removes the socket - idempotent
+    void shutdown(){
+        for(Worker &worker: this->workers){
+            if(worker.pid <= 0){
+                continue;
+            }
+            sendWorkerMessage(worker.socket, WorkerMessageType::Shutdown, "");
+            close(worker.socket);
+            waitpid(worker.pid, nullptr, 0);
+            worker = Worker{};
+        }
+        if(this->listenSocket >= 0){
+            close(this->listenSocket);
+            this->listenSocket = -1;
+        }
+        if(!this->socketDirectory.empty()){
+            std::error_code error;
+            std::filesystem::remove_all(this->socketDirectory, error);
+            this->socketDirectory.clear();
+        }
+    }
+
+    // Getter
+    std::size_t getWorkerCount() const{
+        return this->workers.size();
+    }
+
+    // Prints the task and restart counters
+    void printStats(std::ostream &out) const{
+        out << "Worker processes - " << this->workers.size() << " workers, " << this->tasksRun.load() << " tasks, "
+            << this->taskRetries.load() << " retried, " << this->workerRestarts.load() << " workers restarted" << std::endl;
+    }
+};
+
+#endif //MAPREDUCELIB_WORKERCOORDINATOR_HPP
@@ -0,0 +1,216 @@
+/*
+ * Description: Messages exchanged between the MRExec coordinator and its worker processes over a stream socket
+ */
+#ifndef MAPREDUCELIB_WORKERPROTOCOL_HPP
+#define MAPREDUCELIB_WORKERPROTOCOL_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "JobPhase.hpp"
+#include "SpillFormat.hpp"
+#include "TaskMetrics.hpp"
+
+// Message layout - every integer of the header is little-endian:
+//  * type      4 bytes  WorkerMessageType
+//  * length    4 bytes  size of the payload in bytes
+//  * payload   varints and strings (a varint length followed by the bytes), in the order given below
+// Messages only carry paths and counters - the intermediate data stays in temp_mapper and temp_shuffler, which every
+// process of the job reads and writes directly. Nothing in a message is specific to a Unix socket.
+enum class WorkerMessageType : std::uint32_t{
+    // worker -> coordinator, once connected: varint process id
+    Hello = 1,
+    // coordinator -> worker: varint argument count, then every command line argument of the job (input directory first)
+    Setup,
+    // worker -> coordinator: string - empty once the plugin libraries are loaded, else the error that stopped the worker
+    Ready,
+    // coordinator -> worker: one task - see encodeWorkerTask
+    Task,
+    // worker -> coordinator: outcome of the task it was sent - see encodeWorkerResult
+    Result,
+    // coordinator -> worker: no more tasks - empty payload
+    Shutdown
+};
+
+// Upper bound on a payload - messages hold paths, counters and error texts only
+constexpr std::uint32_t WORKER_MESSAGE_MAX_BYTES = 1 << 20;
+
+struct WorkerMessage{
+    WorkerMessageType type = WorkerMessageType::Shutdown;
+    std::string payload;
+};
+
+// A task run by a worker process - the argument is an input file (map), a temp_mapper folder (shuffle) or a
+// temp_shuffler folder (reduce)
+struct WorkerTask{
+    std::uint64_t id = 0;
+    JobPhase phase = JobPhase::Map;
+    std::string argument;
+    // input bytes per map task - 0 keeps the record partitions
+    std::uint64_t taskBytes = 0;
+};
+
+// Outcome of a task - the directory the worker wrote to, or the error raised by the task
+struct WorkerResult{
+    std::uint64_t id = 0;
+    bool succeeded = false;
+    std::string output;
+    // records, bytes, CPU time and RSS measured in the worker process
+    TaskMetrics metrics;
+};
+
+// Helper - appends a string field
+inline void appendMessageString(std::string &buffer, std::string_view value){
+    appendVarint(buffer, value.size());
+    buffer.append(value.data(), value.size());
+}
+
+// Helper - decodes a string field at position, which is advanced past it
+inline std::string readMessageString(std::string_view buffer, std::size_t &position){
+    std::uint64_t size = readVarint(buffer, position);
+    if(size > buffer.size() - position){
+        throw std::runtime_error("Truncated string in worker message!");
+    }
+    std::string value(buffer.substr(position, size));
+    position += size;
+    return value;
+}
+
+// Task payload: varint id, varint phase, string argument, varint task bytes
+inline std::string encodeWorkerTask(const WorkerTask &task){
+    std::string payload;
+    appendVarint(payload, task.id);
+    appendVarint(payload, phaseIndex(task.phase));
+    appendMessageString(payload, task.argument);
+    appendVarint(payload, task.taskBytes);
+    return payload;
+}
+
+inline WorkerTask decodeWorkerTask(std::string_view payload){
+    WorkerTask task;
+    std::size_t position = 0;
+    task.id = readVarint(payload, position);
+    std::uint64_t phase = readVarint(payload, position);
+    if(phase >= JOB_PHASE_COUNT){
+        throw std::runtime_error("Invalid phase in worker message!");
+    }
+    task.phase = static_cast<JobPhase>(phase);
+    task.argument = readMessageString(payload, position);
+    task.taskBytes = readVarint(payload, position);
+    return task;
+}
+
+// Result payload: varint id, varint succeeded, string output, varints records in/out, bytes in/out, CPU microseconds
+// and RSS kilobytes
+inline std::string encodeWorkerResult(const WorkerResult &result){
+    std::string payload;
+    appendVarint(payload, result.id);
+    appendVarint(payload, result.succeeded ? 1 : 0);
+    appendMessageString(payload, result.output);
+    appendVarint(payload, result.metrics.recordsIn);
+    appendVarint(payload, result.metrics.recordsOut);
+    appendVarint(payload, result.metrics.bytesIn);
+    appendVarint(payload, result.metrics.bytesOut);
+    appendVarint(payload, static_cast<std::uint64_t>(result.metrics.cpuSeconds * 1e6));
+    appendVarint(payload, static_cast<std::uint64_t>(result.metrics.rssKilobytesAtEnd));
+    return payload;
+}
+
+inline WorkerResult decodeWorkerResult(std::string_view payload){
+    WorkerResult result;
+    std::size_t position = 0;
+    result.id = readVarint(payload, position);
+    result.succeeded = readVarint(payload, position) != 0;
+    result.output = readMessageString(payload, position);
+    result.metrics.recordsIn = readVarint(payload, position);
+    result.metrics.recordsOut = readVarint(payload, position);
+    result.metrics.bytesIn = readVarint(payload, position);
+    result.metrics.bytesOut = readVarint(payload, position);
+    result.metrics.cpuSeconds = static_cast<double>(readVarint(payload, position)) / 1e6;
+    result.metrics.rssKilobytesAtEnd = static_cast<long>(readVarint(payload, position));
+    return result;
+}
+
+// Helper - address of a Unix domain socket
+inline sockaddr_un workerSocketAddress(const std::string &path){
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path)){
+        throw std::runtime_error("Worker socket path is too long!: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// Helper - writes a whole buffer to a socket; false once the peer is gone (never raises SIGPIPE)
+inline bool writeSocket(int socket, const char* data, std::size_t size){
+    while(size > 0){
+        ssize_t written = send(socket, data, size, MSG_NOSIGNAL);
+        if(written < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+// Helper - reads exactly size bytes from a socket; false once the peer is gone
+inline bool readSocket(int socket, char* data, std::size_t size){
+    while(size > 0){
+        ssize_t received = recv(socket, data, size, 0);
+        if(received < 0 && errno == EINTR){
+            continue;
+        }
+        if(received <= 0){
+            return false;
+        }
+        data += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+// Sends one message - false once the peer is gone
+inline bool sendWorkerMessage(int socket, WorkerMessageType type, std::string_view payload){
+    char header[8];
+    auto typeValue = static_cast<std::uint32_t>(type);
+    auto length = static_cast<std::uint32_t>(payload.size());
+    for(int i = 0; i < 4; i++){
+        header[i] = static_cast<char>((typeValue >> (8 * i)) & 0xFF);
+        header[4 + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+    return writeSocket(socket, header, sizeof(header)) && writeSocket(socket, payload.data(), payload.size());
+}
+
+// Receives one message - false once the peer is gone, or if it sent a malformed frame
+inline bool receiveWorkerMessage(int socket, WorkerMessage &message){
+    unsigned char header[8];
+    if(!readSocket(socket, reinterpret_cast<char*>(header), sizeof(header))){
+        return false;
+    }
+    std::uint32_t typeValue = 0;
+    std::uint32_t length = 0;
+    for(int i = 0; i < 4; i++){
+        typeValue |= static_cast<std::uint32_t>(header[i]) << (8 * i);
+        length |= static_cast<std::uint32_t>(header[4 + i]) << (8 * i);
+    }
+    if(typeValue < static_cast<std::uint32_t>(WorkerMessageType::Hello) ||
+       typeValue > static_cast<std::uint32_t>(WorkerMessageType::Shutdown) || length > WORKER_MESSAGE_MAX_BYTES){
+        return false;
+    }
+    message.type = static_cast<WorkerMessageType>(typeValue);
+    message.payload.assign(length, '\0');
+    return readSocket(socket, message.payload.data(), length);
+}
+
+#endif //MAPREDUCELIB_WORKERPROTOCOL_HPP
@@ -1,48 +1,78 @@
 #include <iostream>
 #include <thread>
 #include <future>
-#include <mutex>
 #include <filesystem>
 #include <dlfcn.h>
 #include <algorithm>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <memory>
 #include "headers/FileProcessorBase.hpp"
 #include "headers/MapperBase.hpp"
 #include "headers/ShufflerBase.hpp"
 #include "headers/ReducerBase.hpp"
-
-// Mutex for mapper operations
-std::mutex mapper_mutex;
-std::mutex mapper_ind_mutex;
-std::mutex mapper_op_mutex;
-std::mutex mapper_ld_mutex;
-std::mutex mapper_fp_mutex;
-
-// Mutex for shuffler operations
-std::mutex shuffler_mutex;
-std::mutex shuffler_ind_mutex;
-std::mutex shuffler_op_mutex;
-std::mutex shuffler_ld_mutex;
-std::mutex shuffler_fp_mutex;
-
-// Mutex for reducer operations
-std::mutex reducer_mutex;
-std::mutex reducer_ind_mutex;
-std::mutex reducer_op_mutex;
-std::mutex reducer_ld_mutex;
-std::mutex reducer_fp_mutex;
+#include "headers/InMemoryShuffler.hpp"
+#include "headers/NativeMapper.hpp"
+#include "headers/FileProcessorCompactMapOutput.hpp"
+#include "headers/MapResult.hpp"
+#include "headers/NativeShuffler.hpp"
+#include "headers/NativeReducer.hpp"
+#include "headers/FileProcessorSortedRuns.hpp"
+#include "headers/ExternalShuffler.hpp"
+#include "headers/ExternalReducer.hpp"
+#include "headers/FileProcessorAggregatedOutput.hpp"
+#include "headers/AggregationResult.hpp"
+#include "headers/TokenDictionary.hpp"
+#include "headers/TokenCountCombiner.hpp"
+#include "headers/MappedInputFile.hpp"
+#include "headers/TaskSizing.hpp"
+#include "headers/SpeculativePhase.hpp"
+#include "headers/JobManifest.hpp"
+#include "headers/OutputIndex.hpp"
+#include "headers/PluginRegistry.hpp"
+#include "headers/JobConfig.hpp"
+#include "headers/WorkStealingPool.hpp"
+#include "headers/JobMetrics.hpp"
+#include "headers/WorkerCoordinator.hpp"
 
 // Function that will evaluate sub-folder counts within a root folder - used to evaluate if sub-processes are complete!
-int evalFolders(std::string root_directory);
+// On an incremental run only the sub-folders of the files being run are counted
+int evalFolders(std::string root_directory, const IncrementalPlan &plan = IncrementalPlan());
 
 // Function that will take FileProcessorBase (overloaded against FileProcessorInput via polymorphism)
 // Creates a memory object against a single file -> map(fileName, vector of vectors) - each inner vector contains
-// data belonging to a "partition" - ~ 2k records
-auto fileProcessInputs(FileProcessorBase* obj);
+// data belonging to a "partition" - ~ 2k records, or re-cut to ~ task_bytes bytes when task_bytes > 0
+auto fileProcessInputs(FileProcessorBase* obj, std::size_t task_bytes);
+
+// Function that maps a single input file into memory - used instead of fileProcessInputs with --mmap-input
+// Produces the partitions of the file as byte ranges of the mapping - no record is copied
+// With release_scanned the pages of every partition are dropped as soon as it is scanned
+// Partitions hold 2000 records, or ~ task_bytes bytes when task_bytes > 0
+std::vector<InputSlice> fileMapInputs(const std::string &file, bool release_scanned, std::size_t task_bytes);
 
 // Function that will take MapperBase (overloaded against MapperImpl via polymorphism)
 // Creates a mapper object against a PARTITION of a file memory object
 // Produces a mapper dataset in memory that contains a map of tuples
-auto mapperOps(MapperBase* obj);
+// An optional combiner pre-aggregates the dataset before it is handed over
+auto mapperOps(MapperBase* obj, CombinerBase* combiner = nullptr);
+
+// Function that runs a mapper task and wraps its result
+// NativeMapper hands over its compact output, library mappers their nested mapperOutput_t
+// With a token dictionary (--token-ids) the compact output is interned before it is handed over
+MapResult mapTask(MapperBase* obj, CombinerBase* combiner, TokenDictionary* dictionary);
+
+// Function that runs several mapper tasks as one - used to coalesce the partitions of small files
+std::vector<MapResult> mapBatchTask(const std::vector<std::function<MapperBase*()>> &batch, CombinerBase* combiner,
+                                    TokenDictionary* dictionary);
+
+// Function that returns the combiner of the job - nullptr unless --combine is supplied
+// The mapper library's optional createCombinerObj factory wins over the built-in TokenCountCombiner
+CombinerBase* createCombiner(const JobConfig &config, void* mapLibHandle);
+
+// Function that returns the partitioner of the job - nullptr unless --reducers is supplied
+// --partitioner=library requires the mapper library to export partitionKey
+partitionKey_t* resolvePartitioner(const JobConfig &config, void* mapLibHandle);
 
 // Function that will take FileProcessorBase (overloaded against FileProcessorMapOutput via polymorphism)
 // Takes mapper memory data structure and persists to disk
@@ -53,6 +83,10 @@ auto fileProcessMapOutputs(FileProcessorBase* obj);
 // Produces a shuffler dataset in memory that contains a map of tuples, the value being an aggregated of all keys
 auto shufflerOps(ShufflerBase* obj);
 
+// Function that runs a shuffler task and wraps its result
+// NativeShuffler hands over its hash tables, library shufflers their nested maps
+ShuffleResult shuffleTask(ShufflerBase* obj);
+
 // Function that will take FileProcessorBase (overloaded against FileProcessorShufOutput via polymorphism)
 // Takes shuffler memory data structure and persists to disk
 auto fileProcessShufOutputs(FileProcessorBase* obj);
@@ -62,19 +96,63 @@ auto fileProcessShufOutputs(FileProcessorBase* obj);
 // Produces a reducer dataset in memory that contains a map of tuples, the value being an aggregated of all keys, across all shuffler files
 auto reducerOps(ReducerBase* obj);
 
+// Function that runs a reducer task and wraps its result
+// NativeReducer hands over its hash table, library reducers their nested maps
+ReduceResult reduceTask(ReducerBase* obj);
+
 // Function that will take FileProcessorBase (overloaded against FileProcessorRedOutput via polymorphism)
 // Takes reducer memory data structure and persists to disk - this is the final output
 auto fileProcessRedOutputs(FileProcessorBase* obj);
 
 // Overarching function that will orchestrate the main flow
-void runOrchestration(const std::string &input_directory);
+void runOrchestration(const JobConfig &config);
 
 // Overarching function that will perform Map Reduce operations
-void mapReduceWorkflow(const std::string &input_directory);
+// All tasks are submitted to a single work-stealing executor sized by config.workerCount
+void mapReduceWorkflow(const JobConfig &config);
+
+// Pipelined variant of the workflow - every file flows through its phases independently of the other files
+// Returns the final output directory
+std::string pipelinedWorkflow(const JobConfig &config, WorkStealingPool &pool, JobMetrics &metrics,
+                              const IncrementalPlan &plan, AsyncFileWriter* async_writer, TokenDictionary* dictionary);
+
+// Multi-process variant of the workflow - the map, shuffle and reduce tasks of every file run in the worker processes
+// of the coordinator (--processes). Returns the final output directory
+std::string processWorkflow(const JobConfig &config, WorkerCoordinator &coordinator, WorkStealingPool &pool,
+                            JobMetrics &metrics, const IncrementalPlan &plan);
+
+// Entry point of a worker process (MRExec --worker=<socket>) - runs the tasks of its coordinator until it is shut down
+int runWorkerProcess(const std::string &socket_path);
+
+// Plans an incremental run - compares the input directory with the manifest of final_output, and removes the outputs
+// of modified and deleted files along with SUCCESS.ind and the manifest itself (both are written again on success)
+IncrementalPlan planIncrementalRun(const JobConfig &config);
+
+// Emits the structured job metrics - the phase summary on stdout, the summary with every task to --metrics-json
+// and the timeline of the tasks to --trace
+void emitJobMetrics(const JobConfig &config, WorkStealingPool &pool, JobMetrics &metrics);
+
+// Prints the size of the job's token dictionary - nothing without --token-ids
+void printTokenDictionary(TokenDictionary* dictionary);
+
+// Function that indexes the final_output files of a job - final_output/index/<file>.idx, one task per file
+// An incremental run only indexes the files it ran, and the reused ones that have no index yet
+void indexFinalOutput(const std::string &reducerDir, const IncrementalPlan &plan, WorkStealingPool &pool, JobMetrics &metrics);
 
 // file Directory checks
 std::vector<std::string> fileDirectoryChecks(const std::string &directory1, const std::string &directory2);
 
+// Compares the input directory with the final output directory and creates SUCCESS.ind if they match
+void createSuccessIndicator(const std::string &input_directory, const std::string &reducerDir);
+
+// Checks that the final output directory holds one part file per reducer and creates SUCCESS.ind if it does
+void createPartitionSuccessIndicator(const std::string &reducerDir, unsigned reducer_count);
+
+// sub-folder file checks - files under the sub-folders of root1 that have no counterpart under the sub-folders of root2
+// On an incremental run only the sub-folders of root1 that belong to the files being run are checked
+std::vector<std::string> subFolderFileChecks(const std::string &root1, const std::string &root2,
+                                             const IncrementalPlan &plan = IncrementalPlan());
+
 // library handle function
 // This function will take a library file and return its corresponding handle as a null pointer
 // https://linux.die.net/man/3/dlopen
@@ -125,19 +203,43 @@ T* createLibFunc(void* libHandle,const char* libraryFile,const char* factoryFunc
     return libFunc;
 }
 
+// optional library operations - same as createLibFunc, but a missing symbol is not an error
+// Used for optional factories (e.g. createInMemoryObj) - returns nullptr when the library does not export them
+template<typename T>
+T* findLibFunc(void* libHandle,const char* factoryFunctionHandle){
+    static_assert(
+            std::is_same<T, createInMemoryShuffler_t>::value ||
+            std::is_same<T, createCombiner_t>::value ||
+            std::is_same<T, partitionKey_t>::value,
+            "Unsupported Implementation!"
+    );
+    // raise error if library wasn't loaded
+    if(!libHandle){
+        throw std::runtime_error("Cannot load library: " + std::string(dlerror()) + "\n");
+    }
+    // reset errors
+    dlerror();
+    T* libFunc = (T*)dlsym(libHandle, factoryFunctionHandle);
+    // clear the error raised for a missing symbol
+    dlerror();
+    return libFunc;
+}
+
 int main(int argc, char* argv[]) {
+    // a worker process of a coordinator - started by WorkerCoordinator, not by hand
+    if(argc == 2 && std::string(argv[1]).rfind("--worker=", 0) == 0){
+        return runWorkerProcess(std::string(argv[1]).substr(9));
+    }
     // Check arguments supplied
     if(argc==1){
         // No arguments were provided!
         std::cout << "No arguments were provided! Please resubmit with input paths!" << std::endl;
     } else{
-        // Declare the input file directory being processed
-        char* inputDirBase = argv[1];
-        // Convert it to string
-        std::string inputDir(inputDirBase);
         // Orchestrate the entire operation
         try{
-            runOrchestration(inputDir);
+            // Build the job configuration - input directory followed by optional --key=value settings
+            JobConfig config = parseJobConfig(argc, argv);
+            runOrchestration(config);
         }
         catch(std::runtime_error &runtime_error){
             std::cout << "Exception occurred: " << runtime_error.what() << std::endl;
@@ -148,94 +250,406 @@ int main(int argc, char* argv[]) {
 }
 
 // Function that will evaluate sub-folder counts within a root folder - used to evaluate if sub-processes are complete!
-int evalFolders(std::string root_directory){
+int evalFolders(std::string root_directory, const IncrementalPlan &plan){
     // declare a vector that will hold the all mapper folders!
     std::vector<std::string> sub_folders;
     // iterate and load directory_files vector!
     for(const auto &entry:std::filesystem::directory_iterator(root_directory)){
-        sub_folders.push_back(entry.path());
+        if(plan.includes(entry.path())){
+            sub_folders.push_back(entry.path());
+        }
     }
     return sub_folders.size();
 }
 
+// Task metrics helpers - records and bytes of the nested containers handed over by library objects
+// (built-in objects report their own counts)
+void countNestedInput(const std::map<std::string, std::vector<std::vector<std::string>>> &partitions, bool output){
+    std::uint64_t records = 0;
+    std::uint64_t bytes = 0;
+    for(const auto &file: partitions){
+        for(const auto &partition: file.second){
+            records += partition.size();
+            for(const std::string &record: partition){
+                bytes += record.size();
+            }
+        }
+    }
+    output ? countTaskOutput(records, bytes) : countTaskInput(records, bytes);
+}
+void countNestedTokens(const mapperOutput_t &mapper_output, bool output){
+    std::uint64_t tokens = 0;
+    std::uint64_t bytes = 0;
+    for(const auto &file: mapper_output){
+        for(const auto &record: file.second){
+            tokens += record.size();
+            for(const auto &token: record){
+                bytes += std::get<0>(token).size();
+            }
+        }
+    }
+    output ? countTaskOutput(tokens, bytes) : countTaskInput(tokens, bytes);
+}
+void countNestedCounts(const std::map<std::string, std::map<std::string, size_t>> &files, bool output){
+    std::uint64_t entries = 0;
+    std::uint64_t bytes = 0;
+    for(const auto &file: files){
+        entries += file.second.size();
+        for(const auto &entry: file.second){
+            bytes += entry.first.size();
+        }
+    }
+    output ? countTaskOutput(entries, bytes) : countTaskInput(entries, bytes);
+}
+// bytes of the files a library shuffler/reducer reads on its own - their records are not visible to the driver
+void countDirectoryInput(const std::string &directory){
+    std::error_code error;
+    for(const auto &entry: std::filesystem::directory_iterator(directory, error)){
+        if(entry.is_regular_file(error)){
+            countTaskInput(0, entry.file_size(error));
+        }
+    }
+}
+void countAggregatedOutput(const aggregatedOutput_t &aggregated_output){
+    for(const AggregatedFile &file: aggregated_output){
+        countTaskOutput(file.size(), file.getTokenBytes());
+    }
+}
+
 // Function that will take FileProcessorBase (overloaded against FileProcessorInput via polymorphism)
 // Creates a memory object against a single file -> map(fileName, vector of vectors) - each inner vector contains
-// data belonging to a "partition" - ~ 2k records
-auto fileProcessInputs(FileProcessorBase* obj){
+// data belonging to a "partition" - ~ 2k records, or re-cut to ~ task_bytes bytes when task_bytes > 0
+auto fileProcessInputs(FileProcessorBase* obj, std::size_t task_bytes){
     obj->runOperation();
-    return obj->getInputDirectoryData();
+    // moved out of the object - the future is the only owner of the partitions
+    auto partitions = obj->takeInputDirectoryData();
+    PluginRegistry::instance().fileProcessors.release(obj);
+    for(auto &row: partitions){
+        if(task_bytes > 0){
+            row.second = resizePartitions(std::move(row.second), task_bytes);
+        }
+        // a byte cut lands right before a blank line sooner or later - the library writers need a token up front
+        anchorPartitions(row.second);
+    }
+    if(!partitions.empty()){
+        tagTask(partitions.begin()->first);
+    }
+    countNestedInput(partitions, false);
+    countNestedInput(partitions, true);
+    return partitions;
+}
+
+// Function that maps a single input file into memory - used instead of fileProcessInputs with --mmap-input
+// Produces the partitions of the file as byte ranges of the mapping - no record is copied
+std::vector<InputSlice> fileMapInputs(const std::string &file, bool release_scanned, std::size_t task_bytes){
+    tagTask(file);
+    auto mapping = std::make_shared<const MappedInputFile>(file);
+    std::vector<InputSlice> slices = task_bytes > 0
+            ? partitionMappedFileBySize(mapping, task_bytes, release_scanned)
+            : partitionMappedFile(mapping, 2000, release_scanned);
+    for(const InputSlice &slice: slices){
+        countTaskInput(slice.records, slice.end - slice.begin);
+        countTaskOutput(slice.records, slice.end - slice.begin);
+    }
+    return slices;
 }
 
 // Function that will take MapperBase (overloaded against MapperImpl via polymorphism)
 // Creates a mapper object against a PARTITION of a file memory object
 // Produces a mapper dataset in memory that contains a map of tuples
-auto mapperOps(MapperBase* obj){
-    mapper_ind_mutex.lock();
+// An optional combiner pre-aggregates the dataset before it is handed over
+auto mapperOps(MapperBase* obj, CombinerBase* combiner){
     obj->runMapOperation();
-    mapper_ind_mutex.unlock();
-    return obj->getMapperOutput();
+    if(combiner){
+        obj->combineMapperOutput(*combiner);
+    }
+    // the partition is no longer needed - release it rather than keep it alive with the object
+    for(const auto &file: obj->takeProcessedFilePartition()){
+        std::uint64_t bytes = 0;
+        for(const std::string &record: file.second){
+            bytes += record.size();
+        }
+        countTaskInput(file.second.size(), bytes);
+    }
+    return obj->takeMapperOutput();
+}
+
+// Function that runs a mapper task and wraps its result
+// NativeMapper hands over its compact output, library mappers their nested mapperOutput_t
+// With a token dictionary (--token-ids) the compact output is interned before it is handed over
+MapResult mapTask(MapperBase* obj, CombinerBase* combiner, TokenDictionary* dictionary){
+    MapResult result;
+    result.partitionNum = obj->getPartitionNum();
+    tagTask("", result.partitionNum);
+    if(auto* nativeMapper = dynamic_cast<NativeMapper*>(obj)){
+        nativeMapper->runMapOperation();
+        result.compact = true;
+        result.compactOutput = nativeMapper->takeCompactOutput();
+        if(combiner){
+            combiner->combineCompact(result.compactOutput);
+        }
+    } else {
+        result.nestedOutput = mapperOps(obj, combiner);
+        // FileProcessorMapOutput writes counts through a signed byte - combined counts go out via FileProcessorCompactMapOutput
+        if(combiner){
+            result.compactOutput = result.takeCompact();
+            result.compact = true;
+        }
+    }
+    tagTask(result.getFileName());
+    // after the combiner - only the distinct tokens of the partition are looked up
+    if(dictionary && result.compact){
+        result.compactOutput.internTokens(*dictionary);
+    }
+    if(result.compact){
+        countTaskOutput(result.compactOutput.getTokenCount(), result.compactOutput.getArenaBytes());
+    } else {
+        countNestedTokens(result.nestedOutput, true);
+    }
+    // the results are taken - the mapper goes back to the registry
+    PluginRegistry::instance().mappers.release(obj);
+    return result;
+}
+
+// Function that runs several mapper tasks as one - used to coalesce the partitions of small files
+// Every mapper is only built once its task starts, so a library mapper released by the previous task is reused
+std::vector<MapResult> mapBatchTask(const std::vector<std::function<MapperBase*()>> &batch, CombinerBase* combiner,
+                                    TokenDictionary* dictionary){
+    std::vector<MapResult> results;
+    results.reserve(batch.size());
+    for(const auto &mapper: batch){
+        results.push_back(mapTask(mapper(), combiner, dictionary));
+    }
+    return results;
+}
+
+// Function that hands out a library mapper for a partition - an idle instance of the registry's pool when there is one
+// The partition is moved in afterwards rather than copied by the library's constructor
+MapperBase* acquireMapper(createMapper_t* create, int partition_num, std::map<std::string, std::vector<std::string>> &&partition){
+    MapperBase* mapper = PluginRegistry::instance().mappers.acquire([create, partition_num]{
+        return create(partition_num, {});
+    });
+    mapper->setPartitionNum(partition_num);
+    mapper->setProcessedFilePartition(std::move(partition));
+    return mapper;
+}
+
+// Function that returns the combiner of the job - nullptr unless --combine is supplied
+// The mapper library's optional createCombinerObj factory wins over the built-in TokenCountCombiner
+CombinerBase* createCombiner(const JobConfig &config, void* mapLibHandle){
+    if(!config.combine){
+        return nullptr;
+    }
+    createCombiner_t* create_Combiner_Obj = findLibFunc<createCombiner_t>(mapLibHandle, "createCombinerObj");
+    if(create_Combiner_Obj){
+        return create_Combiner_Obj();
+    }
+    return new TokenCountCombiner();
+}
+
+// Function that returns the partitioner of the job - nullptr unless --reducers is supplied
+// --partitioner=library requires the mapper library to export partitionKey
+partitionKey_t* resolvePartitioner(const JobConfig &config, void* mapLibHandle){
+    if(config.reducerCount == 0){
+        return nullptr;
+    }
+    partitionKey_t* partitioner = parsePartitioner(config.partitioner);
+    if(!partitioner){
+        partitioner = findLibFunc<partitionKey_t>(mapLibHandle, "partitionKey");
+        if(!partitioner){
+            throw std::runtime_error("The mapper library does not export partitionKey!");
+        }
+    }
+    return partitioner;
+}
+
+// The prebuilt libs/fp writers carry their own (weak) copy of FileProcessorBase::createDirectory, from before it took a
+// lock - an unsynchronised check-then-create the process-wide definition does not replace. The driver creates the
+// folder of every library writer before the writer is submitted, so the writers only find it and run concurrently.
+void prepareOutputDirectory(const std::filesystem::path &directory){
+    // tolerates a folder created by another task in the meantime
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if(error && !std::filesystem::is_directory(directory)){
+        throw std::runtime_error("Cannot create directory!: " + directory.string() + " - " + error.message());
+    }
+}
+
+// Function that creates temp_mapper/<file> ahead of a library map-output writer
+void prepareMapOutputDirectory(const std::string &input_file){
+    // an empty mapper output names no file - the writer has nothing to write either
+    if(input_file.empty()){
+        return;
+    }
+    std::filesystem::path file(input_file);
+    prepareOutputDirectory(file.parent_path() / "temp_mapper" / file.filename());
+}
+
+// Function that creates the temp_shuffler/<file> folders ahead of a library shuffle-output writer - every key of the
+// shuffled output is the path of the file it is written to
+void prepareShuffleOutputDirectories(const std::vector<std::map<std::string, std::map<std::string,size_t>>> &shuffled_output){
+    for(const auto &shuffled: shuffled_output){
+        if(!shuffled.empty() && std::filesystem::path(shuffled.begin()->first).has_parent_path()){
+            prepareOutputDirectory(std::filesystem::path(shuffled.begin()->first).parent_path());
+        }
+    }
+}
+
+// Function that creates final_output ahead of a library reduce-output writer
+void prepareReduceOutputDirectory(const JobConfig &config){
+    prepareOutputDirectory(std::filesystem::path(config.inputDirectory) / "final_output");
 }
 
 // Function that will take FileProcessorBase (overloaded against FileProcessorMapOutput via polymorphism)
 // Takes mapper memory data structure and persists to disk
 auto fileProcessMapOutputs(FileProcessorBase* obj){
-    mapper_fp_mutex.lock();
     obj->runOperation();
-    mapper_fp_mutex.unlock();
-    return obj->getMapperOutputDirectory();
+    // written out - release the object's copy of the mapper output
+    auto written = obj->takeRawMapperOutput();
+    if(!written.empty()){
+        tagTask(written.begin()->first);
+    }
+    countNestedTokens(written, false);
+    std::string directory = obj->getMapperOutputDirectory();
+    PluginRegistry::instance().fileProcessors.release(obj);
+    return directory;
 }
 
 // Function that will take ShufflerBase (overloaded against ShufflerImpl via polymorphism)
 // Creates a shuffler object against a temp_mapper subdirectory
 // Produces a shuffler dataset in memory that contains a map of tuples, the value being an aggregated of all keys
 auto shufflerOps(ShufflerBase* obj){
-    shuffler_ind_mutex.lock();
     obj->runShuffleOperation();
-    shuffler_ind_mutex.unlock();
-    return obj->getShuffledOutput();
+    // in-memory library shufflers have no directory
+    if(!obj->getMapOutputDirectory().empty()){
+        countDirectoryInput(obj->getMapOutputDirectory());
+    }
+    return obj->takeShuffledOutput();
+}
+
+// Function that runs a shuffler task and wraps its result
+// NativeShuffler hands over its hash tables, library shufflers their nested maps, ExternalShuffler its output directory
+ShuffleResult shuffleTask(ShufflerBase* obj){
+    ShuffleResult result;
+    // temp_mapper/<file> - in-memory shufflers have no directory
+    tagTask(obj->getMapOutputDirectory());
+    if(auto* nativeShuffler = dynamic_cast<NativeShuffler*>(obj)){
+        nativeShuffler->runShuffleOperation();
+        result.hashed = true;
+        result.aggregatedOutput = nativeShuffler->takeAggregatedOutput();
+        countAggregatedOutput(result.aggregatedOutput);
+    } else if(auto* externalShuffler = dynamic_cast<ExternalShuffler*>(obj)){
+        externalShuffler->runShuffleOperation();
+        result.streamed = true;
+        result.outputDirectory = externalShuffler->getShuffleDirectory();
+    } else {
+        result.nestedOutput = shufflerOps(obj);
+        for(const auto &shuffled: result.nestedOutput){
+            countNestedCounts(shuffled, true);
+        }
+    }
+    // the results are taken - the shuffler goes back to the registry
+    PluginRegistry::instance().shufflers.release(obj);
+    return result;
+}
+
+// Function that hands out a library shuffler for a temp_mapper sub-folder - an idle instance of the registry's pool
+// when there is one
+ShufflerBase* acquireShuffler(createShuffler_t* create, const std::string &mapper_directory){
+    ShufflerBase* shuffler = PluginRegistry::instance().shufflers.acquire([create, &mapper_directory]{
+        return create(mapper_directory);
+    });
+    shuffler->setMapOutputDirectory(mapper_directory);
+    return shuffler;
 }
 
 // Function that will take FileProcessorBase (overloaded against FileProcessorShufOutput via polymorphism)
 // Takes shuffler memory data structure and persists to disk
 auto fileProcessShufOutputs(FileProcessorBase* obj){
-    shuffler_fp_mutex.lock();
     obj->runOperation();
-    shuffler_fp_mutex.unlock();
-    return obj->getShufflerOutputDirectory();
+    // written out - release the object's copy of the shuffler output
+    for(const auto &shuffled: obj->takeRawShufflerOutput()){
+        if(!shuffled.empty()){
+            tagTask(shuffled.begin()->first);
+        }
+        countNestedCounts(shuffled, false);
+    }
+    std::string directory = obj->getShufflerOutputDirectory();
+    PluginRegistry::instance().fileProcessors.release(obj);
+    return directory;
 }
 
 // Function that will take ReducerBase (overloaded against ReducerImpl via polymorphism)
 // Creates a reducer object against a temp_shuffler subdirectory
 // Produces a reducer dataset in memory that contains a map of tuples, the value being an aggregated of all keys, across all shuffler files
 auto reducerOps(ReducerBase* obj){
-    reducer_ind_mutex.lock();
     obj->runReduceOperations();
-    reducer_ind_mutex.unlock();
-    return obj->getReducedOutput();
+    countDirectoryInput(obj->getShuffleOutputDirectory());
+    return obj->takeReducedOutput();
+}
+
+// Function that runs a reducer task and wraps its result
+// NativeReducer hands over its hash table, library reducers their nested maps, ExternalReducer its output directory
+ReduceResult reduceTask(ReducerBase* obj){
+    ReduceResult result;
+    // temp_shuffler/<file>, or temp_shuffler/part-<r> when partitioned
+    tagTask(obj->getShuffleOutputDirectory());
+    if(auto* nativeReducer = dynamic_cast<NativeReducer*>(obj)){
+        nativeReducer->runReduceOperations();
+        result.hashed = true;
+        result.aggregatedOutput = nativeReducer->takeAggregatedOutput();
+        countAggregatedOutput(result.aggregatedOutput);
+    } else if(auto* externalReducer = dynamic_cast<ExternalReducer*>(obj)){
+        externalReducer->runReduceOperations();
+        result.streamed = true;
+        result.outputDirectory = externalReducer->getFinalDirectory();
+    } else {
+        result.nestedOutput = reducerOps(obj);
+        countNestedCounts(result.nestedOutput, true);
+    }
+    // the results are taken - the reducer goes back to the registry
+    PluginRegistry::instance().reducers.release(obj);
+    return result;
+}
+
+// Function that hands out a library reducer for a temp_shuffler sub-folder - an idle instance of the registry's pool
+// when there is one
+ReducerBase* acquireReducer(createReducer_t* create, const std::string &shuffle_directory){
+    ReducerBase* reducer = PluginRegistry::instance().reducers.acquire([create, &shuffle_directory]{
+        return create(shuffle_directory);
+    });
+    reducer->setShuffleOutputDirectory(shuffle_directory);
+    return reducer;
 }
 
 // Function that will take FileProcessorBase (overloaded against FileProcessorRedOutput via polymorphism)
 // Takes reducer memory data structure and persists to disk - this is the final output
 auto fileProcessRedOutputs(FileProcessorBase* obj){
-    reducer_fp_mutex.lock();
     obj->runOperation();
-    reducer_fp_mutex.unlock();
-    return obj->getFinalOutputDirectory();
+    // written out - release the object's copy of the reducer output
+    auto written = obj->takeRawReducerOutput();
+    if(!written.empty()){
+        tagTask(written.begin()->first);
+    }
+    countNestedCounts(written, false);
+    std::string directory = obj->getFinalOutputDirectory();
+    PluginRegistry::instance().fileProcessors.release(obj);
+    return directory;
 }
 
 // library handle function
 // This function will take a library file and return its corresponding handle as a null pointer
 // https://linux.die.net/man/3/dlopen
 void* createLibHandle(const char* libraryFile){
-    // load library file
-    void* libFileHandle = dlopen(libraryFile,RTLD_LAZY);
+    // load library file - once per job, the registry owns the handle and closes it when the job is done
+    void* libFileHandle = PluginRegistry::instance().open(libraryFile);
     // returning this so that it can be used createLibFunction template - used to create class instances
-    // and can be used to close independently
     return libFileHandle;
 }
 
 // Overarching function that will orchestrate the main flow
-void runOrchestration(const std::string &input_directory){
+void runOrchestration(const JobConfig &config){
+    const std::string &input_directory = config.inputDirectory;
     // Let's check if the input directory exists in the file system
     std::filesystem::path directoryPath(input_directory);
     if(std::filesystem::is_directory(directoryPath)){
@@ -248,7 +662,9 @@ void runOrchestration(const std::string &input_directory){
         if(!directoryInputFiles.empty()){
             // Call mapReduceOperations function here!
             std::cout << "Kicking off MapReduce operations..." << std::endl;
-            mapReduceWorkflow(input_directory);
+            mapReduceWorkflow(config);
+            // every task is done - the pooled objects go back to their libraries, which are then unloaded
+            PluginRegistry::instance().close();
         } else {
             std::cout << "No files found to process along " << input_directory << std::endl;
         }
@@ -295,9 +711,850 @@ std::vector<std::string> fileDirectoryChecks(const std::string &directory1, cons
     return filesDontExist;
 }
 
+// Compares the input directory with the final output directory and creates SUCCESS.ind if they match
+void createSuccessIndicator(const std::string &input_directory, const std::string &reducerDir){
+    // Vector of files...
+    std::vector<std::string> fileDontExist1to2 = fileDirectoryChecks(input_directory, reducerDir);
+    std::vector<std::string> fileDontExist2to1 = fileDirectoryChecks(reducerDir, input_directory);
+
+    // Create a SUCCESS indicator if filesDontExist vector is empty
+    if(fileDontExist1to2.empty() && fileDontExist2to1.empty()){
+        std::ofstream successFile;
+        successFile.open(reducerDir + "/" + "SUCCESS.ind");
+        successFile.close();
+    } else {
+        throw std::runtime_error("There are missing files!");
+    }
+}
+
+// Checks that the final output directory holds one part file per reducer and creates SUCCESS.ind if it does
+void createPartitionSuccessIndicator(const std::string &reducerDir, unsigned reducer_count){
+    for(unsigned reducer = 0; reducer < reducer_count; reducer++){
+        if(!std::filesystem::is_regular_file(reducerDir + "/" + reducerPartitionName(reducer))){
+            throw std::runtime_error("There are missing files!");
+        }
+    }
+    std::ofstream successFile;
+    successFile.open(reducerDir + "/" + "SUCCESS.ind");
+    successFile.close();
+}
+
+// sub-folder file checks - files under the sub-folders of root1 that have no counterpart under the sub-folders of root2
+std::vector<std::string> subFolderFileChecks(const std::string &root1, const std::string &root2,
+                                             const IncrementalPlan &plan){
+    // Map containing files in the sub-folders of root2
+    std::map<std::string, int> root2Files;
+    // Vector containing files that don't exist
+    std::vector<std::string> filesDontExist;
+    for(const auto &sub_directory:std::filesystem::directory_iterator(root2)){
+        if(std::filesystem::is_directory(sub_directory)){
+            for(const auto &file:std::filesystem::directory_iterator(sub_directory)){
+                root2Files.insert({file.path().filename().string(),1});
+            }
+        }
+    }
+    // now we will iterate over the sub-folders of root1
+    for(const auto &sub_directory:std::filesystem::directory_iterator(root1)){
+        if(std::filesystem::is_directory(sub_directory) && plan.includes(sub_directory.path())){
+            for(const auto &file:std::filesystem::directory_iterator(sub_directory)){
+                std::string fileName = file.path().filename().string();
+                if(root2Files.find(fileName) == root2Files.end()){
+                    filesDontExist.push_back(fileName);
+                }
+            }
+        }
+    }
+    return filesDontExist;
+}
+
+// Plans an incremental run - compares the input directory with the manifest of final_output, and removes the outputs
+// of modified and deleted files along with SUCCESS.ind and the manifest itself (both are written again on success)
+IncrementalPlan planIncrementalRun(const JobConfig &config){
+    std::filesystem::path inputDirectory(config.inputDirectory);
+    std::filesystem::path finalDirectory = inputDirectory / "final_output";
+    IncrementalPlan plan;
+    plan.active = true;
+    JobManifest previous = JobManifest::load(finalDirectory.string());
+    for(const auto &entry:std::filesystem::directory_iterator(inputDirectory)){
+        if(!std::filesystem::is_regular_file(entry)){
+            continue;
+        }
+        ManifestEntry file = JobManifest::describe(entry.path(), previous.find(entry.path().filename().string()));
+        plan.manifest.add(file);
+        // a file is only reused if the run that recorded it also left its final_output file behind
+        if(previous.isUnchanged(file) && std::filesystem::is_regular_file(finalDirectory / file.fileName)){
+            plan.reusedFiles.insert(file.fileName);
+            continue;
+        }
+        plan.runFiles.insert(file.fileName);
+        // the stale outputs of a modified file - a shorter file would otherwise leave partitions of its old version
+        std::filesystem::remove_all(inputDirectory / "temp_mapper" / file.fileName);
+        std::filesystem::remove_all(inputDirectory / "temp_shuffler" / file.fileName);
+        std::filesystem::remove(finalDirectory / file.fileName);
+        std::filesystem::remove(outputIndexPath(finalDirectory / file.fileName));
+    }
+    if(std::filesystem::is_directory(finalDirectory)){
+        // final_output mirrors the input directory - outputs of deleted files go, and so do SUCCESS.ind and the
+        // manifest until this run succeeds
+        std::vector<std::filesystem::path> staleOutputs;
+        for(const auto &entry:std::filesystem::directory_iterator(finalDirectory)){
+            std::string fileName = entry.path().filename().string();
+            if(std::filesystem::is_regular_file(entry) && !plan.manifest.find(fileName)){
+                staleOutputs.push_back(entry.path());
+            }
+        }
+        for(const auto &stale: staleOutputs){
+            std::filesystem::remove_all(inputDirectory / "temp_mapper" / stale.filename());
+            std::filesystem::remove_all(inputDirectory / "temp_shuffler" / stale.filename());
+            std::filesystem::remove(stale);
+            std::filesystem::remove(outputIndexPath(stale));
+        }
+    }
+    return plan;
+}
+
+// Factories used by the pipelined workflow and the worker processes - resolved once, shared by every task
+struct PipelineFactories{
+    create_t* createInput = nullptr;
+    createMapper_t* createMapper = nullptr;
+    readMapperOp_t* createMapOutput = nullptr;
+    createShuffler_t* createShuffler = nullptr;
+    createInMemoryShuffler_t* createInMemoryShuffler = nullptr;
+    // shared by every map task - nullptr unless --combine is supplied
+    CombinerBase* combiner = nullptr;
+    readShufflerOp_t* createShuffleOutput = nullptr;
+    createReducer_t* createReducer = nullptr;
+    readReducerOp_t* createReduceOutput = nullptr;
+    // removeInputObj of the libraries whose objects are not pooled - see PluginRegistry
+    destroy_t* removeInput = nullptr;
+    destroy_t* removeMapOutput = nullptr;
+    destroyShuffler_t* removeShuffler = nullptr;
+    destroy_t* removeShuffleOutput = nullptr;
+    destroy_t* removeReduceOutput = nullptr;
+};
+
+// Shared state of a pipelined job
+struct PipelineContext{
+    const JobConfig &config;
+    WorkStealingPool &pool;
+    JobMetrics &metrics;
+    PipelineFactories factories;
+    // bytes of mapper results currently held in memory across all files
+    std::atomic<std::size_t> inMemoryBytes{0};
+    // input bytes per map task - 0 keeps the record partitions
+    std::size_t taskBytes = 0;
+    // with --async-output - receives the final_output files; intermediate files are read back by the next stage of
+    // their file right away, so they are still written in the task
+    AsyncFileWriter* asyncWriter = nullptr;
+    // with --token-ids - interns the tokens of every map task; shufflers and reducers aggregate its IDs
+    TokenDictionary* dictionary = nullptr;
+
+    PipelineContext(const JobConfig &job_config, WorkStealingPool &job_pool, JobMetrics &job_metrics)
+            : config(job_config), pool(job_pool), metrics(job_metrics){
+    }
+};
+
+// State of a single input file as it flows through the pipeline
+struct FilePipeline{
+    std::string fileName;
+    // mapper results retained in memory, keyed by partition number
+    std::map<int, CompactMapperOutput> mapResults;
+    std::mutex mapResultsMutex;
+    // bytes of mapResults charged against the memory budget
+    std::size_t mapResultBytes = 0;
+    // set once a partition of this file went to temp_mapper
+    bool spilled = false;
+    // temp_mapper sub-folder of the file - set by the first map-output task
+    std::string mapperDirectory;
+    // mapper and map-output tasks that have not reported back yet
+    std::atomic<std::size_t> pendingTasks{0};
+    // final output directory, or the first error raised for this file
+    std::promise<std::string> finalOutput;
+};
+
+void pipelineShuffleStage(PipelineContext &context, std::shared_ptr<FilePipeline> file);
+
+// Runs a pipeline stage and routes any error to the file's final output
+template<typename F>
+void submitPipelineStage(PipelineContext &context, JobPhase phase, const std::shared_ptr<FilePipeline> &file, F stage){
+    context.pool.submit(phase, [file, stage]() mutable {
+        tagTask(file->fileName);
+        try{
+            stage();
+        } catch(...){
+            try{
+                file->finalOutput.set_exception(std::current_exception());
+            } catch(std::future_error &){
+                // an earlier stage of this file already failed
+            }
+        }
+    });
+}
+
+// Called when a mapper or map-output task of a file is done - the last one hands the file to its shuffler
+void pipelineTaskDone(PipelineContext &context, const std::shared_ptr<FilePipeline> &file){
+    if(file->pendingTasks.fetch_sub(1) == 1){
+        submitPipelineStage(context, JobPhase::Shuffle, file, [&context, file]{
+            pipelineShuffleStage(context, file);
+        });
+    }
+}
+
+// Writes one mapper result of a file to temp_mapper
+void pipelineWriteMapperOutput(FilePipeline &file, FileProcessorBase* mapOutput){
+    std::string mapperRoot = fileProcessMapOutputs(mapOutput);
+    std::lock_guard<std::mutex> resultsLock(file.mapResultsMutex);
+    file.mapperDirectory = mapperRoot + file.fileName.substr(file.fileName.rfind('/') + 1);
+}
+
+// Map stage - one task per partition; the result is either retained for the in-memory shuffle or written out
+// The mapper is only built once the task runs, so library mappers are reused across partitions and files
+void pipelineMapStage(PipelineContext &context, const std::shared_ptr<FilePipeline> &file,
+                      const std::function<MapperBase*()> &mapper){
+    MapResult mapResult = mapTask(mapper(), context.factories.combiner, context.dictionary);
+    FileProcessorBase* mapOutput = nullptr;
+    if(context.config.inMemoryShuffle){
+        // retained results are held in the compact layout, whichever mapper produced them
+        CompactMapperOutput compactOutput = mapResult.takeCompact();
+        std::size_t bytes = compactOutput.getMemoryBytes();
+        {
+            std::lock_guard<std::mutex> resultsLock(file->mapResultsMutex);
+            if(!file->spilled && context.inMemoryBytes.fetch_add(bytes) + bytes <= context.config.memoryBudgetBytes){
+                file->mapResultBytes += bytes;
+                file->mapResults[mapResult.partitionNum] = std::move(compactOutput);
+                pipelineTaskDone(context, file);
+                return;
+            }
+            if(!file->spilled){
+                context.inMemoryBytes.fetch_sub(bytes);
+                file->spilled = true;
+                std::cout << "Memory budget exceeded - spilling " << file->fileName << " to disk" << std::endl;
+            }
+        }
+        mapOutput = new FileProcessorCompactMapOutput("mapper", std::move(compactOutput), context.config.spillFormat);
+    } else if(context.config.externalSort){
+        mapOutput = new FileProcessorSortedRuns("mapper", mapResult.takeCompact(), context.config.getTaskSortBudget(),
+                                                context.config.spillFormat);
+    } else if(mapResult.compact){
+        mapOutput = new FileProcessorCompactMapOutput("mapper", std::move(mapResult.compactOutput), context.config.spillFormat);
+    } else {
+        prepareMapOutputDirectory(mapResult.getFileName());
+        mapOutput = PluginRegistry::instance().fileProcessors.adopt(
+                context.factories.createMapOutput("mapper", mapResult.nestedOutput), context.factories.removeMapOutput);
+    }
+    submitPipelineStage(context, JobPhase::MapOutput, file, [&context, file, mapOutput]{
+        pipelineWriteMapperOutput(*file, mapOutput);
+        pipelineTaskDone(context, file);
+    });
+}
+
+// Reduce stage - reduces the file's temp_shuffler folder and writes the final output
+void pipelineReduceStage(PipelineContext &context, const std::shared_ptr<FilePipeline> &file, const std::string &shuffle_directory){
+    ReducerBase* reducer = nullptr;
+    if(context.config.externalSort){
+        reducer = new ExternalReducer(shuffle_directory, context.config.getTaskSortBudget(), context.config.spillFormat);
+    } else if(context.config.hashAggregation){
+        auto* nativeReducer = new NativeReducer(shuffle_directory);
+        nativeReducer->setTokenDictionary(context.dictionary);
+        reducer = nativeReducer;
+    } else {
+        reducer = acquireReducer(context.factories.createReducer, shuffle_directory);
+    }
+    auto reduced = std::make_shared<ReduceResult>(reduceTask(reducer));
+    if(reduced->streamed){
+        context.metrics.recordFirstOutput();
+        file->finalOutput.set_value(reduced->outputDirectory);
+        return;
+    }
+    submitPipelineStage(context, JobPhase::ReduceOutput, file, [&context, file, reduced]{
+        FileProcessorBase* reduceOutput = nullptr;
+        if(reduced->hashed){
+            reduceOutput = new FileProcessorAggregatedOutput("reducer", std::move(reduced->aggregatedOutput),
+                                                             SpillFormat::Text, context.asyncWriter);
+        } else {
+            prepareReduceOutputDirectory(context.config);
+            reduceOutput = PluginRegistry::instance().fileProcessors.adopt(
+                    context.factories.createReduceOutput("reducer", reduced->nestedOutput), context.factories.removeReduceOutput);
+        }
+        std::string finalDirectory = fileProcessRedOutputs(reduceOutput);
+        context.metrics.recordFirstOutput();
+        file->finalOutput.set_value(finalDirectory);
+    });
+}
+
+// Shuffle stage - runs once every partition of the file is mapped (and written out, if it spilled)
+void pipelineShuffleStage(PipelineContext &context, std::shared_ptr<FilePipeline> file){
+    ShufflerBase* shuffler = nullptr;
+    if(file->spilled || !context.config.inMemoryShuffle){
+        // results retained before the file spilled join the rest of the file in temp_mapper
+        for(auto &partition: file->mapResults){
+            pipelineWriteMapperOutput(*file, new FileProcessorCompactMapOutput("mapper", std::move(partition.second),
+                                                                               context.config.spillFormat));
+        }
+        file->mapResults.clear();
+        context.inMemoryBytes.fetch_sub(file->mapResultBytes);
+        if(context.config.externalSort){
+            shuffler = new ExternalShuffler(file->mapperDirectory, context.config.getTaskSortBudget(), context.config.spillFormat);
+        } else if(context.config.hashAggregation){
+            auto* nativeShuffler = new NativeShuffler(file->mapperDirectory);
+            nativeShuffler->setTokenDictionary(context.dictionary);
+            shuffler = nativeShuffler;
+        } else {
+            shuffler = acquireShuffler(context.factories.createShuffler, file->mapperDirectory);
+        }
+    } else if(context.config.hashAggregation){
+        auto* nativeShuffler = new NativeShuffler(std::move(file->mapResults));
+        nativeShuffler->setTokenDictionary(context.dictionary);
+        shuffler = nativeShuffler;
+    } else if(context.factories.createInMemoryShuffler){
+        shuffler = PluginRegistry::instance().shufflers.adopt(
+                context.factories.createInMemoryShuffler(toMapperPartitions(file->mapResults)), context.factories.removeShuffler);
+        file->mapResults.clear();
+    } else {
+        shuffler = new InMemoryShuffler(std::move(file->mapResults));
+    }
+    auto shuffled = std::make_shared<ShuffleResult>(shuffleTask(shuffler));
+    if(!file->spilled && context.config.inMemoryShuffle){
+        context.inMemoryBytes.fetch_sub(file->mapResultBytes);
+    }
+    // merged runs are already on disk - straight on to the reducer
+    if(shuffled->streamed){
+        std::string shuffleDirectory = shuffled->outputDirectory;
+        submitPipelineStage(context, JobPhase::Reduce, file, [&context, file, shuffleDirectory]{
+            pipelineReduceStage(context, file, shuffleDirectory);
+        });
+        return;
+    }
+    submitPipelineStage(context, JobPhase::ShuffleOutput, file, [&context, file, shuffled]{
+        FileProcessorBase* shuffleOutput = nullptr;
+        if(shuffled->hashed){
+            shuffleOutput = new FileProcessorAggregatedOutput("shuffler", std::move(shuffled->aggregatedOutput), context.config.spillFormat);
+        } else {
+            prepareShuffleOutputDirectories(shuffled->nestedOutput);
+            shuffleOutput = PluginRegistry::instance().fileProcessors.adopt(
+                    context.factories.createShuffleOutput("shuffler", shuffled->nestedOutput), context.factories.removeShuffleOutput);
+        }
+        std::string shuffleDirectory = fileProcessShufOutputs(shuffleOutput) + "/" + file->fileName.substr(file->fileName.rfind('/') + 1);
+        submitPipelineStage(context, JobPhase::Reduce, file, [&context, file, shuffleDirectory]{
+            pipelineReduceStage(context, file, shuffleDirectory);
+        });
+    });
+}
+
+// Function that partitions one input file and returns a mapper builder per partition - the file is mapped with
+// --mmap-input, else loaded through FileProcessorInput; throws if the file yields no partition
+std::vector<std::function<MapperBase*()>> buildFileMappers(const JobConfig &config, const PipelineFactories &factories,
+                                                           const std::string &file_name, std::size_t task_bytes){
+    std::vector<std::function<MapperBase*()>> mappers;
+    if(config.mmapInput){
+        // the external sort must not hold the whole file while it is being partitioned
+        std::vector<InputSlice> slices = fileMapInputs(file_name, config.externalSort, task_bytes);
+        for(int _i=0; _i < slices.size(); _i++){
+            mappers.push_back([_i, slice = std::move(slices[_i])]() -> MapperBase* {
+                return new NativeMapper(_i, slice);
+            });
+        }
+    } else {
+        FileProcessorBase* input = PluginRegistry::instance().fileProcessors.adopt(
+                factories.createInput("input", file_name), factories.removeInput);
+        std::map<std::string, std::vector<std::vector<std::string>>> partitions = fileProcessInputs(input, task_bytes);
+        for(auto &row: partitions){
+            for(int _i=0; _i < row.second.size(); _i++){
+                if(config.compactMapOutput){
+                    auto records = std::make_shared<std::vector<std::string>>(std::move(row.second[_i]));
+                    mappers.push_back([_i, fileName = row.first, records]() -> MapperBase* {
+                        return new NativeMapper(_i, fileName, std::move(*records));
+                    });
+                } else {
+                    auto tempObj = std::make_shared<std::map<std::string, std::vector<std::string>>>();
+                    tempObj->insert({row.first,std::move(row.second[_i])});
+                    mappers.push_back([_i, tempObj, createMapper = factories.createMapper]{
+                        return acquireMapper(createMapper, _i, std::move(*tempObj));
+                    });
+                }
+            }
+        }
+    }
+    if(mappers.empty()){
+        throw std::runtime_error("No partitions were produced for " + file_name);
+    }
+    return mappers;
+}
+
+// Input stage - loads one file and starts a mapper per partition as soon as the partitions exist
+void pipelineInputStage(PipelineContext &context, const std::shared_ptr<FilePipeline> &file){
+    std::vector<std::function<MapperBase*()>> mappers = buildFileMappers(context.config, context.factories,
+                                                                         file->fileName, context.taskBytes);
+    file->pendingTasks = mappers.size();
+    for(const std::function<MapperBase*()> &mapper: mappers){
+        submitPipelineStage(context, JobPhase::Map, file, [&context, file, mapper]{
+            pipelineMapStage(context, file, mapper);
+        });
+    }
+}
+
+// Loads every library of the job up front - the same handles and symbols as the staged workflow
+// Returns the combiner that factories.combiner points to - nullptr unless --combine is supplied
+std::unique_ptr<CombinerBase> loadPipelineFactories(const JobConfig &config, PipelineFactories &factories){
+    PluginRegistry &registry = PluginRegistry::instance();
+    void* fpInputLibHandle = createLibHandle("./libs/fp/FileProcessorInput.so");
+    factories.createInput = createLibFunc<create_t>(
+            fpInputLibHandle, "./libs/fp/FileProcessorInput.so", "createInputObj");
+    factories.removeInput = createLibFunc<destroy_t>(
+            fpInputLibHandle, "./libs/fp/FileProcessorInput.so", "removeInputObj");
+    void* mapLibHandle = createLibHandle("./libs/map/MapperImpl.so");
+    factories.createMapper = createLibFunc<createMapper_t>(
+            mapLibHandle, "./libs/map/MapperImpl.so", "createInputObj");
+    registry.mappers.setDestroy(createLibFunc<destroyMapper_t>(
+            mapLibHandle, "./libs/map/MapperImpl.so", "removeInputObj"));
+    std::unique_ptr<CombinerBase> combiner(createCombiner(config, mapLibHandle));
+    factories.combiner = combiner.get();
+    void* fpMapOpLibHandle = createLibHandle("./libs/fp/FileProcessorMapOutput.so");
+    factories.createMapOutput = createLibFunc<readMapperOp_t>(
+            fpMapOpLibHandle, "./libs/fp/FileProcessorMapOutput.so", "createInputObj");
+    factories.removeMapOutput = createLibFunc<destroy_t>(
+            fpMapOpLibHandle, "./libs/fp/FileProcessorMapOutput.so", "removeInputObj");
+    void* shufLibHandle = createLibHandle("./libs/shuffle/ShufflerImpl.so");
+    factories.createShuffler = createLibFunc<createShuffler_t>(
+            shufLibHandle, "./libs/shuffle/ShufflerImpl.so", "createInputObj");
+    factories.createInMemoryShuffler = findLibFunc<createInMemoryShuffler_t>(
+            shufLibHandle, "createInMemoryObj");
+    factories.removeShuffler = createLibFunc<destroyShuffler_t>(
+            shufLibHandle, "./libs/shuffle/ShufflerImpl.so", "removeInputObj");
+    registry.shufflers.setDestroy(factories.removeShuffler);
+    void* fpShufOpLibHandle = createLibHandle("./libs/fp/FileProcessorShufOutput.so");
+    factories.createShuffleOutput = createLibFunc<readShufflerOp_t>(
+            fpShufOpLibHandle, "./libs/fp/FileProcessorShufOutput.so", "createInputObj");
+    factories.removeShuffleOutput = createLibFunc<destroy_t>(
+            fpShufOpLibHandle, "./libs/fp/FileProcessorShufOutput.so", "removeInputObj");
+    void* redLibHandle = createLibHandle("./libs/reduce/ReducerImpl.so");
+    factories.createReducer = createLibFunc<createReducer_t>(
+            redLibHandle, "./libs/reduce/ReducerImpl.so", "createInputObj");
+    registry.reducers.setDestroy(createLibFunc<destroyReducer_t>(
+            redLibHandle, "./libs/reduce/ReducerImpl.so", "removeInputObj"));
+    void* fpRedOpLibHandle = createLibHandle("./libs/fp/FileProcessorRedOutput.so");
+    factories.createReduceOutput = createLibFunc<readReducerOp_t>(
+            fpRedOpLibHandle, "./libs/fp/FileProcessorRedOutput.so", "createInputObj");
+    factories.removeReduceOutput = createLibFunc<destroy_t>(
+            fpRedOpLibHandle, "./libs/fp/FileProcessorRedOutput.so", "removeInputObj");
+    return combiner;
+}
+
+// Pipelined variant of the workflow - every file flows through its phases independently of the other files
+// Returns the final output directory
+std::string pipelinedWorkflow(const JobConfig &config, WorkStealingPool &pool, JobMetrics &metrics,
+                              const IncrementalPlan &plan, AsyncFileWriter* async_writer, TokenDictionary* dictionary){
+    PipelineContext context(config, pool, metrics);
+    context.asyncWriter = async_writer;
+    context.dictionary = dictionary;
+    // outlives every task - the pipeline waits for the executor to go idle before it returns
+    std::unique_ptr<CombinerBase> combiner = loadPipelineFactories(config, context.factories);
+
+    // one pipeline per input file
+    std::vector<std::shared_ptr<FilePipeline>> files;
+    std::uintmax_t inputBytes = 0;
+    for(const auto &entry:std::filesystem::directory_iterator(config.inputDirectory)){
+        if(std::filesystem::is_regular_file(entry) && plan.includes(entry.path())){
+            auto file = std::make_shared<FilePipeline>();
+            file->fileName = entry.path();
+            files.push_back(file);
+            inputBytes += entry.file_size();
+        }
+    }
+    // every file has its own chain of tasks - a small file is a single map task, but is not coalesced with others
+    context.taskBytes = config.getTaskBytes(inputBytes);
+    std::cout << "Pipelining " << files.size() << " files..." << std::endl;
+    std::vector<std::future<std::string>> finalOutputs;
+    for(const auto &file: files){
+        finalOutputs.push_back(file->finalOutput.get_future());
+        submitPipelineStage(context, JobPhase::Input, file, [&context, file]{
+            pipelineInputStage(context, file);
+        });
+    }
+    std::string reducerDir;
+    std::exception_ptr failure;
+    for(auto &finalOutput: finalOutputs){
+        try{
+            reducerDir = metrics.awaitResult(finalOutput, JobPhase::ReduceOutput);
+        } catch(...){
+            if(!failure){
+                failure = std::current_exception();
+            }
+        }
+    }
+    // the context must outlive every task - a failed file may still have tasks in flight
+    pool.waitIdle();
+    if(failure){
+        std::rethrow_exception(failure);
+    }
+    // final_output is complete and on the device before SUCCESS.ind is created
+    if(async_writer){
+        metrics.awaitBarrier(JobPhase::ReduceOutput, [async_writer]{ async_writer->flush(JobPhase::ReduceOutput, true); });
+    }
+    return reducerDir;
+}
+
+// Worker process map task - maps every partition of an input file and writes the results to temp_mapper/<file>
+// Returns the temp_mapper folder of the file
+std::string workerMapTask(const JobConfig &config, const PipelineFactories &factories, const std::string &input_file,
+                          std::size_t task_bytes){
+    std::string mapperRoot;
+    for(const std::function<MapperBase*()> &mapper: buildFileMappers(config, factories, input_file, task_bytes)){
+        MapResult mapResult = mapTask(mapper(), factories.combiner, nullptr);
+        FileProcessorBase* mapOutput = nullptr;
+        if(mapResult.compact){
+            mapOutput = new FileProcessorCompactMapOutput("mapper", std::move(mapResult.compactOutput), config.spillFormat);
+        } else {
+            prepareMapOutputDirectory(mapResult.getFileName());
+            mapOutput = PluginRegistry::instance().fileProcessors.adopt(
+                    factories.createMapOutput("mapper", mapResult.nestedOutput), factories.removeMapOutput);
+        }
+        mapperRoot = fileProcessMapOutputs(mapOutput);
+    }
+    return mapperRoot + input_file.substr(input_file.rfind('/') + 1);
+}
+
+// Worker process shuffle task - shuffles a temp_mapper folder and writes the result to temp_shuffler/<file>
+// Returns the temp_shuffler folder of the file
+std::string workerShuffleTask(const JobConfig &config, const PipelineFactories &factories, const std::string &mapper_directory){
+    ShufflerBase* shuffler = nullptr;
+    if(config.hashAggregation){
+        shuffler = new NativeShuffler(mapper_directory);
+    } else {
+        shuffler = acquireShuffler(factories.createShuffler, mapper_directory);
+    }
+    ShuffleResult shuffled = shuffleTask(shuffler);
+    FileProcessorBase* shuffleOutput = nullptr;
+    if(shuffled.hashed){
+        shuffleOutput = new FileProcessorAggregatedOutput("shuffler", std::move(shuffled.aggregatedOutput), config.spillFormat);
+    } else {
+        prepareShuffleOutputDirectories(shuffled.nestedOutput);
+        shuffleOutput = PluginRegistry::instance().fileProcessors.adopt(
+                factories.createShuffleOutput("shuffler", shuffled.nestedOutput), factories.removeShuffleOutput);
+    }
+    return fileProcessShufOutputs(shuffleOutput) + "/" + mapper_directory.substr(mapper_directory.rfind('/') + 1);
+}
+
+// Worker process reduce task - reduces a temp_shuffler folder and writes its final_output file
+// Returns the final output directory
+std::string workerReduceTask(const JobConfig &config, const PipelineFactories &factories, const std::string &shuffle_directory){
+    ReducerBase* reducer = nullptr;
+    if(config.hashAggregation){
+        reducer = new NativeReducer(shuffle_directory);
+    } else {
+        reducer = acquireReducer(factories.createReducer, shuffle_directory);
+    }
+    ReduceResult reduced = reduceTask(reducer);
+    FileProcessorBase* reduceOutput = nullptr;
+    if(reduced.hashed){
+        reduceOutput = new FileProcessorAggregatedOutput("reducer", std::move(reduced.aggregatedOutput), SpillFormat::Text);
+    } else {
+        prepareReduceOutputDirectory(config);
+        reduceOutput = PluginRegistry::instance().fileProcessors.adopt(
+                factories.createReduceOutput("reducer", reduced.nestedOutput), factories.removeReduceOutput);
+    }
+    return fileProcessRedOutputs(reduceOutput);
+}
+
+// Runs one task of a worker process on its only thread - measured like an executor task, the counts are reported
+// by the same helpers through the worker's own TaskMetrics
+WorkerResult runWorkerTask(const JobConfig &config, const PipelineFactories &factories, const WorkerTask &task){
+    WorkerResult result;
+    result.id = task.id;
+    result.metrics.phase = task.phase;
+    double cpuStart = readThreadCpuSeconds();
+    currentTaskMetrics() = &result.metrics;
+    try{
+        if(task.phase == JobPhase::Map){
+            result.output = workerMapTask(config, factories, task.argument, task.taskBytes);
+        } else if(task.phase == JobPhase::Shuffle){
+            result.output = workerShuffleTask(config, factories, task.argument);
+        } else if(task.phase == JobPhase::Reduce){
+            result.output = workerReduceTask(config, factories, task.argument);
+        } else {
+            throw std::runtime_error("Unsupported worker task: " + std::string(phaseName(task.phase)));
+        }
+        result.succeeded = true;
+    } catch(std::exception &exception){
+        // reported to the coordinator, which fails the job - the process itself is still sound
+        result.output = exception.what();
+    }
+    currentTaskMetrics() = nullptr;
+    result.metrics.cpuSeconds = readThreadCpuSeconds() - cpuStart;
+    result.metrics.rssKilobytesAtEnd = readRssKilobytes();
+    return result;
+}
+
+// Entry point of a worker process (MRExec --worker=<socket>) - runs the tasks of its coordinator until it is shut down
+int runWorkerProcess(const std::string &socket_path){
+    int connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address = workerSocketAddress(socket_path);
+    std::string hello;
+    appendVarint(hello, static_cast<std::uint64_t>(getpid()));
+    WorkerMessage message;
+    if(connection < 0 || connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+       !sendWorkerMessage(connection, WorkerMessageType::Hello, hello) ||
+       !receiveWorkerMessage(connection, message) || message.type != WorkerMessageType::Setup){
+        std::cerr << "Worker process " << getpid() << " cannot reach its coordinator at " << socket_path << std::endl;
+        return 1;
+    }
+    // the job's own command line - every worker builds the same JobConfig as the coordinator
+    JobConfig config;
+    PipelineFactories factories;
+    std::unique_ptr<CombinerBase> combiner;
+    std::string error;
+    try{
+        std::size_t position = 0;
+        std::vector<std::string> arguments(readVarint(message.payload, position));
+        std::vector<char*> argv{const_cast<char*>("MRExec")};
+        for(std::string &argument: arguments){
+            argument = readMessageString(message.payload, position);
+            argv.push_back(argument.data());
+        }
+        config = parseJobConfig(static_cast<int>(argv.size()), argv.data());
+        combiner = loadPipelineFactories(config, factories);
+    } catch(std::runtime_error &runtime_error){
+        error = runtime_error.what();
+    }
+    std::string ready;
+    appendMessageString(ready, error);
+    if(!sendWorkerMessage(connection, WorkerMessageType::Ready, ready) || !error.empty()){
+        close(connection);
+        return 1;
+    }
+    // one task at a time - the coordinator closing the connection ends the worker as well as a Shutdown message
+    while(receiveWorkerMessage(connection, message) && message.type == WorkerMessageType::Task){
+        WorkerResult result = runWorkerTask(config, factories, decodeWorkerTask(message.payload));
+        if(!sendWorkerMessage(connection, WorkerMessageType::Result, encodeWorkerResult(result))){
+            break;
+        }
+    }
+    close(connection);
+    PluginRegistry::instance().close();
+    return 0;
+}
+
+// Function that runs a task in a worker process - the executor task only waits on the worker, so the records, bytes,
+// CPU time and RSS measured there are charged to it
+std::string remoteTask(WorkerCoordinator &coordinator, JobPhase phase, const std::string &argument, std::size_t task_bytes){
+    tagTask(argument);
+    WorkerTask task;
+    task.phase = phase;
+    task.argument = argument;
+    task.taskBytes = task_bytes;
+    WorkerResult result = coordinator.run(task);
+    countTaskInput(result.metrics.recordsIn, result.metrics.bytesIn);
+    countTaskOutput(result.metrics.recordsOut, result.metrics.bytesOut);
+    countTaskCpu(result.metrics.cpuSeconds);
+    countTaskRss(result.metrics.rssKilobytesAtEnd);
+    return result.output;
+}
+
+// Multi-process variant of the workflow - the map, shuffle and reduce tasks of every file run in the worker processes
+// of the coordinator (--processes). Returns the final output directory
+std::string processWorkflow(const JobConfig &config, WorkerCoordinator &coordinator, WorkStealingPool &pool,
+                            JobMetrics &metrics, const IncrementalPlan &plan){
+    std::vector<std::string> directory_files;
+    std::uintmax_t input_bytes = 0;
+    for(const auto &entry:std::filesystem::directory_iterator(config.inputDirectory)){
+        if(std::filesystem::is_regular_file(entry) && plan.includes(entry.path())){
+            directory_files.push_back(entry.path());
+            input_bytes += entry.file_size();
+        }
+    }
+    if(directory_files.empty()){
+        throw std::runtime_error("No files found to process along " + config.inputDirectory);
+    }
+    // a map task covers a whole file - the worker cuts it into partitions of ~ task_bytes and maps them one by one
+    std::size_t task_bytes = config.getTaskBytes(input_bytes);
+    std::cout << "Running " << directory_files.size() << " files on " << coordinator.getWorkerCount()
+              << " worker processes..." << std::endl;
+    // the phases hand their data over through temp_mapper and temp_shuffler - every process reads and writes them
+    std::vector<std::future<std::string>> mapped;
+    for(const std::string &file: directory_files){
+        mapped.push_back(pool.submit(JobPhase::Map, remoteTask, std::ref(coordinator), JobPhase::Map, file, task_bytes));
+    }
+    std::vector<std::string> mapper_folders;
+    for(auto &fut_map: mapped){
+        mapper_folders.push_back(metrics.awaitResult(fut_map, JobPhase::Map));
+    }
+    std::string mapper_root_directory = std::filesystem::path(mapper_folders.front()).parent_path().string();
+    if(evalFolders(mapper_root_directory, plan) != (int)directory_files.size()){
+        throw std::runtime_error("Mapper output is incomplete in " + mapper_root_directory);
+    }
+    std::cout << "All mapper output has been written to this root directory - " << mapper_root_directory << std::endl;
+
+    std::vector<std::future<std::string>> shuffled;
+    for(const std::string &folder: mapper_folders){
+        shuffled.push_back(pool.submit(JobPhase::Shuffle, remoteTask, std::ref(coordinator), JobPhase::Shuffle, folder, 0));
+    }
+    std::vector<std::string> shuffler_folders;
+    for(auto &fut_shuf: shuffled){
+        shuffler_folders.push_back(metrics.awaitResult(fut_shuf, JobPhase::Shuffle));
+    }
+    std::string shuffler_root_directory = std::filesystem::path(shuffler_folders.front()).parent_path().string();
+    std::vector<std::string> filesDontExist = subFolderFileChecks(mapper_root_directory, shuffler_root_directory, plan);
+    if(evalFolders(shuffler_root_directory, plan) != (int)directory_files.size() || !filesDontExist.empty()){
+        throw std::runtime_error("Shuffler output is incomplete in " + shuffler_root_directory);
+    }
+    std::cout << "All Shuffler output has been written to this root directory - " << shuffler_root_directory << std::endl;
+
+    std::vector<std::future<std::string>> reduced;
+    for(const std::string &folder: shuffler_folders){
+        reduced.push_back(pool.submit(JobPhase::Reduce, remoteTask, std::ref(coordinator), JobPhase::Reduce, folder, 0));
+    }
+    std::string reducerDir;
+    for(auto &fut_red: reduced){
+        reducerDir = metrics.awaitResult(fut_red, JobPhase::Reduce);
+        metrics.recordFirstOutput();
+    }
+    return reducerDir;
+}
+
+// Function that indexes the final_output files of a job - final_output/index/<file>.idx, one task per file
+// An incremental run only indexes the files it ran, and the reused ones that have no index yet
+void indexFinalOutput(const std::string &reducerDir, const IncrementalPlan &plan, WorkStealingPool &pool, JobMetrics &metrics){
+    std::vector<std::future<std::size_t>> indexed;
+    for(const auto &entry: std::filesystem::directory_iterator(reducerDir)){
+        std::string fileName = entry.path().filename().string();
+        if(!entry.is_regular_file() || fileName == "SUCCESS.ind" || fileName == MANIFEST_FILE_NAME){
+            continue;
+        }
+        if(!plan.includes(entry.path()) && std::filesystem::is_regular_file(outputIndexPath(entry.path()))){
+            continue;
+        }
+        // read back from the page cache - the library FileProcessorRedOutput writes final_output on its own
+        indexed.push_back(pool.submit(JobPhase::ReduceOutput, [outputFile = entry.path().string()]{
+            tagTask(outputFile);
+            return writeOutputIndex(outputFile);
+        }));
+    }
+    std::size_t tokens = 0;
+    for(auto &fut_index: indexed){
+        tokens += metrics.awaitResult(fut_index, JobPhase::ReduceOutput);
+    }
+    std::cout << "Indexed " << indexed.size() << " final output files (" << tokens << " tokens) in "
+              << (std::filesystem::path(reducerDir) / OUTPUT_INDEX_DIRECTORY).string() << std::endl;
+}
+
+// Prints the size of the job's token dictionary - nothing without --token-ids
+void printTokenDictionary(TokenDictionary* dictionary){
+    if(dictionary){
+        std::cout << "Token dictionary - " << dictionary->size() << " distinct tokens, "
+                  << dictionary->getTokenBytes() << " bytes" << std::endl;
+    }
+}
+
+// Emits the structured job metrics - the phase summary on stdout, the summary with every task to --metrics-json
+// and the timeline of the tasks to --trace
+void emitJobMetrics(const JobConfig &config, WorkStealingPool &pool, JobMetrics &metrics){
+    metrics.collectTaskMetrics(pool);
+    std::cout << "Job metrics: ";
+    metrics.writeJson(std::cout, false);
+    if(!config.metricsJsonPath.empty()){
+        std::ofstream output(config.metricsJsonPath, std::ios::out | std::ios::trunc);
+        metrics.writeJson(output, true);
+        if(!output){
+            throw std::runtime_error("Cannot write job metrics!: " + config.metricsJsonPath);
+        }
+    }
+    if(!config.tracePath.empty()){
+        std::ofstream output(config.tracePath, std::ios::out | std::ios::trunc);
+        metrics.writeChromeTrace(output);
+        if(!output){
+            throw std::runtime_error("Cannot write job trace!: " + config.tracePath);
+        }
+    }
+}
+
 // Overarching function that will perform Map Reduce operations
-void mapReduceWorkflow(const std::string &input_directory) {
+void mapReduceWorkflow(const JobConfig &config) {
+    const std::string &input_directory = config.inputDirectory;
+    // --async-output - the built-in output processors hand their files to this writer; created before the executor,
+    // so it outlives any task that may still be writing when the job fails
+    std::unique_ptr<AsyncFileWriter> asyncWriter;
+    if(config.asyncOutput){
+        asyncWriter = std::make_unique<AsyncFileWriter>(config.writeBackend);
+        std::cout << "Writing output asynchronously through " << asyncWriter->getBackendName() << std::endl;
+    }
+    // --combine - shared by every mapper; like the writer it outlives the executor, as a losing backup attempt may
+    // still be mapping when the map phase is over
+    std::unique_ptr<CombinerBase> combiner;
+    // --token-ids - the token dictionary of the job; outlives the executor for the same reason
+    std::unique_ptr<TokenDictionary> dictionary;
+    if(config.tokenIds){
+        dictionary = std::make_unique<TokenDictionary>();
+    }
+    // --processes - the worker processes of the job; created before the executor, whose tasks hand them the work
+    std::unique_ptr<WorkerCoordinator> coordinator;
+    if(config.processCount > 0){
+        coordinator = std::make_unique<WorkerCoordinator>(config.processCount, config.arguments, config.workerMemoryBytes);
+        std::cout << "Started " << coordinator->getWorkerCount() << " worker processes" << std::endl;
+    }
+    // plugin libraries and pooled plugin objects of the job
+    PluginRegistry &registry = PluginRegistry::instance();
+    // Executor shared by every phase - the thread count stays fixed while the task count follows the input size
+    // With worker processes its threads only wait on them - one thread per worker process
+    WorkStealingPool pool(coordinator ? config.processCount : config.workerCount);
+    // Per-phase wait times - completion is tracked through the task futures
+    JobMetrics metrics;
     try{
+        // incremental re-run - only the new and modified files go through the job
+        IncrementalPlan plan;
+        if(config.incremental){
+            plan = planIncrementalRun(config);
+            std::cout << "Incremental run - " << plan.runFiles.size() << " new or modified files, "
+                      << plan.reusedFiles.size() << " unchanged files reused" << std::endl;
+            if(plan.runFiles.empty()){
+                std::string reducerDir = (std::filesystem::path(input_directory) / "final_output").string();
+                std::cout << "All final output is up to date in this root directory - " << reducerDir << std::endl;
+                if(config.indexOutput){
+                    indexFinalOutput(reducerDir, plan, pool, metrics);
+                }
+                metrics.recordJobEnd();
+                emitJobMetrics(config, pool, metrics);
+                createSuccessIndicator(input_directory, reducerDir);
+                plan.manifest.save(reducerDir);
+                return;
+            }
+        }
+        // pipelined dataflow - no stage barriers between files
+        if(config.pipelined){
+            std::string reducerDir = pipelinedWorkflow(config, pool, metrics, plan, asyncWriter.get(), dictionary.get());
+            std::cout << "All final output has been written to this root directory - " << reducerDir << std::endl;
+            if(config.indexOutput){
+                indexFinalOutput(reducerDir, plan, pool, metrics);
+            }
+            metrics.recordJobEnd();
+            pool.printStats(std::cout);
+            registry.printStats(std::cout);
+            printTokenDictionary(dictionary.get());
+            metrics.printWaitTimes(std::cout);
+            emitJobMetrics(config, pool, metrics);
+            createSuccessIndicator(input_directory, reducerDir);
+            if(plan.active){
+                plan.manifest.save(reducerDir);
+            }
+            return;
+        }
+        // worker processes - every map, shuffle and reduce task runs outside this process
+        if(coordinator){
+            std::string reducerDir = processWorkflow(config, *coordinator, pool, metrics, plan);
+            std::cout << "All final output has been written to this root directory - " << reducerDir << std::endl;
+            if(config.indexOutput){
+                indexFinalOutput(reducerDir, plan, pool, metrics);
+            }
+            metrics.recordJobEnd();
+            pool.printStats(std::cout);
+            coordinator->printStats(std::cout);
+            metrics.printWaitTimes(std::cout);
+            emitJobMetrics(config, pool, metrics);
+            createSuccessIndicator(input_directory, reducerDir);
+            if(plan.active){
+                plan.manifest.save(reducerDir);
+            }
+            return;
+        }
         // Load a handle corresponding to FileProcessorInput library
         void* fpInputLibHandle = createLibHandle("./libs/fp/FileProcessorInput.so");
         // Load the FileProcessorInput library!
@@ -307,28 +1564,48 @@ void mapReduceWorkflow(const std::string &input_directory) {
                 fpInputLibHandle,
                 "./libs/fp/FileProcessorInput.so",
                 "createInputObj");
+        // and the one that destroys them once their partitions are taken
+        destroy_t* remove_InputDirectoryFP_Obj = createLibFunc<destroy_t>(
+                fpInputLibHandle,
+                "./libs/fp/FileProcessorInput.so",
+                "removeInputObj");
 
         // declare a vector that will hold the all files in a directory!
         std::vector<std::string> directory_files;
+        std::uintmax_t input_bytes = 0;
         // iterate and load directory_files vector!
         for(const auto &entry:std::filesystem::directory_iterator(input_directory)){
-            if(std::filesystem::is_regular_file(entry)){
+            if(std::filesystem::is_regular_file(entry) && plan.includes(entry.path())){
                 directory_files.push_back(entry.path());
+                input_bytes += entry.file_size();
             }
         }
+        // input bytes per map task - 0 keeps the 2000 record partitions
+        std::size_t task_bytes = config.getTaskBytes(input_bytes);
+        if(task_bytes > 0){
+            std::cout << "Sizing map tasks to " << task_bytes << " bytes of input" << std::endl;
+        }
         // declare a vector that will hold all fileProcessorInput objects
         std::vector<FileProcessorBase*> fp_objects;
-        // use directory_files vector to load fp_objects vector
-        for(const auto &file: directory_files){
-            fp_objects.push_back(create_InputDirectoryFP_Obj("input",file));
-        }
         // declare a vector of futures that will host results of file processor input operations
         std::vector<std::future<std::map<std::string, std::vector<std::vector<std::string>>>>> load_dir_files;
-        // use fp_objects vector to call individual objects and load the load_dir_files vector
-        for(auto obj: fp_objects){
-            load_dir_files.push_back(std::async(fileProcessInputs,obj));
+        // with --mmap-input the files are mapped instead - futures of the partitions of each mapping
+        std::vector<std::future<std::vector<InputSlice>>> mapped_dir_files;
+        if(config.mmapInput){
+            for(const auto &file: directory_files){
+                mapped_dir_files.push_back(pool.submit(JobPhase::Input,fileMapInputs,file,false,task_bytes));
+            }
+        } else {
+            // use directory_files vector to load fp_objects vector
+            for(const auto &file: directory_files){
+                fp_objects.push_back(registry.fileProcessors.adopt(create_InputDirectoryFP_Obj("input",file), remove_InputDirectoryFP_Obj));
+            }
+            // use fp_objects vector to call individual objects and load the load_dir_files vector
+            for(auto obj: fp_objects){
+                load_dir_files.push_back(pool.submit(JobPhase::Input,fileProcessInputs,obj,task_bytes));
+            }
         }
-        std::cout << "There are " << load_dir_files.size() << " future objects in load_dir_files..." << std::endl;
+        std::cout << "There are " << load_dir_files.size() + mapped_dir_files.size() << " future objects in load_dir_files..." << std::endl;
 
         // Load a handle corresponding to Mapper library
         void* mapLibHandle = createLibHandle("./libs/map/MapperImpl.so");
@@ -338,38 +1615,109 @@ void mapReduceWorkflow(const std::string &input_directory) {
                 mapLibHandle,
                 "./libs/map/MapperImpl.so",
                 "createInputObj");
+        // library mappers are pooled - one instance serves many partitions
+        registry.mappers.setDestroy(createLibFunc<destroyMapper_t>(
+                mapLibHandle,
+                "./libs/map/MapperImpl.so",
+                "removeInputObj"));
 
-        // declare a vector that will hold all mapper objects
-        std::vector<MapperBase*> mapper_objects;
+        // declare a vector that builds every mapper - a mapper is only built when its task starts, so the instances
+        // released by finished tasks are reused
+        std::vector<std::function<MapperBase*()>> mapper_objects;
+        // input bytes of every mapper - used to coalesce small partitions into one task
+        std::vector<std::size_t> mapper_bytes;
+        // with --speculate - builds a fresh copy of every mapper, for a backup attempt
+        std::vector<std::function<MapperBase*()>> mapper_copies;
 
+        // mapped files - one NativeMapper per byte range
+        for(auto &fut_input: mapped_dir_files){
+            std::vector<InputSlice> slices = metrics.awaitResult(fut_input, JobPhase::Input);
+            for(int _i=0; _i < slices.size(); _i++){
+                std::cout << "Creating Mapper#" << _i << " over the mapping of " << slices[_i].file->getFileName() << std::endl;
+                mapper_bytes.push_back(slices[_i].end - slices[_i].begin);
+                if(config.speculate){
+                    // a slice is a view of the shared mapping - a backup reads the same pages again
+                    mapper_copies.push_back([_i, slice = slices[_i]]() -> MapperBase* { return new NativeMapper(_i, slice); });
+                }
+                mapper_objects.push_back([_i, slice = std::move(slices[_i])]() -> MapperBase* { return new NativeMapper(_i, slice); });
+            }
+        }
         // iterate over the load_dir_files vector...
         for(auto i=0; i < load_dir_files.size(); i++){
-            const std::map<std::string, std::vector<std::vector<std::string>>> &retInput = load_dir_files[i].get();
+            // owned here - each partition is moved into its mapper input rather than copied
+            std::map<std::string, std::vector<std::vector<std::string>>> retInput = metrics.awaitResult(load_dir_files[i], JobPhase::Input);
             // displaying data!
-            for(const auto& row: retInput){
+            for(auto& row: retInput){
                 std::cout << row.first << std::endl;
                 for(int _i=0; _i < row.second.size(); _i++){
                     std::cout << "Operating on file - " << row.first << std::endl;
                     std::cout << "Working on partition#" << _i << std::endl;
-                    // create temp obj
-                    std::map<std::string, std::vector<std::string>> tempObj;
-                    tempObj.insert({row.first,row.second[_i]});
                     std::cout << "Creating Mapper#" << _i << std::endl;
-                    mapper_objects.push_back(create_Mapper_Obj(_i, tempObj));
+                    std::size_t bytes = 0;
+                    for(const std::string &record: row.second[_i]){
+                        bytes += record.size() + 1;
+                    }
+                    mapper_bytes.push_back(bytes);
+                    if(config.speculate){
+                        // the mapper consumes its records - a backup needs a copy of its own
+                        auto records = std::make_shared<const std::map<std::string, std::vector<std::string>>>(
+                                std::map<std::string, std::vector<std::string>>{{row.first, row.second[_i]}});
+                        if(config.compactMapOutput){
+                            mapper_copies.push_back([_i, records]() -> MapperBase* { return new NativeMapper(_i, *records); });
+                        } else {
+                            mapper_copies.push_back([_i, records, create_Mapper_Obj]{
+                                return acquireMapper(create_Mapper_Obj, _i, std::map<std::string, std::vector<std::string>>(*records));
+                            });
+                        }
+                    }
+                    if(config.compactMapOutput){
+                        auto records = std::make_shared<std::vector<std::string>>(std::move(row.second[_i]));
+                        mapper_objects.push_back([_i, file = row.first, records]() -> MapperBase* {
+                            return new NativeMapper(_i, file, std::move(*records));
+                        });
+                    } else {
+                        // create temp obj - moved into the mapper once it is acquired
+                        auto tempObj = std::make_shared<std::map<std::string, std::vector<std::string>>>();
+                        tempObj->insert({row.first,std::move(row.second[_i])});
+                        mapper_objects.push_back([_i, tempObj, create_Mapper_Obj]{
+                            return acquireMapper(create_Mapper_Obj, _i, std::move(*tempObj));
+                        });
+                    }
                 }
             }
         }
         // declare a vector of futures that will host results of mapper operations
-        std::vector<std::future<std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>>>> mapped_data;
+        std::vector<std::future<std::vector<MapResult>>> mapped_data;
+        // with --speculate, a straggling map task gets a backup on an idle worker once most of the phase is done
+        SpeculativePhase<std::vector<MapResult>> map_speculation(pool, JobPhase::Map, config.speculate);
 
         // use mapper_objects vector to call individual objects and load the mapper_data vector
         std::cout << "There are " << mapper_objects.size() << " mappers" << std::endl;
 
-        // run the mapper operations using mappers!
-        for(auto obj:mapper_objects){
-            mapper_mutex.lock();
-            mapped_data.push_back(std::async(mapperOps,obj));
-            mapper_mutex.unlock();
+        // optional mapper-side combiner - shared by every mapper
+        combiner.reset(createCombiner(config, mapLibHandle));
+        // optional partitioner - with --reducers, every shuffler buckets its file's tokens across the reducers
+        partitionKey_t* partitioner = resolvePartitioner(config, mapLibHandle);
+        // run the mapper operations using mappers! - with --task-bytes the partitions of small files share a task,
+        // otherwise every mapper is a task of its own
+        for(const auto &batch: coalesceTasks(mapper_bytes, task_bytes)){
+            std::vector<std::function<MapperBase*()>> batch_mappers;
+            std::vector<std::function<MapperBase*()>> batch_copies;
+            for(std::size_t index: batch){
+                batch_mappers.push_back(std::move(mapper_objects[index]));
+                if(config.speculate){
+                    batch_copies.push_back(mapper_copies[index]);
+                }
+            }
+            std::function<std::vector<MapResult>()> backup;
+            if(config.speculate){
+                backup = [batch_copies, combiner = combiner.get(), dictionary = dictionary.get()]{
+                    return mapBatchTask(batch_copies, combiner, dictionary);
+                };
+            }
+            mapped_data.push_back(map_speculation.submit([batch_mappers, combiner = combiner.get(), dictionary = dictionary.get()]{
+                return mapBatchTask(batch_mappers, combiner, dictionary);
+            }, backup));
         }
 
         std::cout << "There are " << mapped_data.size() << " future objects in mapper_data vector...." << std::endl;
@@ -381,51 +1729,117 @@ void mapReduceWorkflow(const std::string &input_directory) {
                 fpMapOpLibHandle,
                 "./libs/fp/FileProcessorMapOutput.so",
                 "createInputObj");
+        destroy_t* remove_MapperFP_Obj = createLibFunc<destroy_t>(
+                fpMapOpLibHandle,
+                "./libs/fp/FileProcessorMapOutput.so",
+                "removeInputObj");
 
         // declare a vector that will hold all fileProcessorMapOutput objects
         std::vector<FileProcessorBase*> fp_map_outputs;
+        // in-memory shuffle mode - mapper results kept in memory: file -> partition -> mapper result
+        std::map<std::string, std::map<int, CompactMapperOutput>> in_memory_partitions;
+        // bytes currently held in in_memory_partitions
+        std::size_t in_memory_bytes = 0;
+        // files whose mapper results went to temp_mapper
+        std::set<std::string> spilled_files;
 
-        // load the mapper output to disk using FileProcessorMapOutput
-        for(auto i=0; i < mapped_data.size(); i++){
-            mapper_op_mutex.lock();
-            const std::map<std::string, std::vector<std::vector<std::tuple<std::string, int, int>>>> &retInput = mapped_data[i].get();
-            // supply retInput as arguments to FileProcessorMapOutput
-            fp_map_outputs.push_back(create_MapperFP_Obj("mapper",retInput));
-            mapper_op_mutex.unlock();
+        // load the mapper output to disk using FileProcessorMapOutput (or keep it in memory within the budget)
+        for(auto &fut_map: mapped_data){
+            // a coalesced task hands back the results of all of its partitions
+            for(MapResult &retInput: map_speculation.await(fut_map, metrics)){
+                const std::string fileName = retInput.getFileName();
+                if(config.inMemoryShuffle && !fileName.empty()){
+                    // retained results are held in the compact layout, whichever mapper produced them
+                    CompactMapperOutput compactOutput = retInput.takeCompact();
+                    std::size_t bytes = compactOutput.getMemoryBytes();
+                    if(spilled_files.count(fileName) == 0 && in_memory_bytes + bytes <= config.memoryBudgetBytes){
+                        in_memory_bytes += bytes;
+                        in_memory_partitions[fileName][retInput.partitionNum] = std::move(compactOutput);
+                        continue;
+                    }
+                    // over budget - the whole file spills so that its temp_mapper folder is complete
+                    if(spilled_files.insert(fileName).second){
+                        std::cout << "Memory budget exceeded - spilling " << fileName << " to disk" << std::endl;
+                        auto retained = in_memory_partitions.find(fileName);
+                        if(retained != in_memory_partitions.end()){
+                            for(auto &partition: retained->second){
+                                in_memory_bytes -= partition.second.getMemoryBytes();
+                                fp_map_outputs.push_back(new FileProcessorCompactMapOutput("mapper",std::move(partition.second),config.spillFormat,asyncWriter.get()));
+                            }
+                            in_memory_partitions.erase(retained);
+                        }
+                    }
+                    fp_map_outputs.push_back(new FileProcessorCompactMapOutput("mapper",std::move(compactOutput),config.spillFormat,asyncWriter.get()));
+                    continue;
+                }
+                if(!fileName.empty()){
+                    spilled_files.insert(fileName);
+                }
+                // supply retInput as arguments to FileProcessorMapOutput - compact results are written by the built-in processor
+                if(retInput.compact){
+                    if(!fileName.empty()){
+                        fp_map_outputs.push_back(new FileProcessorCompactMapOutput("mapper",std::move(retInput.compactOutput),config.spillFormat,asyncWriter.get()));
+                    }
+                } else {
+                    prepareMapOutputDirectory(fileName);
+                    fp_map_outputs.push_back(registry.fileProcessors.adopt(create_MapperFP_Obj("mapper",retInput.nestedOutput), remove_MapperFP_Obj));
+                }
+            }
+        }
+        if(config.speculate){
+            metrics.recordSpeculation(JobPhase::Map, map_speculation.getBackupsLaunched(), map_speculation.getBackupWins());
+            std::cout << "Map backups launched - " << map_speculation.getBackupsLaunched()
+                      << ", won - " << map_speculation.getBackupWins() << std::endl;
         }
 
         // declare a vector of futures that will host results of mapper file processor output operations
         std::vector<std::future<std::string>> fp_map_output_dirs;
-        std::mutex hope; // this could be removed!
-        hope.lock(); // this could be removed!
         // run the file processor mapper output operation...
         for(auto obj: fp_map_outputs){
-            mapper_ld_mutex.lock();
-            fp_map_output_dirs.push_back(std::async(fileProcessMapOutputs,obj));
-            mapper_ld_mutex.unlock();
+            fp_map_output_dirs.push_back(pool.submit(JobPhase::MapOutput,fileProcessMapOutputs,obj));
+        }
+        // The map-output phase is complete once every writer has reported back through its future
+        std::string mapper_root_directory;
+        for(auto &fut_map: fp_map_output_dirs){
+            mapper_root_directory = metrics.awaitResult(fut_map, JobPhase::MapOutput);
+        }
+        // with --async-output the files may still be in flight - the shufflers read them back
+        if(asyncWriter){
+            metrics.awaitBarrier(JobPhase::MapOutput, [&asyncWriter]{ asyncWriter->flush(JobPhase::MapOutput, false); });
         }
-        hope.unlock(); // this could be removed!
-        std::string mapper_root_directory = fp_map_output_dirs.front().get();
         // original file count
         int og_file_count = directory_files.size();
-        int current_mapper_count = evalFolders(mapper_root_directory);
         std::cout << "Original file count " << og_file_count << std::endl;
-        std::cout << "Current mapper count " << current_mapper_count << std::endl;
-        // while loop that forces that mapper operation is "somewhat" complete...
-        while(og_file_count != current_mapper_count){
-            current_mapper_count = evalFolders(mapper_root_directory);
-        }
-        std::cout << "All mapper output has been written to this root directory - " << mapper_root_directory << std::endl;
-
         // declare a vector that will hold the all mapper folders!
         std::vector<std::string> mapper_folders;
-        // iterate and load directory_files vector!
-        for(const auto &entry:std::filesystem::directory_iterator(mapper_root_directory)){
-            mapper_folders.push_back(entry.path());
-        }
-        std::cout << "The individual temp_mapper folders are: " << std::endl;
-        for(const std::string &folder:mapper_folders){
-            std::cout << folder << std::endl;
+        if(!mapper_root_directory.empty()){
+            // single on-disk check now that all writers are done
+            int current_mapper_count = evalFolders(mapper_root_directory, plan);
+            std::cout << "Current mapper count " << current_mapper_count << std::endl;
+            if((config.inMemoryShuffle && current_mapper_count < (int)spilled_files.size()) ||
+               (!config.inMemoryShuffle && og_file_count != current_mapper_count)){
+                throw std::runtime_error("Mapper output is incomplete in " + mapper_root_directory);
+            }
+            std::cout << "All mapper output has been written to this root directory - " << mapper_root_directory << std::endl;
+
+            // temp_mapper sub-folders are named after the base file name
+            std::set<std::string> spilled_folders;
+            for(const std::string &file: spilled_files){
+                spilled_folders.insert(file.substr(file.rfind('/') + 1));
+            }
+            // iterate and load directory_files vector! - in-memory mode only shuffles the folders of spilled files
+            for(const auto &entry:std::filesystem::directory_iterator(mapper_root_directory)){
+                if(!plan.includes(entry.path())){
+                    continue;
+                }
+                if(!config.inMemoryShuffle || spilled_folders.count(entry.path().filename().string()) > 0){
+                    mapper_folders.push_back(entry.path());
+                }
+            }
+            std::cout << "The individual temp_mapper folders are: " << std::endl;
+            for(const std::string &folder:mapper_folders){
+                std::cout << folder << std::endl;
+            }
         }
         std::cout << "Proceeding to create Shuffler objects to operate against temp_mapper sub-folders..." << std::endl;
 
@@ -436,20 +1850,60 @@ void mapReduceWorkflow(const std::string &input_directory) {
                 shufLibHandle,
                 "./libs/shuffle/ShufflerImpl.so",
                 "createInputObj");
-        // declare a vector of shuffler objects
-        std::vector<ShufflerBase*> shuffler_objects;
+        destroyShuffler_t* remove_Shuffler_Obj = createLibFunc<destroyShuffler_t>(
+                shufLibHandle,
+                "./libs/shuffle/ShufflerImpl.so",
+                "removeInputObj");
+        registry.shufflers.setDestroy(remove_Shuffler_Obj);
+        // declare a vector that builds every shuffler - built when its task starts, like the mappers
+        std::vector<std::function<ShufflerBase*()>> shuffler_objects;
         // load the vector of shuffler objects by supplying the individual temp_mapper folders...
         for(const std::string &folder:mapper_folders){
-            shuffler_objects.push_back(create_Shuffler_Obj(folder));
+            if(config.hashAggregation){
+                shuffler_objects.push_back([folder, partitioner, reducers = config.reducerCount, dictionary = dictionary.get()]() -> ShufflerBase* {
+                    auto* shuffler = new NativeShuffler(folder);
+                    shuffler->setTokenDictionary(dictionary);
+                    if(partitioner){
+                        shuffler->setPartitioning(partitioner, reducers);
+                    }
+                    return shuffler;
+                });
+            } else {
+                shuffler_objects.push_back([folder, create_Shuffler_Obj]{ return acquireShuffler(create_Shuffler_Obj, folder); });
+            }
+        }
+        // in-memory mapper results go straight to a shuffler - the library's own factory if it exports one
+        if(!in_memory_partitions.empty()){
+            createInMemoryShuffler_t* create_InMemoryShuffler_Obj = findLibFunc<createInMemoryShuffler_t>(
+                    shufLibHandle,
+                    "createInMemoryObj");
+            std::cout << "Shuffling " << in_memory_partitions.size() << " files in memory ("
+                      << in_memory_bytes << " bytes)" << std::endl;
+            for(auto &file: in_memory_partitions){
+                ShufflerBase* shuffler;
+                if(config.hashAggregation){
+                    auto* nativeShuffler = new NativeShuffler(std::move(file.second));
+                    nativeShuffler->setTokenDictionary(dictionary.get());
+                    if(partitioner){
+                        nativeShuffler->setPartitioning(partitioner, config.reducerCount);
+                    }
+                    shuffler = nativeShuffler;
+                } else if(create_InMemoryShuffler_Obj){
+                    // not poolable - the library's in-memory shuffler is only known through its factory
+                    shuffler = registry.shufflers.adopt(create_InMemoryShuffler_Obj(toMapperPartitions(file.second)), remove_Shuffler_Obj);
+                } else {
+                    shuffler = new InMemoryShuffler(std::move(file.second));
+                }
+                shuffler_objects.push_back([shuffler]{ return shuffler; });
+            }
+            in_memory_partitions.clear();
         }
 
         // declare a vector to store future results of shuffler operations
-        std::vector<std::future<std::vector<std::map<std::string, std::map<std::string,size_t>>>>> shuffler_data;
+        std::vector<std::future<ShuffleResult>> shuffler_data;
         // load the vector with shuffler futures
-        for(auto obj:shuffler_objects){
-            shuffler_mutex.lock();
-            shuffler_data.push_back(std::async(shufflerOps,obj));
-            shuffler_mutex.unlock();
+        for(auto &shuffler:shuffler_objects){
+            shuffler_data.push_back(pool.submit(JobPhase::Shuffle,[shuffler = std::move(shuffler)]{ return shuffleTask(shuffler()); }));
         }
         std::cout << "There are " << shuffler_data.size() << " future objects in shuffler_data vector...." << std::endl;
 
@@ -460,82 +1914,65 @@ void mapReduceWorkflow(const std::string &input_directory) {
                 fpShufOpLibHandle,
                 "./libs/fp/FileProcessorShufOutput.so",
                 "createInputObj");
+        destroy_t* remove_ShufflerFP_Obj = createLibFunc<destroy_t>(
+                fpShufOpLibHandle,
+                "./libs/fp/FileProcessorShufOutput.so",
+                "removeInputObj");
 
         // declare a vector that will hold all fileProcessorShufOutput objects
         std::vector<FileProcessorBase*> fp_shuf_outputs;
         // pass the shuffler output to FileProcessorShufOutput
         for(auto i=0; i < shuffler_data.size(); i++){
-            shuffler_op_mutex.lock();
-            const std::vector<std::map<std::string, std::map<std::string,size_t>>> &shufOutput = shuffler_data[i].get();
-            shuffler_op_mutex.unlock();
-            // supply shufOutput as arguments to FileProcessorShufOutput
-            fp_shuf_outputs.push_back(create_ShufflerFP_Obj("shuffler",shufOutput));
+            ShuffleResult shufOutput = metrics.awaitResult(shuffler_data[i], JobPhase::Shuffle);
+            // supply shufOutput as arguments to FileProcessorShufOutput - hash tables are written by the built-in processor
+            if(shufOutput.hashed){
+                fp_shuf_outputs.push_back(new FileProcessorAggregatedOutput("shuffler",std::move(shufOutput.aggregatedOutput),config.spillFormat,asyncWriter.get()));
+            } else {
+                prepareShuffleOutputDirectories(shufOutput.nestedOutput);
+                fp_shuf_outputs.push_back(registry.fileProcessors.adopt(create_ShufflerFP_Obj("shuffler",shufOutput.nestedOutput), remove_ShufflerFP_Obj));
+            }
         }
         // declare a vector of futures that will host results of shuffler file processor output operations
         std::vector<std::future<std::string>> fp_shuf_output_dirs;
         // run the file processor shuffler output operation....
         // fileProcessShufOutputs will cause the obj to write data to disk and return the directory to fp_shuf_output_dirs
         for(auto obj: fp_shuf_outputs){
-            shuffler_ld_mutex.lock();
-            fp_shuf_output_dirs.push_back(std::async(fileProcessShufOutputs,obj));
-            shuffler_ld_mutex.unlock();
+            fp_shuf_output_dirs.push_back(pool.submit(JobPhase::ShuffleOutput,fileProcessShufOutputs,obj));
+        }
+        // The shuffle-output phase is complete once every writer has reported back through its future
+        std::string shuffler_root_directory;
+        for(auto &fut_shuf: fp_shuf_output_dirs){
+            shuffler_root_directory = metrics.awaitResult(fut_shuf, JobPhase::ShuffleOutput);
+        }
+        if(asyncWriter){
+            metrics.awaitBarrier(JobPhase::ShuffleOutput, [&asyncWriter]{ asyncWriter->flush(JobPhase::ShuffleOutput, false); });
         }
-        // Root shuffler directory
-        std::string shuffler_root_directory = fp_shuf_output_dirs.front().get();
 
-        // track the current shuffler folder count ...
-        int current_shuffler_count = evalFolders(shuffler_root_directory);
+        // single on-disk check now that all writers are done
+        int current_shuffler_count = evalFolders(shuffler_root_directory, plan);
         std::cout << "Current shuffler count " << current_shuffler_count << std::endl;
-
-        // basic check
-        while(og_file_count != current_shuffler_count){
-            current_shuffler_count = evalFolders(shuffler_root_directory);
-        }
-
-        // a more definitive check that recursively checks sub-folders and tries to compare mapper operations
-        bool chk = false;
-        while(!chk){
-            // Map containing input files in directory1
-            std::map<std::string, int> dirShuFiles;
-            // Vector containing files that don't exist
-            std::vector<std::string> filesDontExist;
-            // get a map of all files in mapper directory!
-            for(const auto &sub_directory:std::filesystem::directory_iterator(shuffler_root_directory)){
-                if(std::filesystem::is_directory(sub_directory)){
-                    for(const auto &file:std::filesystem::directory_iterator(sub_directory)){
-                        std::string shuFileName = file.path().string().substr(file.path().string().rfind('/') + 1);
-                        dirShuFiles.insert({shuFileName,1});
-                    }
-                }
-            }
-            // now we will iterate over the mapper directory!
-            for(const auto &sub_directory:std::filesystem::directory_iterator(mapper_root_directory)){
-                if(std::filesystem::is_directory(sub_directory)){
-                    for(const auto &file:std::filesystem::directory_iterator(sub_directory)){
-                        std::string mapFileName = file.path().string().substr(file.path().string().rfind('/') + 1);
-                        // Let's create an iterator against dirMapFiles and see if shuFileName exists there
-                        auto mapItr = dirShuFiles.find(mapFileName);
-                        // Check if iterator was exhausted
-                        if (mapItr == dirShuFiles.end()) {
-                            // if parsedToken was not found! - lets create a entry in filesDontExist vector
-                            filesDontExist.push_back(mapFileName);
-                        }
-                    }
-                }
-            }
-            std::cout << "Files dont exist: " << filesDontExist.size() << std::endl;
-            // now we will check the filesDontExist vector - if its empty - all shuffling is complete
-            if(filesDontExist.empty()){
-                // break out of the loop.
-                chk=true;
-            }
+        // one sub-folder per input file - or one per reducer (part-<r>) when partitioned
+        int expected_shuffler_count = partitioner ? (int)config.reducerCount : og_file_count;
+        if(expected_shuffler_count != current_shuffler_count){
+            throw std::runtime_error("Shuffler output is incomplete in " + shuffler_root_directory);
+        }
+        // every temp_mapper file must have a temp_shuffler counterpart - partitioned output is laid out per reducer instead
+        std::vector<std::string> filesDontExist;
+        if(!mapper_root_directory.empty() && !partitioner){
+            filesDontExist = subFolderFileChecks(mapper_root_directory, shuffler_root_directory, plan);
+        }
+        std::cout << "Files dont exist: " << filesDontExist.size() << std::endl;
+        if(!filesDontExist.empty()){
+            throw std::runtime_error("Shuffler output is missing " + filesDontExist.front());
         }
         std::cout << "All Shuffler output has been written to this root directory - " << shuffler_root_directory << std::endl;
         // declare a vector that will hold the all shuffler folders!
         std::vector<std::string> shuffler_folders;
-        // iterate and load directory_files vector!
+        // iterate and load directory_files vector! - an incremental run leaves the folders of unchanged files alone
         for(const auto &entry:std::filesystem::directory_iterator(shuffler_root_directory)){
-            shuffler_folders.push_back(entry.path());
+            if(plan.includes(entry.path())){
+                shuffler_folders.push_back(entry.path());
+            }
         }
         std::cout << "The individual temp_shuffler folders are: " << std::endl;
         for(const std::string &folder:shuffler_folders){
@@ -549,20 +1986,29 @@ void mapReduceWorkflow(const std::string &input_directory) {
                 redLibHandle,
                 "./libs/reduce/ReducerImpl.so",
                 "createInputObj");
+        registry.reducers.setDestroy(createLibFunc<destroyReducer_t>(
+                redLibHandle,
+                "./libs/reduce/ReducerImpl.so",
+                "removeInputObj"));
         std::cout << "Proceeding to create Reducer objects to operate against temp_shuffler sub-folders..." << std::endl;
-        // declare a vector of shuffler objects
-        std::vector<ReducerBase*> reducer_objects;
-        // load the vector of reducer objects by supplying the individual temp_shuffler folders...
-        for(const std::string &folder:shuffler_folders){
-            reducer_objects.push_back(create_Reducer_Obj(folder));
-        }
         // declare a vector to store future results of reducer operations
-        std::vector<std::future<std::map<std::string, std::map<std::string,size_t>>>> reducer_data;
-        // load the vector with reducer futures
-        for(auto obj:reducer_objects){
-            reducer_mutex.lock();
-            reducer_data.push_back(std::async(reducerOps,obj));
-            reducer_mutex.unlock();
+        std::vector<std::future<ReduceResult>> reducer_data;
+        // with --speculate, a straggling reducer gets a backup - a fresh reducer over the same temp_shuffler folder
+        SpeculativePhase<ReduceResult> reduce_speculation(pool, JobPhase::Reduce, config.speculate);
+        // load the vector with reducer futures - every attempt builds its reducer over its temp_shuffler folder when
+        // it starts, so the library reducers released by finished tasks are reused
+        bool per_file = partitioner && config.perFileOutput;
+        for(const std::string &folder:shuffler_folders){
+            std::function<ReduceResult()> reduce = [folder, per_file, native = config.hashAggregation, create_Reducer_Obj,
+                                                    dictionary = dictionary.get()]{
+                if(!native){
+                    return reduceTask(acquireReducer(create_Reducer_Obj, folder));
+                }
+                auto* reducer = new NativeReducer(folder, per_file);
+                reducer->setTokenDictionary(dictionary);
+                return reduceTask(reducer);
+            };
+            reducer_data.push_back(reduce_speculation.submit(reduce, config.speculate ? reduce : nullptr));
         }
         std::cout << "There are " << reducer_data.size() << " future objects in reducer vector...." << std::endl;
 
@@ -573,15 +2019,39 @@ void mapReduceWorkflow(const std::string &input_directory) {
                 fpRedOpLibHandle,
                 "./libs/fp/FileProcessorRedOutput.so",
                 "createInputObj");
+        destroy_t* remove_ReducerFP_Obj = createLibFunc<destroy_t>(
+                fpRedOpLibHandle,
+                "./libs/fp/FileProcessorRedOutput.so",
+                "removeInputObj");
         // declare a vector that will hold all fileProcessorRedOutput objects
         std::vector<FileProcessorBase*> fp_red_outputs;
+        // per-file output of a partitioned job - every reducer holds a disjoint part of each file's table
+        aggregatedOutput_t per_file_tables;
         // pass the reducer output to FileProcessorRedOutput
         for(auto i=0; i < reducer_data.size(); i++){
-            reducer_op_mutex.lock();
-            const std::map<std::string, std::map<std::string,size_t>> &redOutput = reducer_data[i].get();
-            // supply redOutput as arguments to FileProcessorRedOutput
-            fp_red_outputs.push_back(create_ReducerFP_Obj("reducer",redOutput));
-            reducer_op_mutex.unlock();
+            ReduceResult redOutput = reduce_speculation.await(reducer_data[i], metrics);
+            // supply redOutput as arguments to FileProcessorRedOutput - hash tables are written by the built-in processor
+            if(partitioner && config.perFileOutput){
+                for(AggregatedFile &file: redOutput.aggregatedOutput){
+                    per_file_tables.push_back(std::move(file));
+                }
+            } else if(redOutput.hashed){
+                fp_red_outputs.push_back(new FileProcessorAggregatedOutput("reducer",std::move(redOutput.aggregatedOutput),SpillFormat::Text,asyncWriter.get()));
+            } else {
+                prepareReduceOutputDirectory(config);
+                fp_red_outputs.push_back(registry.fileProcessors.adopt(create_ReducerFP_Obj("reducer",redOutput.nestedOutput), remove_ReducerFP_Obj));
+            }
+        }
+        if(config.speculate){
+            metrics.recordSpeculation(JobPhase::Reduce, reduce_speculation.getBackupsLaunched(), reduce_speculation.getBackupWins());
+            std::cout << "Reduce backups launched - " << reduce_speculation.getBackupsLaunched()
+                      << ", won - " << reduce_speculation.getBackupWins() << std::endl;
+        }
+        // the parts of a file are merged back into one table, written to final_output/<file>
+        for(AggregatedFile &file: mergeAggregatedFiles(std::move(per_file_tables))){
+            aggregatedOutput_t single;
+            single.push_back(std::move(file));
+            fp_red_outputs.push_back(new FileProcessorAggregatedOutput("reducer",std::move(single),SpillFormat::Text,asyncWriter.get()));
         }
         // declare a vector of futures that will host results of reducer file processor output operations
         std::vector<std::future<std::string>> fp_red_output_dirs;
@@ -589,31 +2059,46 @@ void mapReduceWorkflow(const std::string &input_directory) {
         // run the file processor reducer output operation....
         // fileProcessRedOutputs will cause the obj to write data to disk and return the directory to fp_red_output_dirs
         for(auto obj: fp_red_outputs){
-            reducer_ld_mutex.lock();
-            fp_red_output_dirs.push_back(std::async(fileProcessRedOutputs,obj));
-            reducer_ld_mutex.unlock();
+            fp_red_output_dirs.push_back(pool.submit(JobPhase::ReduceOutput,fileProcessRedOutputs,obj));
         }
 
         // declare
         std::string reducerDir;
         // this is to make sure all the reducer operations complete!
         for(auto &fut_red: fp_red_output_dirs){
-            reducerDir = fut_red.get();
+            reducerDir = metrics.awaitResult(fut_red, JobPhase::ReduceOutput);
+            metrics.recordFirstOutput();
+        }
+        // final_output is complete and on the device before SUCCESS.ind is created - temp files are never synced
+        if(asyncWriter){
+            metrics.awaitBarrier(JobPhase::ReduceOutput, [&asyncWriter]{ asyncWriter->flush(JobPhase::ReduceOutput, true); });
         }
 
         // Eventually it will finish...
         std::cout << "All final output has been written to this root directory - " << reducerDir << std::endl;
-        // Vector of files...
-        std::vector<std::string> fileDontExist1to2 = fileDirectoryChecks(input_directory, reducerDir);
-        std::vector<std::string> fileDontExist2to1 = fileDirectoryChecks(reducerDir, input_directory);
-
-        // Create a SUCCESS indicator if filesDontExist vector is empty
-        if(fileDontExist1to2.empty() && fileDontExist2to1.empty()){
-            std::ofstream successFile;
-            successFile.open(reducerDir + "/" + "SUCCESS.ind");
-            successFile.close();
+        // companion indexes - once final_output is complete, before SUCCESS.ind vouches for it
+        if(config.indexOutput){
+            indexFinalOutput(reducerDir, plan, pool, metrics);
+        }
+        metrics.recordJobEnd();
+        // Queue depth and steal counters - used to size the executor
+        pool.printStats(std::cout);
+        // Library objects created against reused
+        registry.printStats(std::cout);
+        // Distinct tokens of the job - with --token-ids
+        printTokenDictionary(dictionary.get());
+        // Time the driver spent waiting on each phase
+        metrics.printWaitTimes(std::cout);
+        // Time, CPU, records, bytes and memory of every phase and task
+        emitJobMetrics(config, pool, metrics);
+        if(partitioner && !config.perFileOutput){
+            createPartitionSuccessIndicator(reducerDir, config.reducerCount);
         } else {
-            throw std::runtime_error("There are missing files!");
+            createSuccessIndicator(input_directory, reducerDir);
+        }
+        // the manifest goes last - it vouches for a complete final_output
+        if(plan.active){
+            plan.manifest.save(reducerDir);
         }
     } catch(std::runtime_error &runtime_error){
         // Exception occurred loading the FileProcessor library!
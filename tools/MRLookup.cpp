@@ -0,0 +1,105 @@
+/*
+ * Description: Token count lookup over the indexes written by MRExec --index-output - maps the index of a
+ * final_output file and answers point and prefix queries without reading the file itself
+ *
+ * Usage: MRLookup <final_output file | index file> [--prefix] [--limit=N] [--time] [--verify] <token>...
+ *     prints one "(token,count)" line per match, in the final_output format
+ *     --prefix   every token is a prefix - all tokens starting with it are printed, in token order
+ *     --limit=N  at most N matches per prefix
+ *     --time     prints the time of every query to stderr
+ *     --verify   checks the final_output file against the hash in the index even if it is older than the index
+ * Exit status: 0 if every query matched, 1 if a query did not, 2 on an error (e.g. a stale index)
+ */
+#include <chrono>
+#include <iostream>
+#include "../headers/OutputIndex.hpp"
+
+// Helper - true if output_path no longer is the final_output file the index was built from
+// A different size is stale. The 64-bit FNV-1a of the contents is only compared when the file was modified after
+// the index was written, or with verify - it reads the whole file, which the size and the timestamps do not.
+bool isStaleIndex(const OutputIndex &index, const std::filesystem::path &output_path,
+                  const std::filesystem::path &index_path, bool verify){
+    std::error_code error;
+    std::uintmax_t outputBytes = std::filesystem::file_size(output_path, error);
+    // only the index is left - there is nothing to compare it with
+    if(error){
+        return false;
+    }
+    if(outputBytes != index.getOutputBytes()){
+        return true;
+    }
+    if(!verify && std::filesystem::last_write_time(output_path) <= std::filesystem::last_write_time(index_path)){
+        return false;
+    }
+    MappedInputFile output(output_path.string());
+    return TokenCountTable::hashToken(output.getContents()) != index.getOutputHash();
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 3){
+        std::cerr << "Usage: MRLookup <final_output file | index file> [--prefix] [--limit=N] [--time] [--verify] <token>..." << std::endl;
+        return 2;
+    }
+    try{
+        bool prefix = false;
+        bool timed = false;
+        bool verify = false;
+        std::size_t limit = 0;
+        std::vector<std::string> queries;
+        for(int i = 2; i < argc; i++){
+            std::string argument = argv[i];
+            if(argument == "--prefix"){
+                prefix = true;
+            } else if(argument == "--time"){
+                timed = true;
+            } else if(argument == "--verify"){
+                verify = true;
+            } else if(argument.rfind("--limit=", 0) == 0){
+                limit = std::stoull(argument.substr(8));
+            } else {
+                queries.push_back(argument);
+            }
+        }
+        // an index file, or the final_output file it belongs to
+        std::filesystem::path path(argv[1]);
+        std::filesystem::path indexPath = path;
+        std::filesystem::path outputPath = path.parent_path().parent_path() / path.stem();
+        if(path.extension() != OUTPUT_INDEX_SUFFIX){
+            indexPath = outputIndexPath(path);
+            outputPath = path;
+        }
+        OutputIndex index(indexPath.string());
+        // a final_output file rewritten without --index-output leaves the old index behind
+        if(isStaleIndex(index, outputPath, indexPath, verify)){
+            std::cerr << "Stale index - " << outputPath.string() << " changed since " << indexPath.string()
+                      << " was built" << std::endl;
+            return 2;
+        }
+        int status = 0;
+        for(const std::string &query: queries){
+            auto start = std::chrono::steady_clock::now();
+            std::vector<OutputIndexEntry> matches;
+            if(prefix){
+                matches = index.findPrefix(query, limit);
+            } else if(auto match = index.find(query)){
+                matches.push_back(*match);
+            }
+            double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            for(const OutputIndexEntry &match: matches){
+                std::cout << '(' << match.token << ',' << match.count << ")\n";
+            }
+            if(matches.empty()){
+                std::cerr << "Not found: " << query << std::endl;
+                status = 1;
+            }
+            if(timed){
+                std::cerr << "Query " << query << " - " << matches.size() << " matches in " << micros << " us" << std::endl;
+            }
+        }
+        std::cout.flush();
+        return status;
+    } catch(std::exception &exception){
+        std::cerr << "Exception occurred: " << exception.what() << std::endl;
+        return 2;
+    }
+}